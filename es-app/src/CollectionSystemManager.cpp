@@ -264,17 +264,14 @@ void CollectionSystemManager::refreshCollectionSystems(FileData* file)
 	if (!file->getSystem()->isGameSystem() || file->getType() != GAME)
 		return;
 
-	std::map<std::string, CollectionSystemData> allCollections;
-	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
-	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
+	for (auto& it : mAutoCollectionSystemsData)
+		updateCollectionSystem(file, it.second);
 
-	for(auto sysDataIt = allCollections.cbegin(); sysDataIt != allCollections.cend(); sysDataIt++)
-	{
-		updateCollectionSystem(file, sysDataIt->second);
-	}
+	for (auto& it : mCustomCollectionSystemsData)
+		updateCollectionSystem(file, it.second);
 }
 
-void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionSystemData sysData)
+void CollectionSystemManager::updateCollectionSystem(FileData* file, const CollectionSystemData& sysData)
 {
 	if (sysData.isPopulated)
 	{
@@ -286,6 +283,7 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 		FolderData* rootFolder = curSys->getRootFolder();
 
 		std::string name = curSys->getName();
+		bool isRecent = (name == "recent");
 
 		if (collectionEntry != nullptr) 
 		{		
@@ -294,47 +292,78 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionS
 			collectionEntry->refreshMetadata();
 			// found and we are removing
 			if (name == "favorites" && file->getMetadata(MetaDataId::Favorite) == "false") {
-				// need to check if still marked as favorite, if not remove
-				ViewController::get()->getGameListView(curSys).get()->remove(collectionEntry, false);
+				// need to check if still marked as favorite, if not remove. A view which isn't loaded is not created for this
+				std::shared_ptr<IGameListView> view = ViewController::get()->getGameListView(curSys, false);
+				if (view != nullptr)
+					view->remove(collectionEntry, false);
+				else
+					delete collectionEntry;
+
+				collectionEntry = nullptr;
 
 				// Send an event when removing from favorites
 				ViewController::get()->onFileChanged(file, FILE_METADATA_CHANGED);
-				ViewController::get()->getGameListView(curSys)->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
 			}
 			else
 			{
 				// re-index with new metadata
 				curSys->addToIndex(collectionEntry);
-				ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
+
+				// The recent list is refreshed once, below
+				if (!isRecent)
+					ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
 			}
 		}
 		else
 		{
 			// we didn't find it here - we need to check if we should add it
-			if (name == "recent" && file->getMetadata(MetaDataId::PlayCount) > "0" && includeFileInAutoCollections(file) ||
+			if (isRecent && file->getMetadata(MetaDataId::PlayCount) > "0" && includeFileInAutoCollections(file) ||
 				name == "favorites" && file->getFavorite()) 
 			{
 				CollectionFileData* newGame = new CollectionFileData(file, curSys);
 				rootFolder->addChild(newGame);
 				curSys->addToIndex(newGame);
+				collectionEntry = newGame;
+
 				ViewController::get()->onFileChanged(file, FILE_METADATA_CHANGED);
-				ViewController::get()->getGameListView(curSys)->onFileChanged(newGame, FILE_METADATA_CHANGED);
+				if (!isRecent)
+					ViewController::get()->onFileChanged(newGame, FILE_METADATA_CHANGED);
 			}
 		}
 
 		curSys->updateDisplayedGameCount();
 
-		if (name == "recent")
+		if (isRecent)
 		{
-			sortLastPlayed(curSys);
+			// The list is kept sorted : only the game which was played moves, then the view repopulates without being reloaded
+			if (collectionEntry != nullptr)
+				moveLastPlayed(rootFolder, collectionEntry);
+
 			trimCollectionCount(rootFolder, LAST_PLAYED_MAX);
-			ViewController::get()->onFileChanged(rootFolder, FILE_METADATA_CHANGED);
+			curSys->invalidateDisplayCache();
 		}
-		else 
-			ViewController::get()->onFileChanged(rootFolder, FILE_SORTED);
+
+		ViewController::get()->onFileChanged(rootFolder, FILE_SORTED);
 	}
 }
 
+void CollectionSystemManager::moveLastPlayed(FolderData* rootFolder, FileData* entry)
+{
+	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(FileSorts::LASTPLAYED_DESCENDING);
+
+	std::vector<FileData*>& childs = (std::vector<FileData*>&) rootFolder->getChildren();
+
+	auto it = std::find(childs.begin(), childs.end(), entry);
+	if (it == childs.end())
+		return;
+
+	childs.erase(it);
+
+	// Most recent first, as sortLastPlayed leaves them : before the first game played earlier
+	auto pos = std::find_if(childs.begin(), childs.end(), [&sort, entry](FileData* other) { return sort.comparisonFunction(other, entry); });
+	childs.insert(pos, entry);
+}
+
 void CollectionSystemManager::sortLastPlayed(SystemData* system)
 {
 	if (system->getName() != "recent")
@@ -373,20 +402,20 @@ void CollectionSystemManager::deleteCollectionFiles(FileData* file)
 	// collection files use the full path as key, to avoid clashes
 	std::string key = file->getFullPath();
 	// find games in collection systems
-	std::map<std::string, CollectionSystemData> allCollections;
-	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
-	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
-
-	for(auto sysDataIt = allCollections.begin(); sysDataIt != allCollections.end(); sysDataIt++)
+	for (auto collections : { &mAutoCollectionSystemsData, &mCustomCollectionSystemsData })
 	{
-		if (sysDataIt->second.isPopulated)
+		for (auto& it : *collections)
 		{
-			FileData* collectionEntry = (sysDataIt->second.system)->getRootFolder()->FindByPath(key);
+			CollectionSystemData& sysData = it.second;
+			if (!sysData.isPopulated)
+				continue;
+
+			FileData* collectionEntry = sysData.system->getRootFolder()->FindByPath(key);
 			if (collectionEntry != nullptr)
 			{
-				sysDataIt->second.needsSave = true;
-				
-				SystemData* systemViewToUpdate = getSystemToView(sysDataIt->second.system);
+				sysData.needsSave = true;
+
+				SystemData* systemViewToUpdate = getSystemToView(sysData.system);
 				ViewController::get()->getGameListView(systemViewToUpdate).get()->remove(collectionEntry, false);
 			}
 		}
@@ -809,9 +838,7 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 		std::vector<PlatformIds::PlatformId> platforms = system->getPlatformIds();
 		bool isArcade = std::find(platforms.begin(), platforms.end(), PlatformIds::ARCADE) != platforms.end();
 
-		std::vector<std::string> hiddenExts;
-		for (auto ext : Utils::String::split(Settings::getInstance()->getString(system->getName() + ".HiddenExt"), ';'))
-			hiddenExts.push_back("." + Utils::String::toLower(ext));
+		std::vector<std::string> hiddenExts = getHiddenExtensions(system);
 
 		std::vector<FileData*> files = system->getRootFolder()->getFilesRecursive(GAME);
 		for(auto& game : files)
@@ -827,63 +854,12 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 					continue;
 			}
 
-			switch(sysDecl.type) 
-			{
-				case AUTO_ALL_GAMES:
-					break;
-				case AUTO_LAST_PLAYED:
-					include = game->getMetadata(MetaDataId::PlayCount) > "0";
-					break;
-				case AUTO_NEVER_PLAYED:
-					include = !(game->getMetadata(MetaDataId::PlayCount) > "0");
-					break;					
-				case AUTO_FAVORITES:
-					// we may still want to add files we don't want in auto collections in "favorites"
-					include = game->getFavorite();
-					break;
-				case AUTO_ARCADE:
-					include = isArcade;
-					break;
-				case AUTO_AT2PLAYERS: // batocera
-				case AUTO_AT4PLAYERS:
-					{
-						std::string players = game->getMetadata(MetaDataId::Players);
-						if (players.empty())
-							include = false;
-						else
-						{
-							int min = -1;
-
-							auto split = players.rfind("+");
-							if (split != std::string::npos)
-								players = Utils::String::replace(players, "+", "-999");
-
-							split = players.rfind("-");
-							if (split != std::string::npos)
-							{
-								min = atoi(players.substr(0, split).c_str());
-								players = players.substr(split + 1);
-							}
-
-							int max = atoi(players.c_str());
-							int val = (sysDecl.type == AUTO_AT2PLAYERS ? 2 : 4);
-							include = min <= 0 ? (val == max) : (min <= val && val <= max);
-						}
-					}
-					break;
-				default:
-					if (!sysDecl.isCustom && !sysDecl.displayIfEmpty)
-						include = isArcade && game->getMetadata(MetaDataId::ArcadeSystemName) == sysDecl.themeFolder;
+			if (!isInAutoCollection(game, sysDecl, isArcade))
+				continue;
 
-					break;				
-			}
-							    
-			if (include) 
-			{
-				CollectionFileData* newGame = new CollectionFileData(game, newSys);
-				rootFolder->addChild(newGame);
-				newSys->addToIndex(newGame);
-			}			
+			CollectionFileData* newGame = new CollectionFileData(game, newSys);
+			rootFolder->addChild(newGame);
+			newSys->addToIndex(newGame);
 		}
 	}
 
@@ -896,6 +872,112 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 	sysData->isPopulated = true;
 }
 
+bool CollectionSystemManager::isInAutoCollection(FileData* game, const CollectionSystemDecl& sysDecl, bool isArcade)
+{
+	bool include = true;
+
+	switch(sysDecl.type) 
+	{
+		case AUTO_ALL_GAMES:
+			break;
+		case AUTO_LAST_PLAYED:
+			include = game->getMetadata(MetaDataId::PlayCount) > "0";
+			break;
+		case AUTO_NEVER_PLAYED:
+			include = !(game->getMetadata(MetaDataId::PlayCount) > "0");
+			break;					
+		case AUTO_FAVORITES:
+			// we may still want to add files we don't want in auto collections in "favorites"
+			include = game->getFavorite();
+			break;
+		case AUTO_ARCADE:
+			include = isArcade;
+			break;
+		case AUTO_AT2PLAYERS: // batocera
+		case AUTO_AT4PLAYERS:
+			{
+				std::string players = game->getMetadata(MetaDataId::Players);
+				if (players.empty())
+					include = false;
+				else
+				{
+					int min = -1;
+
+					auto split = players.rfind("+");
+					if (split != std::string::npos)
+						players = Utils::String::replace(players, "+", "-999");
+
+					split = players.rfind("-");
+					if (split != std::string::npos)
+					{
+						min = atoi(players.substr(0, split).c_str());
+						players = players.substr(split + 1);
+					}
+
+					int max = atoi(players.c_str());
+					int val = (sysDecl.type == AUTO_AT2PLAYERS ? 2 : 4);
+					include = min <= 0 ? (val == max) : (min <= val && val <= max);
+				}
+			}
+			break;
+		default:
+			if (!sysDecl.isCustom && !sysDecl.displayIfEmpty)
+				include = isArcade && game->getMetadata(MetaDataId::ArcadeSystemName) == sysDecl.themeFolder;
+
+			break;				
+	}
+
+	return include;
+}
+
+std::vector<std::string> CollectionSystemManager::getHiddenExtensions(SystemData* system)
+{
+	std::vector<std::string> hiddenExts;
+	for (auto ext : Utils::String::split(system->getHiddenExtensions(), ';'))
+		hiddenExts.push_back("." + Utils::String::toLower(ext));
+
+	return hiddenExts;
+}
+
+void CollectionSystemManager::addToAutoCollections(FileData* file)
+{
+	SystemData* system = file->getSystem();
+	if (!system->isGameSystem() || system->isCollection() || file->getType() != GAME || !includeFileInAutoCollections(file))
+		return;
+
+	std::vector<std::string> hiddenExts = getHiddenExtensions(system);
+	if (hiddenExts.size() > 0)
+	{
+		std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension(file->getFileName()));
+		if (std::find(hiddenExts.cbegin(), hiddenExts.cend(), extlow) != hiddenExts.cend())
+			return;
+	}
+
+	bool isArcade = system->hasPlatformId(PlatformIds::ARCADE);
+
+	for (auto& it : mAutoCollectionSystemsData)
+	{
+		CollectionSystemData& sysData = it.second;
+		if (!sysData.isPopulated || !isInAutoCollection(file, sysData.decl, isArcade))
+			continue;
+
+		SystemData* curSys = sysData.system;
+
+		CollectionFileData* newGame = new CollectionFileData(file, curSys);
+		curSys->getRootFolder()->addChild(newGame);
+		curSys->addToIndex(newGame);
+		curSys->updateDisplayedGameCount();
+
+		if (sysData.decl.type == AUTO_LAST_PLAYED)
+		{
+			sortLastPlayed(curSys);
+			trimCollectionCount(curSys->getRootFolder(), LAST_PLAYED_MAX);
+		}
+
+		ViewController::get()->onFileChanged(curSys->getRootFolder(), FILE_ADDED);
+	}
+}
+
 // populates a Custom Collection System
 void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData, std::unordered_map<std::string, FileData*>* pMap)
 {
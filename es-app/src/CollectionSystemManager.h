@@ -67,9 +67,12 @@ public:
 	void updateSystemsList();
 
 	void refreshCollectionSystems(FileData* file);
-	void updateCollectionSystem(FileData* file, CollectionSystemData sysData);
+	void updateCollectionSystem(FileData* file, const CollectionSystemData& sysData);
 	void deleteCollectionFiles(FileData* file);
 
+	// Adds a game found after the collections were populated ( RomWatcher )
+	void addToAutoCollections(FileData* file);
+
 	inline std::map<std::string, CollectionSystemData>& getAutoCollectionSystems() { return mAutoCollectionSystemsData; };
 	inline std::map<std::string, CollectionSystemData> getCustomCollectionSystems() { return mCustomCollectionSystemsData; };
 	inline SystemData* getCustomCollectionsBundle() { return mCustomCollectionsBundle; };
@@ -127,11 +130,14 @@ private:
 	std::vector<std::string> getUserCollectionThemeFolders();
 
 	void trimCollectionCount(FolderData* rootFolder, int limit);
+	void moveLastPlayed(FolderData* rootFolder, FileData* entry);
 	void sortLastPlayed(SystemData* system);
 
 	bool themeFolderExists(std::string folder);
 
 	bool includeFileInAutoCollections(FileData* file);
+	bool isInAutoCollection(FileData* game, const CollectionSystemDecl& sysDecl, bool isArcade);
+	std::vector<std::string> getHiddenExtensions(SystemData* system);
 
 	SystemData* mCustomCollectionsBundle;
 };
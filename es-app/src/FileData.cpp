@@ -26,7 +26,7 @@
 #include "LangParser.h"
 
 FileData::FileData(FileType type, const std::string& path, SystemData* system)
-	: mType(type), mSystem(system), mParent(NULL), mMetadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: mType(type), mInGamelist(false), mSystem(system), mParent(NULL), mMetadataGeneration(0), mMetadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
 	mPath = Utils::FileSystem::createRelativePath(path, getSystemEnvData()->mStartPath, false);
 	
@@ -35,7 +35,7 @@ FileData::FileData(FileType type, const std::string& path, SystemData* system)
 		mMetadata.set("name", getDisplayName());
 	
 	mMetadata.resetChangedFlag();
-
+	mMetadata.setOwner(this);
 }
 
 const std::string FileData::getPath() const
@@ -97,6 +97,21 @@ FileData::~FileData()
 
 	if(mType == GAME)
 		mSystem->removeFromIndex(this);	
+
+	if (mMetadata.wasChanged())
+		mSystem->setDirtyFile(this, false);
+}
+
+void FileData::onMetadataChanged(bool changed)
+{
+	if (mSystem != nullptr)
+		mSystem->setDirtyFile(this, changed);
+}
+
+void FileData::onMetadataValueChanged()
+{
+	if (mSystem != nullptr)
+		mMetadataGeneration = mSystem->onMetadataValueChanged();
 }
 
 std::string FileData::getDisplayName() const
@@ -179,20 +194,11 @@ const bool FileData::getKidGame()
 	return data != "false" && !data.empty();
 }
 
-static std::shared_ptr<bool> showFilenames;
-
-void FileData::resetSettings() 
-{
-	showFilenames = nullptr;
-}
-
 const std::string FileData::getName()
 {
-	if (showFilenames == nullptr)
-		showFilenames = std::make_shared<bool>(Settings::getInstance()->getBool("ShowFilenames"));
+	static Settings::Key showFilenames("ShowFilenames");
 
-	// Faster than accessing map each time
-	if (*showFilenames)
+	if (Settings::getInstance()->getBool(showFilenames))
 	{
 		if (mSystem != nullptr && !mSystem->hasPlatformId(PlatformIds::ARCADE) && !mSystem->hasPlatformId(PlatformIds::NEOGEO))
 			return Utils::FileSystem::getStem(getPath());
@@ -502,30 +508,35 @@ const std::string CollectionFileData::getName()
 		mDirty = false;
 	}
 
-	if (Settings::getInstance()->getBool("CollectionShowSystemInfo"))
+	static Settings::Key collectionShowSystemInfo("CollectionShowSystemInfo");
+
+	if (Settings::getInstance()->getBool(collectionShowSystemInfo))
 		return mCollectionFileName;
 		
 	return Utils::String::removeParenthesis(mSourceFileData->getMetadata(MetaDataId::Name));
 }
 
+std::atomic<unsigned int> FolderData::sDisplayGeneration(1);
+
 const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
 {
 	std::vector<FileData*> ret;
 
-	std::string showFoldersMode = Settings::getInstance()->getString("FolderViewMode");
+	static Settings::Key folderViewModeSetting("FolderViewMode");
+	static Settings::Key forceDisableFiltersSetting("ForceDisableFilters");
+	static Settings::Key showFilenamesSetting("ShowFilenames");
+	static Settings::Key collectionShowSystemInfoSetting("CollectionShowSystemInfo");
 
-	auto fvm = Settings::getInstance()->getString(getSystem()->getName() + ".FolderViewMode");
+	std::string showFoldersMode = Settings::getInstance()->getString(folderViewModeSetting);
+
+	auto fvm = getSystem()->getFolderViewModeOverride();
 	if (!fvm.empty() && fvm != "auto") showFoldersMode = fvm;
 	
-	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles");
-
-	auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
-	if (shv == "1") showHiddenFiles = true;
-	else if (shv == "0") showHiddenFiles = false;
+	bool showHiddenFiles = getSystem()->getShowHiddenFiles();
 
 	bool filterKidGame = false;
 
-	if (!Settings::getInstance()->getBool("ForceDisableFilters"))
+	if (!Settings::getInstance()->getBool(forceDisableFiltersSetting))
 	{
 		if (UIModeController::getInstance()->isUIModeKiosk())
 			showHiddenFiles = false;
@@ -536,15 +547,51 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 
 	auto sys = CollectionSystemManager::get()->getSystemToView(mSystem);
 
+	std::string hiddenExtensions = mSystem->getHiddenExtensions();
+
 	std::vector<std::string> hiddenExts;
 	if (!mSystem->isGroupSystem() && !mSystem->isCollection())
-		for (auto ext : Utils::String::split(Settings::getInstance()->getString(mSystem->getName() + ".HiddenExt"), ';'))	
+		for (auto ext : Utils::String::split(hiddenExtensions, ';'))	
 			hiddenExts.push_back("." + Utils::String::toLower(ext));
 	
 	FileFilterIndex* idx = sys->getIndex(false);
 	if (idx != nullptr && !idx->isFiltered())
 		idx = nullptr;
 
+	unsigned int currentSortId = sys->getSortId();
+	if (currentSortId > FileSorts::getSortTypes().size())
+		currentSortId = 0;
+
+	// Reuse the list computed for the same display settings, as long as no file of the systems was added, removed or changed
+	// Most settings writes ( the sort of a system... ) change nothing in the lists : the name flags are read again only when the settings changed
+	unsigned int settingsGeneration = Settings::getInstance()->getGeneration();
+	if (mDisplayCacheSettings != settingsGeneration)
+	{
+		mDisplayCacheSettings = settingsGeneration;
+		mDisplayCacheNames = (Settings::getInstance()->getBool(showFilenamesSetting) ? 1 : 0) | (Settings::getInstance()->getBool(collectionShowSystemInfoSetting) ? 2 : 0);
+	}
+
+	DisplayCacheStamp stamp;
+	stamp.global = sDisplayGeneration;
+	stamp.system = mSystem->getDisplayGeneration();
+	stamp.view = sys->getDisplayGeneration();
+	stamp.names = mDisplayCacheNames;
+
+	if (mDisplayCacheStamp != stamp)
+	{
+		mDisplayCache.clear();
+		mDisplayCacheStamp = stamp;
+	}
+
+	std::string cacheKey = std::to_string(currentSortId) + "|" + showFoldersMode + "|" + 
+		(showHiddenFiles ? "1" : "0") + (filterKidGame ? "1" : "0") + "|" +
+		hiddenExtensions + "|" +
+		std::to_string((size_t)sys) + "|" + (idx == nullptr ? "" : std::to_string((size_t)idx) + ":" + std::to_string(idx->getFilterGeneration()));
+
+	auto cached = mDisplayCache.find(cacheKey);
+	if (cached != mDisplayCache.cend())
+		return cached->second;
+
 	std::vector<FileData*>* items = &mChildren;
 	
 	std::vector<FileData*> flatGameList;
@@ -598,16 +645,10 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 		ret.push_back(*it);
 	}
 
-	unsigned int currentSortId = sys->getSortId();
-	if (currentSortId > FileSorts::getSortTypes().size())
-		currentSortId = 0;
-
 	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(currentSortId);
-	std::sort(ret.begin(), ret.end(), sort.comparisonFunction);
-
-	if (!sort.ascending)
-		std::reverse(ret.begin(), ret.end());
+	FileSorts::sortFiles(ret, sort.id, sort.ascending);
 
+	mDisplayCache[cacheKey] = ret;
 	return ret;
 }
 
@@ -633,9 +674,11 @@ std::vector<FileData*> FolderData::getFilesRecursive(unsigned int typeMask, bool
 {
 	std::vector<FileData*> out;
 
-	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles") && !UIModeController::getInstance()->isUIModeKiosk();
+	static Settings::Key showHiddenFilesSetting("ShowHiddenFiles");
+
+	bool showHiddenFiles = Settings::getInstance()->getBool(showHiddenFilesSetting) && !UIModeController::getInstance()->isUIModeKiosk();
 
-	auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
+	auto shv = getSystem()->getShowHiddenFilesOverride();
 	if (shv == "1") showHiddenFiles = true;
 	else if (shv == "0") showHiddenFiles = false;
 
@@ -684,19 +727,50 @@ void FolderData::addChild(FileData* file, bool assignParent)
 
 	if (assignParent)
 		file->setParent(this);	
+
+	if (mPathIndex != nullptr)
+	{
+		mPathIndex->emplace(file->getPath(), file);
+		if (file->getType() == FOLDER)
+			mPathIndexFolders++;
+	}
+
+	mSystem->invalidateDisplayCache();
 }
 
 void FolderData::removeChild(FileData* file)
 {
 	assert(mType == FOLDER);
-	assert(file->getParent() == this);
+	assert(file->getParent() == this || !mOwnsChildrens);
 
-	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	// From the end : the last children added are the ones removed the most ( collections trimmed, games deleted in order )
+	for (auto it = mChildren.crbegin(); it != mChildren.crend(); it++)
 	{
 		if (*it == file)
 		{
-			file->setParent(NULL);
-			mChildren.erase(it);
+			// Virtual folders ( grouped systems ) only reference the children of another folder
+			if (mOwnsChildrens)
+				file->setParent(NULL);
+
+			mChildren.erase(std::next(it).base());
+
+			if (mPathIndex != nullptr)
+			{
+				auto range = mPathIndex->equal_range(file->getPath());
+				for (auto idx = range.first; idx != range.second; idx++)
+				{
+					if (idx->second == file)
+					{
+						mPathIndex->erase(idx);
+						break;
+					}
+				}
+
+				if (file->getType() == FOLDER)
+					mPathIndexFolders--;
+			}
+
+			mSystem->invalidateDisplayCache();
 			return;
 		}
 	}
@@ -708,17 +782,44 @@ void FolderData::removeChild(FileData* file)
 
 FileData* FolderData::FindByPath(const std::string& path)
 {
-	std::vector<FileData*> children = getChildren();
+	if (mPathIndex == nullptr)
+	{
+		mPathIndex.reset(new std::unordered_multimap<std::string, FileData*>());
+		mPathIndex->reserve(mChildren.size());
+		mPathIndexFolders = 0;
 
-	for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
+		for (auto child : mChildren)
+		{
+			mPathIndex->emplace(child->getPath(), child);
+			if (child->getType() == FOLDER)
+				mPathIndexFolders++;
+		}
+	}
+
+	auto range = mPathIndex->equal_range(path);
+	if (range.first != range.second)
 	{
-		if ((*it)->getPath() == path)
-			return (*it);
+		// Several children with this path : the first one in the list, as a search of the children would find
+		if (std::next(range.first) != range.second)
+		{
+			for (auto child : mChildren)
+				if (child->getPath() == path)
+					return child;
+		}
+
+		return range.first->second;
+	}
 
-		if ((*it)->getType() != FOLDER)
+	// Collections are flat : don't scan the children when there's no folder
+	if (mPathIndexFolders == 0)
+		return nullptr;
+
+	for (auto child : mChildren)
+	{
+		if (child->getType() != FOLDER)
 			continue;
-		
-		auto item = ((FolderData*)(*it))->FindByPath(path);
+
+		auto item = ((FolderData*)child)->FindByPath(path);
 		if (item != nullptr)
 			return item;
 	}
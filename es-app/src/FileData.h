@@ -4,6 +4,9 @@
 
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
+#include <atomic>
+#include <map>
+#include <memory>
 #include <unordered_map>
 
 class SystemData;
@@ -104,8 +107,6 @@ public:
 
 	void launchGame(Window* window, LaunchGameOptions options = LaunchGameOptions());
 
-	static void resetSettings();
-	
 	virtual const MetaDataList& getMetadata() const { return mMetadata; }
 	virtual MetaDataList& getMetadata() { return mMetadata; }
 
@@ -115,15 +116,29 @@ public:
 	//std::string getMetadata(const std::string& key) { return getMetadata().get(key); }
 	void setMetadata(const std::string& key, const std::string& value) { getMetadata().set(key, value); }
 
+	// Called by mMetadata when its changed flag is set or reset
+	void onMetadataChanged(bool changed);
+	// Called by mMetadata each time a value is modified
+	void onMetadataValueChanged();
+
+	// Metadata generation of the system when the metadata of this file last changed
+	inline unsigned int getMetadataGeneration() const { return mMetadataGeneration; }
+
 	void detectLanguageAndRegion(bool overWrite);
 
+	// Has a node in gamelist.xml, set by parseGamelist & updateGamelist
+	inline bool isInGamelist() const { return mInGamelist; }
+	inline void setInGamelist(bool value) { mInGamelist = value; }
+
 private:
 	MetaDataList mMetadata;
+	unsigned int mMetadataGeneration;
 
 protected:	
 	FolderData* mParent;
 	std::string mPath;
 	FileType mType;
+	bool mInGamelist;
 	SystemData* mSystem;
 };
 
@@ -162,6 +177,9 @@ public:
 	{
 		mIsDisplayableAsVirtualFolder = false;
 		mOwnsChildrens = ownsChildrens;
+		mDisplayCacheSettings = (unsigned int)-1;
+		mDisplayCacheNames = 0;
+		mPathIndexFolders = 0;
 	}
 
 	~FolderData()
@@ -194,19 +212,60 @@ public:
 	{
 		if (mOwnsChildrens)
 		{
+			// Detached first : each removeChild would search the children, which is quadratic for big systems
+			for (auto child : mChildren)
+				child->setParent(nullptr);
+
 			for (int i = mChildren.size() - 1; i >= 0; i--)
 				delete mChildren.at(i);
 		}
 
 		mChildren.clear();
+		mPathIndex.reset();
 	}	
 
 	void removeVirtualFolders();
 
+	// Drops the lists cached by getChildrenListToDisplay in every folder, when a system or a filter index is deleted : the cache keys contain their addresses.
+	// File changes only drop the lists of their system, see SystemData::invalidateDisplayCache
+	static void invalidateDisplayCache() { sDisplayGeneration++; }
+
 private:
 	std::vector<FileData*> mChildren;
 	bool	mOwnsChildrens;
 	bool	mIsDisplayableAsVirtualFolder;
+
+	// Sorted & filtered children, by display settings ( sort id, filter generation, folder view mode... )
+	std::map<std::string, std::vector<FileData*>> mDisplayCache;
+
+	// What the cached lists were computed from : they are dropped when one of these changes
+	struct DisplayCacheStamp
+	{
+		DisplayCacheStamp() : global(0), system(0), view(0), names(0) { }
+
+		bool operator!=(const DisplayCacheStamp& other) const
+		{
+			return global != other.global || system != other.system || view != other.view || names != other.names;
+		}
+
+		unsigned int global;
+		unsigned int system;	// display generation of the folder's system
+		unsigned int view;		// of the system it is shown in ( group, collection )
+		unsigned int names;		// ShowFilenames & CollectionShowSystemInfo, they change getName
+	};
+
+	DisplayCacheStamp mDisplayCacheStamp;
+
+	// Settings generation the names flags were read at
+	unsigned int mDisplayCacheSettings;
+	unsigned int mDisplayCacheNames;
+
+	// Children by path, built by the first FindByPath, then updated by addChild & removeChild.
+	// A multimap : custom collections and virtual folders may hold several children with the same path
+	std::unique_ptr<std::unordered_multimap<std::string, FileData*>> mPathIndex;
+	int mPathIndexFolders; // Children searched recursively by FindByPath
+
+	static std::atomic<unsigned int> sDisplayGeneration;
 };
 
 #endif // ES_APP_FILE_DATA_H
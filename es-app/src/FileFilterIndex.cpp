@@ -6,6 +6,7 @@
 #include "Log.h"
 #include "Settings.h"
 #include "LocaleES.h"
+#include <algorithm>
 
 #include <pugixml/src/pugixml.hpp>
 
@@ -17,7 +18,8 @@
 #define INCLUDE_UNKNOWN false;
 
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false)
+	: filterByFavorites(false), filterByGenre(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), mFilterGeneration(0),
+	mGameNamesSettings((unsigned int)-1), mGameNamesShowFilenames(false), mFilteredGamesGeneration(0), mFilteredGamesValid(false)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = 
@@ -44,6 +46,9 @@ FileFilterIndex::FileFilterIndex()
 FileFilterIndex::~FileFilterIndex()
 {
 	resetIndex();
+
+	// The display lists are keyed by the address of the index, which can be reused by the next one
+	FolderData::invalidateDisplayCache();
 }
 
 std::vector<FilterDataDecl> FileFilterIndex::getFilterDataDecls()
@@ -108,6 +113,15 @@ void FileFilterIndex::resetIndex()
 	clearIndex(langIndexAllKeys);
 	clearIndex(regionIndexAllKeys);
 
+	mGames.clear();
+	mFreeIds.clear();
+	mGameIds.clear();
+	mGameNames.clear();
+	mGameKeys.clear();
+	mGameSystems.clear();
+	mFilteredGames.clear();
+	mFilteredGamesValid = false;
+
 	manageIndexEntry(&favoritesIndexAllKeys, "FALSE", false);
 	manageIndexEntry(&favoritesIndexAllKeys, "TRUE", false);
 
@@ -225,6 +239,19 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 
 void FileFilterIndex::addToIndex(FileData* game)
 {
+	// The metadata of the games are owned by the system of their source file, a collection game changes with it
+	SystemData* system = game->getSourceFileData()->getSystem();
+
+	auto gameSystem = mGameSystems.find(system);
+	if (gameSystem == mGameSystems.cend())
+	{
+		gameSystem = mGameSystems.insert(std::make_pair(system, GameSystem())).first;
+		gameSystem->second.generation = system->getMetadataGeneration();
+	}
+
+	// Only the metadata of this game can change here ( language & region ) : if the keys of its system were up to date, they still are once it's indexed
+	bool keysUpToDate = (gameSystem->second.generation == system->getMetadataGeneration());
+
 	game->detectLanguageAndRegion(false);
 
 	manageGenreEntryInIndex(game);
@@ -233,6 +260,44 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageRatingsEntryInIndex(game);
 	manageLangEntryInIndex(game);
 	manageRegionEntryInIndex(game);	
+
+	unsigned int id;
+
+	auto it = mGameIds.find(game);
+	if (it != mGameIds.cend())
+	{
+		id = it->second;
+		unindexGameKeys(game, id);
+	}
+	else if (mFreeIds.size() > 0)
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+		mGames[id] = game;
+		mGameIds[game] = id;
+		gameSystem->second.games++;
+	}
+	else
+	{
+		id = (unsigned int)mGames.size();
+		mGames.push_back(game);
+		mGameIds[game] = id;
+		gameSystem->second.games++;
+	}
+
+	indexGameKeys(game, id);
+
+	if (keysUpToDate)
+		gameSystem->second.generation = system->getMetadataGeneration();
+
+	// Keep the evaluated filters valid, so that adding games one by one doesn't trigger a full evaluation each time
+	if (mFilteredGamesValid)
+	{
+		if (isGameMatching(game))
+			mFilteredGames.set(id);
+		else
+			mFilteredGames.reset(id);
+	}
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
@@ -243,10 +308,28 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageRatingsEntryInIndex(game, true);
 	manageLangEntryInIndex(game, true);
 	manageRegionEntryInIndex(game, true);
+
+	auto it = mGameIds.find(game);
+	if (it == mGameIds.cend())
+		return;
+
+	unsigned int id = it->second;
+	unindexGameKeys(game, id);
+
+	mGames[id] = nullptr;
+	mGameIds.erase(it);
+	mFreeIds.push_back(id);
+	mFilteredGames.reset(id);
+
+	auto gameSystem = mGameSystems.find(game->getSourceFileData()->getSystem());
+	if (gameSystem != mGameSystems.cend() && --gameSystem->second.games == 0)
+		mGameSystems.erase(gameSystem);
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
 {
+	mFilterGeneration++;
+
 	// test if it exists before setting
 	if(type == NONE)
 	{
@@ -272,6 +355,8 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	mFilterGeneration++;
+
 	for (auto& it : mFilterDecl)
 	{
 		FilterDataDecl& filterData = it.second;
@@ -303,6 +388,7 @@ void FileFilterIndex::setUIModeFilters()
 void FileFilterIndex::setTextFilter(const std::string text) 
 { 
 	mTextFilter = Utils::String::toUpper(text);
+	mFilterGeneration++;
 }
 
 bool FileFilterIndex::showFile(FileData* game)
@@ -325,52 +411,300 @@ bool FileFilterIndex::showFile(FileData* game)
 		return false;
 	}
 
-	bool keepGoing = false;
+	auto it = mGameIds.find(game);
+	if (it != mGameIds.cend())
+	{
+		updateFilteredGames();
+		return mFilteredGames.test(it->second);
+	}
+
+	// Not indexed here : evaluate the filters on the metadata of the game
+	return isGameMatching(game);
+}
+
+void FileFilterIndex::getFilterKeys(FileData* game, FilterIndexType type, std::vector<std::string>& keys)
+{
+	auto decl = mFilterDecl.find(type);
+	if (decl == mFilterDecl.cend())
+		return;
+
+	std::string key = getIndexableKey(game, type, false);
+	if (type == LANG_FILTER || type == REGION_FILTER)
+	{
+		for (auto val : Utils::String::split(key, ','))
+			keys.push_back(val);
+	}
+	else
+		keys.push_back(key);
+
+	// secondary keys - i.e. publisher and dev, or first genre
+	if (decl->second.hasSecondaryKey)
+	{
+		std::string secKey = getIndexableKey(game, type, true);
+		if (secKey != UNKNOWN_LABEL)
+			keys.push_back(secKey);
+	}
+}
 
-	if (!mTextFilter.empty() && Utils::String::toUpper(game->getName()).find(mTextFilter) != std::string::npos)
-		keepGoing = true;
+bool FileFilterIndex::isGameMatching(FileData* game)
+{
+	if (!mTextFilter.empty() && Utils::String::toUpper(game->getName()).find(mTextFilter) == std::string::npos)
+		return false;
 
-	bool hasFilter = false;
+	std::vector<std::string> keys;
 
 	for (auto& it : mFilterDecl)
 	{
 		FilterDataDecl& filterData = it.second;
 		if (!(*(filterData.filteredByRef)))
 			continue;
-		
-		hasFilter = true;
 
-		// try to find a match
-		std::string key = getIndexableKey(game, filterData.type, false);
-		if (filterData.type == LANG_FILTER || filterData.type == REGION_FILTER)
+		keys.clear();
+		getFilterKeys(game, filterData.type, keys);
+
+		bool found = false;
+		for (auto key : keys)
 		{
-			for (auto val : Utils::String::split(key, ','))
-				if (isKeyBeingFilteredBy(val, filterData.type))
-					keepGoing = true;
+			if (filterData.currentFilteredKeys->find(key) != filterData.currentFilteredKeys->cend())
+			{
+				found = true;
+				break;
+			}
 		}
-		else
-			keepGoing = isKeyBeingFilteredBy(key, filterData.type);
 
-		// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-		if (!keepGoing)
+		if (!found)
+			return false;
+	}
+
+	return true;
+}
+
+void FileFilterIndex::indexGameKeys(FileData* game, unsigned int id)
+{
+	std::vector<std::string> keys;
+
+	for (auto& it : mFilterDecl)
+	{
+		keys.clear();
+		getFilterKeys(game, it.second.type, keys);
+
+		auto& typeKeys = mGameKeys[it.first];
+		for (auto key : keys)
 		{
-			if (!filterData.hasSecondaryKey)
-				return false;
+			auto& games = typeKeys[key];
+			if (games.size() == 0 || games.back() != id)
+				games.push_back(id);
+		}
+	}
+
+	if (mGameNames.size() > 0)
+	{
+		if (id >= mGameNames.size())
+			mGameNames.resize(id + 1);
+
+		mGameNames[id] = Utils::String::toUpper(game->getName());
+	}
+}
+
+void FileFilterIndex::unindexGameKeys(FileData* game, unsigned int id)
+{
+	// Changed since it was indexed : its keys can't be computed from its metadata anymore, look for its id everywhere
+	FileData* source = game->getSourceFileData();
+
+	auto gameSystem = mGameSystems.find(source->getSystem());
+	if (gameSystem == mGameSystems.cend() || source->getMetadataGeneration() > gameSystem->second.generation)
+	{
+		GameBitset ids;
+		ids.set(id);
+		removeGameKeys(ids);
+		return;
+	}
 
-			std::string secKey = getIndexableKey(game, filterData.type, true);
-			if (secKey != UNKNOWN_LABEL)
-				keepGoing = isKeyBeingFilteredBy(secKey, filterData.type);
+	std::vector<std::string> keys;
+
+	for (auto& it : mFilterDecl)
+	{
+		keys.clear();
+		getFilterKeys(game, it.second.type, keys);
+
+		auto& typeKeys = mGameKeys[it.first];
+		for (auto key : keys)
+		{
+			auto games = typeKeys.find(key);
+			if (games == typeKeys.cend())
+				continue;
+
+			auto& ids = games->second;
+			auto pos = std::find(ids.begin(), ids.end(), id);
+			if (pos == ids.end())
+				continue;
+
+			*pos = ids.back();
+			ids.pop_back();
+
+			if (ids.size() == 0)
+				typeKeys.erase(games);
 		}
+	}
+}
+
+void FileFilterIndex::rebuildGameKeys()
+{
+	// Read before indexing : a change made meanwhile leaves the keys stale
+	for (auto& it : mGameSystems)
+		it.second.generation = it.first->getMetadataGeneration();
+
+	mGameKeys.clear();
+	mGameNames.clear();
+
+	for (unsigned int id = 0; id < mGames.size(); id++)
+		if (mGames[id] != nullptr)
+			indexGameKeys(mGames[id], id);
+
+	mFilteredGamesValid = false;
+}
 
-		// if still nothing, then it's not a match
-		if (!keepGoing)
-			return false;		
+void FileFilterIndex::removeGameKeys(const GameBitset& ids)
+{
+	for (auto& typeKeys : mGameKeys)
+	{
+		for (auto games = typeKeys.second.begin(); games != typeKeys.second.end(); )
+		{
+			auto& list = games->second;
+			list.erase(std::remove_if(list.begin(), list.end(), [&ids](unsigned int id) { return ids.test(id); }), list.end());
+
+			if (list.size() == 0)
+				games = typeKeys.second.erase(games);
+			else
+				games++;
+		}
 	}
+}
 
-	if (mTextFilter.empty() && !hasFilter)
-		return true;
+void FileFilterIndex::updateChangedGames()
+{
+	// Systems having games changed since the keys were indexed, with the generation the keys were up to date with
+	std::unordered_map<SystemData*, unsigned int> changedSystems;
+
+	for (auto& it : mGameSystems)
+	{
+		unsigned int generation = it.first->getMetadataGeneration();
+		if (it.second.generation != generation)
+		{
+			changedSystems[it.first] = it.second.generation;
+			it.second.generation = generation;
+		}
+	}
+
+	if (changedSystems.size() == 0)
+		return;
+
+	GameBitset changedIds;
+	std::vector<unsigned int> changed;
+
+	for (unsigned int id = 0; id < mGames.size(); id++)
+	{
+		if (mGames[id] == nullptr)
+			continue;
+
+		FileData* source = mGames[id]->getSourceFileData();
+
+		auto system = changedSystems.find(source->getSystem());
+		if (system != changedSystems.cend() && source->getMetadataGeneration() > system->second)
+		{
+			changedIds.set(id);
+			changed.push_back(id);
+		}
+	}
+
+	// A scrape or a gamelist reload changed most of them
+	if (changed.size() > mGameIds.size() / 4)
+	{
+		rebuildGameKeys();
+		return;
+	}
+
+	removeGameKeys(changedIds);
 
-	return keepGoing;
+	for (auto id : changed)
+	{
+		indexGameKeys(mGames[id], id);
+
+		if (mFilteredGamesValid)
+		{
+			if (isGameMatching(mGames[id]))
+				mFilteredGames.set(id);
+			else
+				mFilteredGames.reset(id);
+		}
+	}
+}
+
+void FileFilterIndex::updateFilteredGames()
+{
+	// Index again the games whose metadata was modified since their keys were indexed
+	updateChangedGames();
+
+	// The names of the text filter depend on ShowFilenames, read again only when the settings changed
+	unsigned int settingsGeneration = Settings::getInstance()->getGeneration();
+	if (mGameNamesSettings != settingsGeneration)
+	{
+		static Settings::Key showFilenamesSetting("ShowFilenames");
+
+		bool showFilenames = Settings::getInstance()->getBool(showFilenamesSetting);
+		if (showFilenames != mGameNamesShowFilenames)
+		{
+			mGameNames.clear();
+			mFilteredGamesValid = false;
+		}
+
+		mGameNamesSettings = settingsGeneration;
+		mGameNamesShowFilenames = showFilenames;
+	}
+
+	if (mFilteredGamesValid && mFilteredGamesGeneration == mFilterGeneration)
+		return;
+
+	mFilteredGames.clear();
+
+	if (!mTextFilter.empty() && mGameNames.size() != mGames.size())
+	{
+		mGameNames.resize(mGames.size());
+
+		for (unsigned int id = 0; id < mGames.size(); id++)
+			if (mGames[id] != nullptr)
+				mGameNames[id] = Utils::String::toUpper(mGames[id]->getName());
+	}
+
+	for (unsigned int id = 0; id < mGames.size(); id++)
+		if (mGames[id] != nullptr && (mTextFilter.empty() || mGameNames[id].find(mTextFilter) != std::string::npos))
+			mFilteredGames.set(id);
+
+	// Each active filter : union of the games of the selected values, intersected with the result
+	for (auto& it : mFilterDecl)
+	{
+		FilterDataDecl& filterData = it.second;
+		if (!(*(filterData.filteredByRef)))
+			continue;
+
+		auto& typeKeys = mGameKeys[filterData.type];
+
+		GameBitset matching;
+		for (auto key : *filterData.currentFilteredKeys)
+		{
+			auto games = typeKeys.find(key);
+			if (games == typeKeys.cend())
+				continue;
+
+			for (auto id : games->second)
+				matching.set(id);
+		}
+
+		mFilteredGames.intersect(matching);
+	}
+
+	mFilteredGamesGeneration = mFilterGeneration;
+	mFilteredGamesValid = true;
 }
 
 bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
@@ -554,6 +888,8 @@ bool CollectionFilter::createFromSystem(const std::string name, SystemData* syst
 		*(filterData.filteredByRef) = (filterData.currentFilteredKeys->size() > 0);
 	}
 
+	mFilterGeneration++;
+
 	mName = name;
 	mPath = getCollectionsFolder() + "/" + mName + ".xcc";
 	
@@ -626,6 +962,8 @@ bool CollectionFilter::load(const std::string file)
 		*(filterData.filteredByRef) = (filterData.currentFilteredKeys->size() > 0);
 	}
 
+	mFilterGeneration++;
+
 	return true;
 }
 
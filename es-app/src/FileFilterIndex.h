@@ -3,7 +3,9 @@
 #define ES_APP_FILE_FILTER_INDEX_H
 
 #include <map>
+#include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 
 class FileData;
@@ -65,6 +67,9 @@ public:
 	void setTextFilter(const std::string text);
 	inline const std::string getTextFilter() { return mTextFilter; }
 
+	// Changes each time the filters are modified
+	inline unsigned int getFilterGeneration() { return mFilterGeneration; }
+
 protected:
 	//std::vector<FilterDataDecl> filterDataDecl;
 	std::map<int, FilterDataDecl> mFilterDecl;
@@ -82,6 +87,62 @@ protected:
 
 	void clearIndex(std::map<std::string, int> indexMap);
 
+	// Inverted index : indexed games get a dense id, each filter value keeps the ids of the games having it.
+	// The active filters are evaluated once per generation into a bitset, showFile is then a bit test.
+	class GameBitset
+	{
+	public:
+		void set(unsigned int id) { if (id / 64 >= mBits.size()) mBits.resize(id / 64 + 1, 0); mBits[id / 64] |= (1ULL << (id % 64)); }
+		void reset(unsigned int id) { if (id / 64 < mBits.size()) mBits[id / 64] &= ~(1ULL << (id % 64)); }
+		bool test(unsigned int id) const { return id / 64 < mBits.size() && (mBits[id / 64] & (1ULL << (id % 64))) != 0; }
+		void clear() { mBits.clear(); }
+
+		void intersect(const GameBitset& other)
+		{
+			if (mBits.size() > other.mBits.size())
+				mBits.resize(other.mBits.size());
+
+			for (size_t i = 0; i < mBits.size(); i++)
+				mBits[i] &= other.mBits[i];
+		}
+
+	private:
+		std::vector<unsigned long long> mBits;
+	};
+
+	void getFilterKeys(FileData* game, FilterIndexType type, std::vector<std::string>& keys);
+	void indexGameKeys(FileData* game, unsigned int id);
+	void unindexGameKeys(FileData* game, unsigned int id);
+	void removeGameKeys(const GameBitset& ids);
+	void rebuildGameKeys();
+	void updateChangedGames();
+	void updateFilteredGames();
+	bool isGameMatching(FileData* game);
+
+	std::vector<FileData*> mGames; // id -> game, nullptr when the id is free
+	std::vector<unsigned int> mFreeIds;
+	std::unordered_map<FileData*, unsigned int> mGameIds;
+	std::vector<std::string> mGameNames; // Upper case names for the text filter, built on demand
+	unsigned int mGameNamesSettings; // Settings generation ShowFilenames was read at
+	bool mGameNamesShowFilenames;
+	std::map<int, std::unordered_map<std::string, std::vector<unsigned int>>> mGameKeys;
+
+	// Systems of the indexed games, with the metadata generation of the system mGameKeys are up to date with :
+	// the games changed after it are indexed again
+	struct GameSystem
+	{
+		GameSystem() : games(0), generation(0) { }
+
+		unsigned int games;
+		unsigned int generation;
+	};
+
+	std::unordered_map<SystemData*, GameSystem> mGameSystems;
+
+	GameBitset mFilteredGames;
+	unsigned int mFilteredGamesGeneration;
+	bool mFilteredGamesValid;
+
 	bool filterByGenre;
 	bool filterByPlayers;
 	bool filterByPubDev;
@@ -118,6 +179,7 @@ protected:
 	FileData* mRootFolder;
 
 	std::string mTextFilter;
+	unsigned int mFilterGeneration;
 };
 
 class CollectionFilter : public FileFilterIndex
@@ -0,0 +1,151 @@
+#include "FileHasher.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/HashUtil.h"
+#include "utils/StringUtil.h"
+#include "scrapers/md5.h"
+#include "ApiSystem.h"
+#include "Log.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#endif
+
+// Files are read sequentially by 1 Mb blocks
+#define HASH_BUFFER_SIZE	1024 * 1024
+
+#define ZIP_EOCD_SIGNATURE	0x06054b50
+#define ZIP_EOCD_SIZE		22
+#define ZIP_CDFH_SIGNATURE	0x02014b50
+#define ZIP_CDFH_SIZE		46
+
+static inline uint16_t readUInt16(const unsigned char* data) { return (uint16_t)(data[0] | (data[1] << 8)); }
+static inline uint32_t readUInt32(const unsigned char* data) { return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24); }
+
+static bool readAt(FILE* file, long offset, unsigned char* data, size_t size)
+{
+	return fseek(file, offset, SEEK_SET) == 0 && fread(data, 1, size, file) == size;
+}
+
+bool FileHasher::readFile(const std::string& path, const std::function<void(const unsigned char*, size_t)>& process)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+#if !defined(WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+	posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	// Our buffer is large enough, stdio doesn't need to copy the data in its own
+	setvbuf(file, nullptr, _IONBF, 0);
+
+	std::unique_ptr<unsigned char[]> buffer(new unsigned char[HASH_BUFFER_SIZE]);
+
+	size_t size;
+	while ((size = fread(buffer.get(), 1, HASH_BUFFER_SIZE, file)) > 0)
+		process(buffer.get(), size);
+
+	bool ret = !ferror(file);
+	fclose(file);
+	return ret;
+}
+
+bool FileHasher::getZipContentsCRC32(const std::string& path, unsigned int& crc)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	bool ret = false;
+
+	// The end of central directory record is at the end of the file, followed by a comment of 64 Kb max
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+
+	long tailSize = std::min(fileSize, (long)(ZIP_EOCD_SIZE + 0xFFFF));
+	std::vector<unsigned char> tail(tailSize);
+
+	if (tailSize >= ZIP_EOCD_SIZE && readAt(file, fileSize - tailSize, tail.data(), tailSize))
+	{
+		for (long pos = tailSize - ZIP_EOCD_SIZE; pos >= 0; pos--)
+		{
+			if (readUInt32(&tail[pos]) != ZIP_EOCD_SIGNATURE)
+				continue;
+
+			uint32_t cdSize = readUInt32(&tail[pos + 12]);
+			uint32_t cdOffset = readUInt32(&tail[pos + 16]);
+
+			// zip64 archives are left to 7zr
+			if (cdOffset == 0xFFFFFFFF || cdSize == 0 || (long)cdOffset + (long)cdSize > fileSize)
+				break;
+
+			std::vector<unsigned char> cd(cdSize);
+			if (!readAt(file, (long)cdOffset, cd.data(), cdSize))
+				break;
+
+			// Same result as "7zr l -slt" : the CRC of the last file listed
+			for (size_t entry = 0; entry + ZIP_CDFH_SIZE <= cd.size() && readUInt32(&cd[entry]) == ZIP_CDFH_SIGNATURE; )
+			{
+				uint16_t nameLength = readUInt16(&cd[entry + 28]);
+				uint16_t extraLength = readUInt16(&cd[entry + 30]);
+				uint16_t commentLength = readUInt16(&cd[entry + 32]);
+
+				if (entry + ZIP_CDFH_SIZE + nameLength > cd.size())
+					break;
+
+				bool isDirectory = nameLength > 0 && cd[entry + ZIP_CDFH_SIZE + nameLength - 1] == '/';
+				if (!isDirectory)
+				{
+					crc = readUInt32(&cd[entry + 16]);
+					ret = true;
+				}
+
+				entry += ZIP_CDFH_SIZE + nameLength + extraLength + commentLength;
+			}
+
+			break;
+		}
+	}
+
+	fclose(file);
+	return ret;
+}
+
+std::string FileHasher::getCRC32(const std::string& path, bool fromZipContents)
+{
+	unsigned int crc = 0;
+
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(path));
+	if (fromZipContents && (ext == ".7z" || ext == ".zip"))
+	{
+		if (ext == ".zip" && getZipContentsCRC32(path, crc))
+			return Utils::String::format("%08X", crc);
+
+		return ApiSystem::getInstance()->getCRC32(path, fromZipContents);
+	}
+
+	if (!readFile(path, [&crc](const unsigned char* data, size_t size) { crc = Utils::Hash::crc32(data, size, crc); }))
+	{
+		LOG(LogWarning) << "FileHasher : unable to read " << path;
+		return "";
+	}
+
+	return Utils::String::format("%08X", crc);
+}
+
+std::string FileHasher::getMD5(const std::string& path)
+{
+	MD5 md5;
+
+	if (!readFile(path, [&md5](const unsigned char* data, size_t size) { md5.update(data, (MD5::size_type)size); }))
+		return "";
+
+	md5.finalize();
+	return md5.hexdigest();
+}
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef ES_APP_FILE_HASHER_H
+#define ES_APP_FILE_HASHER_H
+
+#include <functional>
+#include <string>
+
+// In-process CRC32 / MD5 of game files ( no 7zr process per file ).
+class FileHasher
+{
+public:
+	// CRC32 as 8 upper case hex digits, empty on error.
+	// With fromZipContents, the CRC32 of the ( last ) file inside a zip is read from its central directory, nothing is decompressed.
+	// Archives that can't be read here ( 7z, zip64 ) fall back to ApiSystem::getCRC32.
+	static std::string getCRC32(const std::string& path, bool fromZipContents = true);
+
+	// MD5 as 32 lower case hex digits, empty on error.
+	static std::string getMD5(const std::string& path);
+
+private:
+	static bool getZipContentsCRC32(const std::string& path, unsigned int& crc);
+	static bool readFile(const std::string& path, const std::function<void(const unsigned char*, size_t)>& process);
+};
+
+#endif // ES_APP_FILE_HASHER_H
@@ -2,6 +2,7 @@
 
 #include "utils/StringUtil.h"
 #include "LocaleES.h"
+#include <algorithm>
 
 namespace FileSorts
 {
@@ -63,6 +64,120 @@ namespace FileSorts
 		mSortTypes.push_back(SortType(FILECREATION_DATE_DESCENDING, &compareFileCreationDate, false, _("FILE CREATION DATE, DESCENDING"), _U("\uF161 ")));
 	}
 
+	struct SortKey
+	{
+		double		number;
+		std::string text;
+		FileData*	file;
+	};
+
+	static std::string toUpperKey(const std::string& value)
+	{
+		// Same folding as compareName : byte per byte
+		std::string ret(value);
+		for (auto& c : ret)
+			c = toupper((unsigned char)c);
+
+		return ret;
+	}
+
+	// compareName orders the bytes as signed chars ( utf8 names before ascii ), std::string::compare as unsigned chars
+	static int compareSignedText(const std::string& a, const std::string& b)
+	{
+		size_t size = std::min(a.size(), b.size());
+
+		for (size_t i = 0; i < size; i++)
+			if (a[i] != b[i])
+				return (signed char)a[i] < (signed char)b[i] ? -1 : 1;
+
+		return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+	}
+
+	static void getSortKey(SortKey& key, FileData* file, unsigned int sortId)
+	{
+		key.file = file;
+		key.number = 0;
+
+		const MetaDataList& md = file->getMetadata();
+
+		switch (sortId)
+		{
+		case FILENAME_ASCENDING:
+		case FILENAME_DESCENDING:
+			key.number = file->getType() == FOLDER ? 0 : 1;
+			key.text = toUpperKey(file->getName());
+			break;
+		case RATING_ASCENDING:
+		case RATING_DESCENDING:
+			key.number = md.getFloat(MetaDataId::Rating);
+			break;
+		case TIMESPLAYED_ASCENDING:
+		case TIMESPLAYED_DESCENDING:
+			key.number = md.getInt(MetaDataId::PlayCount);
+			break;
+		case LASTPLAYED_ASCENDING:
+		case LASTPLAYED_DESCENDING:
+			key.text = md.getValue(MetaDataId::LastPlayed);
+			break;
+		case NUMBERPLAYERS_ASCENDING:
+		case NUMBERPLAYERS_DESCENDING:
+			key.number = md.getInt(MetaDataId::Players);
+			break;
+		case RELEASEDATE_ASCENDING:
+		case RELEASEDATE_DESCENDING:
+			key.text = md.getValue(MetaDataId::ReleaseDate);
+			break;
+		case GENRE_ASCENDING:
+		case GENRE_DESCENDING:
+			key.text = Utils::String::toUpper(md.getValue(MetaDataId::Genre));
+			break;
+		case DEVELOPER_ASCENDING:
+		case DEVELOPER_DESCENDING:
+			key.text = Utils::String::toUpper(md.getValue(MetaDataId::Developer));
+			break;
+		case PUBLISHER_ASCENDING:
+		case PUBLISHER_DESCENDING:
+			key.text = Utils::String::toUpper(md.getValue(MetaDataId::Publisher));
+			break;
+		case SYSTEM_ASCENDING:
+		case SYSTEM_DESCENDING:
+			key.text = Utils::String::toUpper(file->getSystemName());
+			break;
+		case FILECREATION_DATE_ASCENDING:
+		case FILECREATION_DATE_DESCENDING:
+			key.text = Utils::FileSystem::getFileCreationDate(file->getPath()).getIsoString();
+			break;
+		}
+	}
+
+	void sortFiles(std::vector<FileData*>& files, unsigned int sortId, bool ascending)
+	{
+		std::vector<SortKey> keys;
+		keys.resize(files.size());
+
+		for (size_t i = 0; i < files.size(); i++)
+			getSortKey(keys[i], files[i], sortId);
+
+		bool signedText = (sortId == FILENAME_ASCENDING || sortId == FILENAME_DESCENDING);
+
+		std::sort(keys.begin(), keys.end(), [signedText](const SortKey& a, const SortKey& b)
+		{
+			if (a.number != b.number)
+				return a.number < b.number;
+
+			if (signedText)
+				return compareSignedText(a.text, b.text) < 0;
+
+			return a.text.compare(b.text) < 0;
+		});
+
+		for (size_t i = 0; i < files.size(); i++)
+			files[i] = keys[i].file;
+
+		if (!ascending)
+			std::reverse(files.begin(), files.end());
+	}
+
 	//returns if file1 should come before file2
 	bool compareName(const FileData* file1, const FileData* file2)
 	{
@@ -81,8 +196,8 @@ namespace FileSorts
 			if (*ap == 0 || *bp == 0)
 				return false;
 
-			auto c1 = toupper(*ap);
-			auto c2 = toupper(*bp);
+			auto c1 = (signed char)toupper((unsigned char)*ap);
+			auto c2 = (signed char)toupper((unsigned char)*bp);
 			if (c1 != c2)
 				return c1 < c2;			
 		}
@@ -92,7 +207,7 @@ namespace FileSorts
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->getMetadata().getFloat("rating") < file2->getMetadata().getFloat("rating");
+		return file1->getMetadata().getFloat(MetaDataId::Rating) < file2->getMetadata().getFloat(MetaDataId::Rating);
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -100,7 +215,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if (file1->getMetadata().getType() == GAME_METADATA && file2->getMetadata().getType() == GAME_METADATA)
 		{
-			return (file1)->getMetadata().getInt("playcount") < (file2)->getMetadata().getInt("playcount");
+			return (file1)->getMetadata().getInt(MetaDataId::PlayCount) < (file2)->getMetadata().getInt(MetaDataId::PlayCount);
 		}
 
 		return false;
@@ -115,7 +230,7 @@ namespace FileSorts
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->getMetadata().getInt("players") < (file2)->getMetadata().getInt("players");
+		return (file1)->getMetadata().getInt(MetaDataId::Players) < (file2)->getMetadata().getInt(MetaDataId::Players);
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
@@ -59,6 +59,9 @@ namespace FileSorts
 	SortType getSortType(int sortId);
 	const std::vector<SortType>& getSortTypes();
 
+	// Sorts using keys computed once per file ( case-folded names, pre-parsed numbers... ), same order as the comparison functions
+	void sortFiles(std::vector<FileData*>& files, unsigned int sortId, bool ascending);
+
 	bool compareName(const FileData* file1, const FileData* file2);
 	bool compareRating(const FileData* file1, const FileData* file2);
 	bool compareTimesPlayed(const FileData* file1, const FileData* fil2);
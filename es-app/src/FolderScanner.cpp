@@ -0,0 +1,69 @@
+#include "FolderScanner.h"
+
+#include "utils/StringUtil.h"
+#include "SystemData.h"
+
+FolderScanner::FolderScanner(SystemEnvironmentData* envData, bool showHidden, Utils::ThreadPool* pool) : mEnvData(envData), mShowHidden(showHidden), mTasks(pool)
+{
+}
+
+bool FolderScanner::isMediaFolder(const std::string& path)
+{
+	// Don't loose time looking in downloaded_images, downloaded_videos & media folders
+	return path.rfind("downloaded_") != std::string::npos ||
+		path.rfind("media") != std::string::npos ||
+		path.rfind("images") != std::string::npos ||
+		path.rfind("videos") != std::string::npos;
+}
+
+void FolderScanner::scan(const std::string& path)
+{
+	// The calling thread lists the root folder, sub folders are spread on the pool.
+	// wait() runs the remaining tasks of this scan on the calling thread as well.
+	process(path);
+	mTasks.wait();
+}
+
+FolderScanner::Listing* FolderScanner::getListing(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(mListingsLock);
+
+	auto it = mListings.find(path);
+	if (it != mListings.cend())
+		return &it->second;
+
+	return nullptr;
+}
+
+void FolderScanner::process(const std::string& path)
+{
+	// Same checks as SystemData::populateFolder : a recursive symlink must not be enumerated
+	if (!Utils::FileSystem::isDirectory(path))
+		return;
+
+	if (Utils::FileSystem::isSymlink(path) && path.find(Utils::FileSystem::getCanonicalPath(path)) == 0)
+		return;
+
+	Listing listing;
+	listing.time = Utils::FileSystem::getFileModificationDate(path).getTime();
+	listing.files = Utils::FileSystem::getDirectoryFiles(path);
+
+	for (auto& fileInfo : listing.files)
+	{
+		if (!fileInfo.directory || (!mShowHidden && fileInfo.hidden))
+			continue;
+
+		// Folders matching an extension are games, they are enumerated later only if they are not ( arcade assets )
+		if (mEnvData->isValidExtension(Utils::String::toLower(Utils::FileSystem::getExtension(fileInfo.path))))
+			continue;
+
+		if (isMediaFolder(fileInfo.path))
+			continue;
+
+		std::string subFolder = fileInfo.path;
+		mTasks.run([this, subFolder] { process(subFolder); });
+	}
+
+	std::unique_lock<std::mutex> lock(mListingsLock);
+	mListings[path] = std::move(listing);
+}
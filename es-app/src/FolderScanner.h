@@ -0,0 +1,45 @@
+#pragma once
+#ifndef ES_APP_FOLDER_SCANNER_H
+#define ES_APP_FOLDER_SCANNER_H
+
+#include "utils/FileSystemUtil.h"
+#include "utils/ThreadPool.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct SystemEnvironmentData;
+
+// Enumerates a ROM folder tree on the shared ThreadPool, one task per folder.
+// Only the directory listings are collected here : SystemData::populateFolder still creates the FileData in directory order,
+// so the resulting tree & fileMap are exactly the same as with a sequential scan.
+class FolderScanner
+{
+public:
+	struct Listing
+	{
+		time_t time;
+		Utils::FileSystem::fileList files;
+	};
+
+	FolderScanner(SystemEnvironmentData* envData, bool showHidden, Utils::ThreadPool* pool = nullptr); // nullptr : the shared ThreadPool
+
+	void scan(const std::string& path);
+	Listing* getListing(const std::string& path);
+
+	// downloaded_images, media... folders are never scanned. Shared with SystemData::populateFolder
+	static bool isMediaFolder(const std::string& path);
+
+private:
+	void process(const std::string& path);
+
+	SystemEnvironmentData* mEnvData;
+	bool mShowHidden;
+
+	Utils::TaskGroup mTasks;
+
+	std::mutex mListingsLock;
+	std::unordered_map<std::string, Listing> mListings;
+};
+
+#endif // ES_APP_FOLDER_SCANNER_H
@@ -4,10 +4,16 @@
 #include "utils/StringUtil.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "GamelistCache.h"
+#include "GamelistJournal.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include <pugixml/src/pugixml.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
 
 #ifdef WIN32
 #include <Windows.h>
@@ -104,6 +110,54 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	return NULL;
 }
 
+// Applies a <game> or <folder> node. Nodes coming from the recovery are pending changes : they stay dirty
+void loadGamelistNode(pugi::xml_node& fileNode, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, bool trustGamelist, bool isRecovery)
+{
+	FileType type = GAME;
+
+	std::string tag = fileNode.name();
+
+	if (tag == "folder")
+		type = FOLDER;
+	else if (tag != "game")
+		return;
+
+	const std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), system->getStartPath(), false);
+			
+	if (!trustGamelist && !Utils::FileSystem::exists(path))
+	{
+		LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
+		return;
+	}
+
+	FileData* file = findOrCreateFile(system, path, type, fileMap);
+	if (!file)
+	{
+		LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
+		return;
+	}
+	else if (!file->isArcadeAsset())
+	{
+		std::string defaultName = file->getMetadata(MetaDataId::Name);
+		file->setMetadata(MetaDataList::createFromXML(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, fileNode, system));
+
+		//make sure name gets set if one didn't exist
+		if (file->getMetadata(MetaDataId::Name).empty())
+			file->setMetadata("name", defaultName);
+
+		if (!file->getHidden() && Utils::FileSystem::isHidden(path))
+			file->getMetadata().set("hidden", "true");
+
+		if (isRecovery)
+			file->getMetadata().setDirty();
+		else
+		{
+			file->getMetadata().resetChangedFlag();
+			file->setInGamelist(true);
+		}
+	}
+}
+
 void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX)
 {	
 	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
@@ -136,51 +190,9 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 		}
 	}
 	
-	std::string relativeTo = system->getStartPath();
-
+	bool isRecovery = (checkSize != SIZE_MAX);
 	for (pugi::xml_node fileNode : root.children())
-	{
-		FileType type = GAME;
-
-		std::string tag = fileNode.name();
-
-		if (tag == "folder")
-			type = FOLDER;
-		else if (tag != "game")
-			continue;
-
-		const std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), relativeTo, false);
-				
-		if (!trustGamelist && !Utils::FileSystem::exists(path))
-		{
-			LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
-			continue;
-		}
-
-		FileData* file = findOrCreateFile(system, path, type, fileMap);
-		if (!file)
-		{
-			LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
-			continue;
-		}
-		else if (!file->isArcadeAsset())
-		{
-			std::string defaultName = file->getMetadata(MetaDataId::Name);
-			file->setMetadata(MetaDataList::createFromXML(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, fileNode, system));
-
-			//make sure name gets set if one didn't exist
-			if (file->getMetadata(MetaDataId::Name).empty())
-				file->setMetadata("name", defaultName);
-
-			if (!file->getHidden() && Utils::FileSystem::isHidden(path))
-				file->getMetadata().set("hidden", "true");
-
-			if (checkSize != SIZE_MAX)
-				file->getMetadata().setDirty();
-			else
-				file->getMetadata().resetChangedFlag();
-		}
-	}
+		loadGamelistNode(fileNode, system, fileMap, trustGamelist, isRecovery);
 }
 
 void clearTemporaryGamelistRecovery(SystemData* system)
@@ -202,20 +214,37 @@ void clearTemporaryGamelistRecovery(SystemData* system)
 	}
 
 	rmdir(path.c_str());
+
+	GamelistJournal::clear(system);
+}
+
+bool hasGamelistRecovery(SystemData* system)
+{
+	return GamelistJournal::exists(system) || Utils::FileSystem::exists(getGamelistRecoveryPath(system));
 }
 
 void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
 {
+	PROFILE_ZONE("parseGamelist");
+
 	std::string xmlpath = system->getGamelistPath(false);
 
 	auto size = Utils::FileSystem::getFileSize(xmlpath);
 	if (size != 0)
 		loadGamelistFile(xmlpath, system, fileMap);
 
+	// Recovery files written by previous versions
 	auto files = Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true);
 	for (auto file : files)
 		loadGamelistFile(file, system, fileMap, size);
 
+	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+
+	GamelistJournal::replay(system, size, [system, &fileMap, trustGamelist](pugi::xml_node& node)
+	{
+		loadGamelistNode(node, system, fileMap, trustGamelist, true);
+	});
+
 	if (size != SIZE_MAX)
 		system->setGamelistHash(size);
 }
@@ -259,29 +288,13 @@ bool saveToGamelistRecovery(FileData* file)
 	const char* tag = file->getType() == GAME ? "game" : "folder";
 
 	SystemData* system = file->getSourceFileData()->getSystem();
-	root.append_attribute("parentHash").set_value(system->getGamelistHash());
 
 	if (addFileDataNode(root, file, tag, system))
 	{
-		std::string fp = file->getFullPath();
-		fp = Utils::FileSystem::createRelativePath(file->getFullPath(), system->getRootFolder()->getFullPath(), true);
-		fp = Utils::FileSystem::getParent(fp) + "/" + Utils::FileSystem::getStem(fp) + ".xml";
-
-		std::string path = Utils::FileSystem::getAbsolutePath(fp, getGamelistRecoveryPath(system));
-		path = Utils::FileSystem::getCanonicalPath(path);
-
-		std::string folder = Utils::FileSystem::getParent(path);
+		std::ostringstream node;
+		root.first_child().print(node, "", pugi::format_raw);
 
-		if (!Utils::FileSystem::exists(folder))
-			Utils::FileSystem::createDirectory(folder);
-
-		if (!doc.save_file(path.c_str()))
-		{
-			LOG(LogError) << "Error saving gamelist.xml to \"" << path << "\" (for system " << system->getName() << ")!";
-			return false;
-		}
-
-		return true;
+		return GamelistJournal::append(system, node.str());
 	}
 
 	return false;
@@ -292,15 +305,7 @@ bool hasDirtyFile(SystemData* system)
 	if (system == nullptr || !system->isGameSystem() || system->getName() == "imageviewer")
 		return false;
 
-	FolderData* rootFolder = system->getRootFolder();
-	if (rootFolder == nullptr)
-		return false;
-
-	for (auto file : rootFolder->getFilesRecursive(GAME | FOLDER))
-		if (file->getMetadata().wasChanged())
-			return true;
-
-	return false;
+	return system->hasDirtyFiles();
 }
 
 void updateGamelist(SystemData* system)
@@ -323,12 +328,14 @@ void updateGamelist(SystemData* system)
 		return;
 	}
 
+	// Files register themselves in the system when their metadata changes : no need to walk the whole tree
 	std::vector<FileData*> dirtyFiles;
-	std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
-	for (auto file : files)
+	for (auto file : system->getDirtyFiles())
 		if (file->getMetadata().wasChanged())
 			dirtyFiles.push_back(file);
 
+	std::sort(dirtyFiles.begin(), dirtyFiles.end(), [](FileData* a, FileData* b) { return a->getPath() < b->getPath(); });
+
 	if (dirtyFiles.size() == 0)
 	{
 		clearTemporaryGamelistRecovery(system);
@@ -358,18 +365,47 @@ void updateGamelist(SystemData* system)
 	else //set up an empty gamelist to append to		
 		root = doc.append_child("gameList");
 
-	std::map<std::string, pugi::xml_node> xmlMap;
+	// Only the nodes of the dirty files are looked for. Paths are compared in their resolved form,
+	// which avoids a getCanonicalPath ( realpath ) call per node of the gamelist
+	std::unordered_map<std::string, FileData*> dirtyMap;
+	for (auto file : dirtyFiles)
+		dirtyMap[file->getPath()] = file;
+
+	std::unordered_map<FileData*, pugi::xml_node> xmlMap;
+	std::string relativeTo = system->getStartPath();
 
 	for (pugi::xml_node fileNode : root.children())
 	{
 		pugi::xml_node path = fileNode.child("path");
-		if (path)
+		if (!path)
+			continue;
+
+		auto file = dirtyMap.find(Utils::FileSystem::resolveRelativePath(path.text().get(), relativeTo, true));
+		if (file != dirtyMap.cend())
+			xmlMap[file->second] = fileNode;
+	}
+
+	// Files loaded from the gamelist but not found may be written with another spelling of their path
+	// ( symlinks, ".." ) : compare the canonical paths for them, like before. New files have no node to look for
+	std::unordered_map<std::string, FileData*> canonicalMap;
+	for (auto file : dirtyFiles)
+		if (file->isInGamelist() && xmlMap.find(file) == xmlMap.cend())
+			canonicalMap[Utils::FileSystem::getCanonicalPath(file->getPath())] = file;
+
+	if (canonicalMap.size() > 0)
+	{
+		for (pugi::xml_node fileNode : root.children())
 		{
-			std::string nodePath = Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(path.text().get(), system->getStartPath(), true));
-			xmlMap[nodePath] = fileNode;
+			pugi::xml_node path = fileNode.child("path");
+			if (!path)
+				continue;
+
+			auto file = canonicalMap.find(Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(path.text().get(), relativeTo, true)));
+			if (file != canonicalMap.cend())
+				xmlMap[file->second] = fileNode;
 		}
 	}
-	
+
 	// iterate through all files, checking if they're already in the XML
 	for(auto file : dirtyFiles)
 	{
@@ -377,7 +413,7 @@ void updateGamelist(SystemData* system)
 
 		// check if the file already exists in the XML
 		// if it does, remove it before adding
-		auto xmf = xmlMap.find(Utils::FileSystem::getCanonicalPath(file->getPath()));
+		auto xmf = xmlMap.find(file);
 		if (xmf != xmlMap.cend())
 		{
 			removed = true;
@@ -387,10 +423,13 @@ void updateGamelist(SystemData* system)
 		const char* tag = (file->getType() == GAME) ? "game" : "folder";
 
 		// it was either removed or never existed to begin with; either way, we can add it now
-		if (addFileDataNode(root, file, tag, system))
+		bool added = addFileDataNode(root, file, tag, system);
+		if (added)
 			++numUpdated; // Only if really added
 		else if (removed)
 			++numUpdated; // Only if really removed
+
+		file->setInGamelist(added);
 	}
 
 	// Now write the file
@@ -402,10 +441,32 @@ void updateGamelist(SystemData* system)
 
 		LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
 
-		if (!doc.save_file(xmlWritePath.c_str()))
+		// Write to a temporary file, then replace : the gamelist is never left truncated
+		std::string xmlTempPath = xmlWritePath + ".tmp";
+
+		if (!doc.save_file(xmlTempPath.c_str()))
+		{
 			LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
+			Utils::FileSystem::removeFile(xmlTempPath);
+		}
 		else
+		{
+#ifdef WIN32
+			Utils::FileSystem::removeFile(xmlWritePath);
+#endif
+			if (rename(xmlTempPath.c_str(), xmlWritePath.c_str()) != 0)
+			{
+				LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
+				Utils::FileSystem::removeFile(xmlTempPath);
+				return;
+			}
+
+			for (auto file : dirtyFiles)
+				file->getMetadata().resetChangedFlag();
+
 			clearTemporaryGamelistRecovery(system);
+			GamelistCache::save(system);
+		}
 	}
 	else
 		clearTemporaryGamelistRecovery(system);
@@ -2,6 +2,7 @@
 #ifndef ES_APP_GAME_LIST_H
 #define ES_APP_GAME_LIST_H
 
+#include <string>
 #include <unordered_map>
 
 class SystemData;
@@ -16,4 +17,8 @@ void updateGamelist(SystemData* system);
 bool saveToGamelistRecovery(FileData* file);
 bool hasDirtyFile(SystemData* system);
 
+// Pending changes are saved in a journal ( and in this folder by previous versions ) until gamelist.xml is written.
+std::string getGamelistRecoveryPath(SystemData* system);
+bool hasGamelistRecovery(SystemData* system);
+
 #endif // ES_APP_GAME_LIST_H
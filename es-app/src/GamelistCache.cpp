@@ -0,0 +1,484 @@
+#include "GamelistCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "FileData.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define GAMELISTCACHE_MAGIC		0x43474C45 // "ELGC"
+#define GAMELISTCACHE_VERSION	2
+
+// File layout ( native endianness, the snapshot is never shared between machines )
+//
+//	Header
+//	strings	: uint32 length + chars, for each string. Every path & metadata value is stored once
+//	folders	: uint32 string id + int64 date, for each scanned folder
+//	nodes	: uint8 type, uint8 flags, int32 parent node, uint32 path string id, uint8 metadata count + ( uint8 id, uint32 string id ) for each metadata
+//			  node 0 is the root folder. Parents are always written before their children.
+
+#pragma pack(push, 1)
+struct GamelistCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t settingsHash;
+	uint64_t gamelistSize;
+	int64_t  gamelistTime;
+	uint32_t stringCount;
+	uint32_t folderCount;
+	uint32_t nodeCount;
+};
+#pragma pack(pop)
+
+#define NODE_FLAG_RELATIVETO 1
+#define NODE_FLAG_INGAMELIST 2
+
+bool GamelistCache::sResetRequested = false;
+
+class CacheFileReader
+{
+public:
+	CacheFileReader(const std::string& path) : mData(nullptr), mSize(0), mPosition(0)
+	{
+#ifdef WIN32
+		std::ifstream f(path.c_str(), std::ios::binary | std::ios::ate);
+		if (f.fail())
+			return;
+
+		size_t size = (size_t)f.tellg();
+		if (size == 0)
+			return;
+
+		mBuffer.resize(size);
+		f.seekg(0, std::ios::beg);
+		if (!f.read((char*)mBuffer.data(), size))
+			return;
+
+		mData = mBuffer.data();
+		mSize = size;
+#else
+		mFile = open(path.c_str(), O_RDONLY);
+		if (mFile < 0)
+			return;
+
+		struct stat info;
+		if (fstat(mFile, &info) != 0 || info.st_size == 0)
+			return;
+
+		void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+		if (map == MAP_FAILED)
+			return;
+
+		madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+		mData = (const unsigned char*)map;
+		mSize = info.st_size;
+#endif
+	}
+
+	~CacheFileReader()
+	{
+#ifndef WIN32
+		if (mData != nullptr)
+			munmap((void*)mData, mSize);
+
+		if (mFile >= 0)
+			close(mFile);
+#endif
+	}
+
+	bool isValid() { return mData != nullptr; }
+
+	template<typename T> bool read(T& value)
+	{
+		if (mPosition + sizeof(T) > mSize)
+			return false;
+
+		memcpy(&value, mData + mPosition, sizeof(T));
+		mPosition += sizeof(T);
+		return true;
+	}
+
+	bool readChars(const char*& chars, uint32_t length)
+	{
+		if (mPosition + length > mSize)
+			return false;
+
+		chars = (const char*)(mData + mPosition);
+		mPosition += length;
+		return true;
+	}
+
+private:
+#ifdef WIN32
+	std::vector<unsigned char> mBuffer;
+#else
+	int mFile;
+#endif
+	const unsigned char* mData;
+	size_t mSize;
+	size_t mPosition;
+};
+
+class CacheFileWriter
+{
+public:
+	template<typename T> void write(const T& value)
+	{
+		const unsigned char* ptr = (const unsigned char*)&value;
+		mBuffer.insert(mBuffer.end(), ptr, ptr + sizeof(T));
+	}
+
+	uint32_t intern(const std::string& value)
+	{
+		auto it = mStringIds.find(value);
+		if (it != mStringIds.cend())
+			return it->second;
+
+		uint32_t id = (uint32_t)mStrings.size();
+		mStringIds[value] = id;
+		mStrings.push_back(&mStringIds.find(value)->first);
+		return id;
+	}
+
+	bool saveFile(const std::string& path, GamelistCacheHeader& header)
+	{
+		std::string tmpPath = path + ".tmp";
+
+		std::ofstream f(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (f.fail())
+			return false;
+
+		header.stringCount = (uint32_t)mStrings.size();
+		f.write((const char*)&header, sizeof(header));
+
+		for (auto str : mStrings)
+		{
+			uint32_t length = (uint32_t)str->size();
+			f.write((const char*)&length, sizeof(length));
+			f.write(str->c_str(), length);
+		}
+
+		f.write((const char*)mBuffer.data(), mBuffer.size());
+		f.close();
+
+		if (f.fail())
+		{
+			remove(tmpPath.c_str());
+			return false;
+		}
+
+#ifdef WIN32
+		remove(path.c_str());
+#endif
+		return rename(tmpPath.c_str(), path.c_str()) == 0;
+	}
+
+private:
+	std::vector<unsigned char> mBuffer;
+	std::unordered_map<std::string, uint32_t> mStringIds;
+	std::vector<const std::string*> mStrings;
+};
+
+struct CacheString
+{
+	const char* chars;
+	uint32_t length;
+};
+
+struct CacheNode
+{
+	uint8_t  type;
+	uint8_t  flags;
+	int32_t  parent;
+	uint32_t path;
+	size_t   firstMetadata;
+	uint8_t  metadataCount;
+};
+
+struct CacheMetadata
+{
+	uint8_t  id;
+	uint32_t value;
+};
+
+std::string GamelistCache::getCachePath(SystemData* system)
+{
+	return Utils::FileSystem::getEsConfigPath() + "/gamelistcache/" + system->getName() + ".db";
+}
+
+// FNV-1a of everything that changes the result of SystemData::populateFolder / parseGamelist
+unsigned long long GamelistCache::getSettingsHash(SystemData* system)
+{
+	bool showHidden = system->getShowHiddenFiles();
+
+	std::string key = system->getStartPath() + "|" + Utils::String::join(system->getExtensions(), " ") + "|";
+
+	for (auto id : system->getPlatformIds())
+		key += std::to_string((int)id) + " ";
+
+	key += showHidden ? "|1" : "|0";
+	key += Settings::getInstance()->getBool("ParseGamelistOnly") ? "|1" : "|0";
+	key += Settings::getInstance()->getBool("IgnoreGamelist") ? "|1" : "|0";
+
+	unsigned long long hash = 14695981039346656037ULL;
+	for (auto c : key)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+void GamelistCache::resetCache()
+{
+	sResetRequested = true;
+}
+
+void GamelistCache::onLoadConfigCompleted()
+{
+	sResetRequested = false;
+}
+
+bool GamelistCache::load(SystemData* system)
+{
+	if (sResetRequested || !Settings::getInstance()->getBool("UseGamelistCache"))
+		return false;
+
+	// Pending changes are in the recovery journal -> They are applied by parseGamelist
+	if (hasGamelistRecovery(system))
+		return false;
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	CacheFileReader reader(getCachePath(system));
+	if (!reader.isValid())
+		return false;
+
+	GamelistCacheHeader header;
+	if (!reader.read(header) || header.magic != GAMELISTCACHE_MAGIC || header.version != GAMELISTCACHE_VERSION || header.nodeCount == 0)
+		return false;
+
+	if (header.settingsHash != getSettingsHash(system))
+		return false;
+
+	std::string xmlpath = system->getGamelistPath(false);
+	if (header.gamelistSize != (uint64_t)Utils::FileSystem::getFileSize(xmlpath) ||
+		header.gamelistTime != (int64_t)Utils::FileSystem::getFileModificationDate(xmlpath).getTime())
+		return false;
+
+	std::vector<CacheString> strings;
+	strings.resize(header.stringCount);
+
+	for (auto& str : strings)
+		if (!reader.read(str.length) || !reader.readChars(str.chars, str.length))
+			return false;
+
+	std::vector<FolderStamp> folders;
+	folders.reserve(header.folderCount);
+
+	for (uint32_t i = 0; i < header.folderCount; i++)
+	{
+		uint32_t pathId;
+		int64_t time;
+		if (!reader.read(pathId) || !reader.read(time) || pathId >= strings.size())
+			return false;
+
+		FolderStamp stamp;
+		stamp.path = std::string(strings[pathId].chars, strings[pathId].length);
+		stamp.time = (time_t)time;
+
+		// Something was added or removed in this folder
+		if (Utils::FileSystem::getFileModificationDate(stamp.path).getTime() != stamp.time)
+			return false;
+
+		folders.push_back(stamp);
+	}
+
+	// Read & check everything before creating any FileData
+	std::vector<CacheNode> nodes;
+	nodes.resize(header.nodeCount);
+
+	std::vector<CacheMetadata> metadatas;
+
+	for (uint32_t i = 0; i < header.nodeCount; i++)
+	{
+		CacheNode& node = nodes[i];
+		if (!reader.read(node.type) || !reader.read(node.flags) || !reader.read(node.parent) || !reader.read(node.path) || !reader.read(node.metadataCount))
+			return false;
+
+		if (node.path >= strings.size() || (node.type != GAME && node.type != FOLDER))
+			return false;
+
+		if (i == 0 ? (node.parent != -1 || node.type != FOLDER) : (node.parent < 0 || node.parent >= (int32_t)i || nodes[node.parent].type != FOLDER))
+			return false;
+
+		node.firstMetadata = metadatas.size();
+
+		for (int m = 0; m < node.metadataCount; m++)
+		{
+			CacheMetadata md;
+			if (!reader.read(md.id) || !reader.read(md.value) || md.value >= strings.size() || md.id >= MetaDataList::SlotCount)
+				return false;
+
+			metadatas.push_back(md);
+		}
+	}
+
+	FolderData* root = system->getRootFolder();
+
+	std::vector<FileData*> files;
+	files.resize(nodes.size());
+	files[0] = root;
+
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		CacheNode& node = nodes[i];
+
+		FileData* file = files[i];
+		if (file == nullptr)
+		{
+			std::string path(strings[node.path].chars, strings[node.path].length);
+
+			if (node.type == FOLDER)
+				file = new FolderData(path, system);
+			else
+				file = new FileData(GAME, path, system);
+
+			((FolderData*)files[node.parent])->addChild(file);
+			files[i] = file;
+		}
+
+		MetaDataList& mdl = file->getMetadata();
+		mdl.mRelativeTo = (node.flags & NODE_FLAG_RELATIVETO) ? system : nullptr;
+		mdl.clearValues();
+
+		file->setInGamelist((node.flags & NODE_FLAG_INGAMELIST) != 0);
+
+		for (size_t m = node.firstMetadata; m < node.firstMetadata + node.metadataCount; m++)
+		{
+			const CacheString& value = strings[metadatas[m].value];
+			mdl.setValue((MetaDataId)metadatas[m].id, std::string(value.chars, value.length));
+		}
+
+		mdl.resetChangedFlag();
+	}
+
+	system->setFolderStamps(folders);
+	if (header.gamelistSize != SIZE_MAX)
+		system->setGamelistHash(header.gamelistSize);
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+	LOG(LogInfo) << "Loaded gamelist cache of system " << system->getName() << " (" << nodes.size() << " entries) in " << elapsed << " ms";
+
+	return true;
+}
+
+void GamelistCache::appendMetadata(CacheFileWriter& writer, const MetaDataList& mdl)
+{
+	uint8_t count = 0;
+	for (int i = 0; i < MetaDataList::SlotCount; i++)
+		if (mdl.mValues[i] != nullptr)
+			count++;
+
+	writer.write(count);
+
+	for (int i = 0; i < MetaDataList::SlotCount; i++)
+	{
+		if (mdl.mValues[i] == nullptr)
+			continue;
+
+		writer.write((uint8_t)i);
+		writer.write(writer.intern(mdl.mValues[i]->value));
+	}
+}
+
+void GamelistCache::appendNodes(CacheFileWriter& writer, FolderData* folder, int parent, unsigned int& nodeCount)
+{
+	for (auto file : folder->getChildren())
+	{
+		const MetaDataList& mdl = file->getMetadata();
+
+		uint8_t type = (uint8_t)file->getType();
+		uint8_t flags = mdl.mRelativeTo != nullptr ? NODE_FLAG_RELATIVETO : 0;
+		if (file->isInGamelist())
+			flags |= NODE_FLAG_INGAMELIST;
+
+		writer.write(type);
+		writer.write(flags);
+		writer.write((int32_t)parent);
+		writer.write(writer.intern(file->getPath()));
+		appendMetadata(writer, mdl);
+
+		int32_t index = (int32_t)nodeCount++;
+
+		if (file->getType() == FOLDER)
+			appendNodes(writer, (FolderData*)file, index, nodeCount);
+	}
+}
+
+void GamelistCache::save(SystemData* system)
+{
+	if (!Settings::getInstance()->getBool("UseGamelistCache"))
+		return;
+
+	FolderData* root = system->getRootFolder();
+	if (root == nullptr || root->getChildren().size() == 0)
+		return;
+
+	std::string path = getCachePath(system);
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+	std::string xmlpath = system->getGamelistPath(false);
+
+	GamelistCacheHeader header;
+	header.magic = GAMELISTCACHE_MAGIC;
+	header.version = GAMELISTCACHE_VERSION;
+	header.settingsHash = getSettingsHash(system);
+	header.gamelistSize = Utils::FileSystem::getFileSize(xmlpath);
+	header.gamelistTime = (int64_t)Utils::FileSystem::getFileModificationDate(xmlpath).getTime();
+	header.folderCount = 0;
+	header.nodeCount = 0;
+
+	CacheFileWriter writer;
+
+	for (auto& stamp : system->getFolderStamps())
+	{
+		writer.write(writer.intern(stamp.path));
+		writer.write((int64_t)stamp.time);
+		header.folderCount++;
+	}
+
+	// Root node
+	const MetaDataList& rootMdl = root->getMetadata();
+
+	writer.write((uint8_t)FOLDER);
+	writer.write((uint8_t)(rootMdl.mRelativeTo != nullptr ? NODE_FLAG_RELATIVETO : 0));
+	writer.write((int32_t)-1);
+	writer.write(writer.intern(root->getPath()));
+	appendMetadata(writer, rootMdl);
+
+	header.nodeCount = 1;
+	appendNodes(writer, root, 0, header.nodeCount);
+
+	if (!writer.saveFile(path, header))
+		LOG(LogWarning) << "Unable to save gamelist cache \"" << path << "\"";
+}
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_CACHE_H
+#define ES_APP_GAMELIST_CACHE_H
+
+#include <string>
+#include <time.h>
+
+class SystemData;
+class FolderData;
+class CacheFileWriter;
+class MetaDataList;
+
+// Binary snapshot of a system's FolderData/FileData tree, used to skip the folder scan & the gamelist.xml parsing at boot.
+// gamelist.xml stays the reference format : the snapshot is rebuilt from it each time it is outdated.
+// A snapshot is valid as long as gamelist.xml size & date, and the date of every scanned folder, didn't change.
+class GamelistCache
+{
+public:
+	struct FolderStamp
+	{
+		std::string path;
+		time_t		time;
+	};
+
+	// Builds the system's tree from its snapshot. Returns false if there is none, or if it is outdated.
+	static bool load(SystemData* system);
+
+	// Writes the system's tree, as it is in memory, to its snapshot.
+	static void save(SystemData* system);
+
+	// Ignores existing snapshots until the current SystemData::loadConfig is completed ( forces a full rescan ).
+	static void resetCache();
+	static void onLoadConfigCompleted();
+
+private:
+	static std::string getCachePath(SystemData* system);
+	static unsigned long long getSettingsHash(SystemData* system);
+	static void appendMetadata(CacheFileWriter& writer, const MetaDataList& mdl);
+	static void appendNodes(CacheFileWriter& writer, FolderData* folder, int parent, unsigned int& nodeCount);
+
+	static bool sResetRequested;
+};
+
+#endif // ES_APP_GAMELIST_CACHE_H
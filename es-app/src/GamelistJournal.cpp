@@ -0,0 +1,313 @@
+#include "GamelistJournal.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/HashUtil.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "SystemData.h"
+#include <pugixml/src/pugixml.hpp>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define GAMELISTJOURNAL_MAGIC		0x4A474C45 // "ELGJ"
+#define GAMELISTJOURNAL_VERSION		1
+
+// Records are forced to disk every GAMELISTJOURNAL_SYNC_COUNT records, or on the first record written GAMELISTJOURNAL_SYNC_DELAY ms after the last sync
+#define GAMELISTJOURNAL_SYNC_COUNT	64
+#define GAMELISTJOURNAL_SYNC_DELAY	1000
+
+// File layout ( native endianness, like the gamelist cache )
+//
+//	Header
+//	records	: uint32 length, uint32 crc32 of the data, data ( the <game> or <folder> node, as in gamelist.xml ), for each record
+
+#pragma pack(push, 1)
+struct GamelistJournalHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t gamelistHash;
+};
+
+struct GamelistJournalRecord
+{
+	uint32_t length;
+	uint32_t crc;
+};
+#pragma pack(pop)
+
+struct GamelistJournalFile
+{
+	FILE* file;
+	uint64_t gamelistHash;
+	int pending;
+	std::chrono::steady_clock::time_point lastSync;
+};
+
+static std::mutex sJournalsLock;
+static std::map<std::string, GamelistJournalFile> sJournals;
+
+static void syncJournalFile(GamelistJournalFile& journal)
+{
+	if (journal.pending == 0)
+		return;
+
+	fflush(journal.file);
+#ifdef WIN32
+	_commit(_fileno(journal.file));
+#else
+	fsync(fileno(journal.file));
+#endif
+
+	journal.pending = 0;
+	journal.lastSync = std::chrono::steady_clock::now();
+}
+
+// sJournalsLock must be locked
+static void closeJournalFile(const std::string& path)
+{
+	auto it = sJournals.find(path);
+	if (it == sJournals.cend())
+		return;
+
+	syncJournalFile(it->second);
+	fclose(it->second.file);
+	sJournals.erase(it);
+}
+
+static bool readJournalHeader(const std::string& path, GamelistJournalHeader& header)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	bool ret = fread(&header, sizeof(header), 1, file) == 1 && header.magic == GAMELISTJOURNAL_MAGIC && header.version == GAMELISTJOURNAL_VERSION;
+	fclose(file);
+	return ret;
+}
+
+std::string GamelistJournal::getJournalPath(SystemData* system)
+{
+	return getGamelistRecoveryPath(system) + ".journal";
+}
+
+bool GamelistJournal::exists(SystemData* system)
+{
+	return Utils::FileSystem::exists(getJournalPath(system));
+}
+
+bool GamelistJournal::append(SystemData* system, const std::string& node)
+{
+	return append(getJournalPath(system), system->getGamelistHash(), node);
+}
+
+bool GamelistJournal::append(const std::string& path, size_t gamelistHash, const std::string& node)
+{
+	std::unique_lock<std::mutex> lock(sJournalsLock);
+
+	// gamelist.xml was saved without the journal being cleared : its records are stale
+	auto it = sJournals.find(path);
+	if (it != sJournals.cend() && it->second.gamelistHash != (uint64_t)gamelistHash)
+	{
+		closeJournalFile(path);
+		it = sJournals.end();
+	}
+
+	if (it == sJournals.cend())
+	{
+		GamelistJournalFile journal;
+		journal.gamelistHash = (uint64_t)gamelistHash;
+		journal.pending = 0;
+		journal.lastSync = std::chrono::steady_clock::now();
+
+		// Continue the existing journal, unless it was written for another version of gamelist.xml
+		GamelistJournalHeader header;
+		if (readJournalHeader(path, header) && header.gamelistHash == (uint64_t)gamelistHash)
+			journal.file = fopen(path.c_str(), "ab");
+		else
+		{
+			Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+			journal.file = fopen(path.c_str(), "wb");
+			if (journal.file != nullptr)
+			{
+				header.magic = GAMELISTJOURNAL_MAGIC;
+				header.version = GAMELISTJOURNAL_VERSION;
+				header.gamelistHash = (uint64_t)gamelistHash;
+
+				if (fwrite(&header, sizeof(header), 1, journal.file) != 1)
+				{
+					fclose(journal.file);
+					journal.file = nullptr;
+				}
+			}
+		}
+
+		if (journal.file == nullptr)
+		{
+			LOG(LogError) << "Error opening gamelist journal \"" << path << "\"!";
+			return false;
+		}
+
+		it = sJournals.insert(std::make_pair(path, journal)).first;
+	}
+
+	GamelistJournalFile& journal = it->second;
+
+	GamelistJournalRecord record;
+	record.length = (uint32_t)node.size();
+	record.crc = Utils::Hash::crc32(node.c_str(), node.size());
+
+	if (fwrite(&record, sizeof(record), 1, journal.file) != 1 || fwrite(node.c_str(), 1, node.size(), journal.file) != node.size())
+	{
+		LOG(LogError) << "Error writing gamelist journal \"" << path << "\"!";
+		return false;
+	}
+
+	// Flushed each time, so that the record survives if ES crashes. Only the fsync is batched
+	fflush(journal.file);
+	journal.pending++;
+
+	if (journal.pending >= GAMELISTJOURNAL_SYNC_COUNT ||
+		std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - journal.lastSync).count() >= GAMELISTJOURNAL_SYNC_DELAY)
+		syncJournalFile(journal);
+
+	return true;
+}
+
+bool GamelistJournal::replay(SystemData* system, size_t gamelistHash, const std::function<void(pugi::xml_node&)>& apply)
+{
+	return replay(getJournalPath(system), gamelistHash, apply);
+}
+
+bool GamelistJournal::replay(const std::string& path, size_t gamelistHash, const std::function<void(pugi::xml_node&)>& apply)
+{
+	if (!Utils::FileSystem::exists(path))
+		return false;
+
+	std::vector<char> data;
+
+	{
+		std::unique_lock<std::mutex> lock(sJournalsLock);
+		closeJournalFile(path);
+
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (file.is_open())
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	GamelistJournalHeader header;
+	if (data.size() < sizeof(header))
+	{
+		clear(path);
+		return false;
+	}
+
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != GAMELISTJOURNAL_MAGIC || header.version != GAMELISTJOURNAL_VERSION || header.gamelistHash != (uint64_t)gamelistHash)
+	{
+		LOG(LogWarning) << "Gamelist journal \"" << path << "\" doesn't match gamelist.xml! Ignoring.";
+		clear(path);
+		return false;
+	}
+
+	size_t offset = sizeof(header);
+	int count = 0;
+
+	while (data.size() - offset >= sizeof(GamelistJournalRecord))
+	{
+		GamelistJournalRecord record;
+		memcpy(&record, data.data() + offset, sizeof(record));
+
+		if (data.size() - offset - sizeof(record) < record.length)
+			break;
+
+		const char* chars = data.data() + offset + sizeof(record);
+		if (Utils::Hash::crc32(chars, record.length) != record.crc)
+			break;
+
+		pugi::xml_document doc;
+		if (doc.load_buffer(chars, record.length))
+		{
+			pugi::xml_node node = doc.first_child();
+			if (node)
+				apply(node);
+		}
+
+		offset += sizeof(record) + record.length;
+		count++;
+	}
+
+	if (offset < data.size())
+	{
+		LOG(LogWarning) << "Gamelist journal \"" << path << "\" ends with an incomplete record, " << (data.size() - offset) << " bytes dropped";
+
+		// Keep the valid records only, so that new records are not appended after the broken one
+		std::string tmpPath = path + ".tmp";
+
+		std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		file.write(data.data(), offset);
+		file.close();
+
+		if (!file.fail())
+		{
+#ifdef WIN32
+			Utils::FileSystem::removeFile(path);
+#endif
+			rename(tmpPath.c_str(), path.c_str());
+		}
+		else
+			Utils::FileSystem::removeFile(tmpPath);
+	}
+
+	LOG(LogInfo) << "Replayed " << count << " changes from gamelist journal \"" << path << "\"";
+	return true;
+}
+
+void GamelistJournal::clear(SystemData* system)
+{
+	clear(getJournalPath(system));
+}
+
+void GamelistJournal::clear(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(sJournalsLock);
+	closeJournalFile(path);
+
+	if (Utils::FileSystem::exists(path))
+		Utils::FileSystem::removeFile(path);
+}
+
+void GamelistJournal::sync()
+{
+	std::unique_lock<std::mutex> lock(sJournalsLock);
+
+	for (auto& it : sJournals)
+		syncJournalFile(it.second);
+}
+
+void GamelistJournal::close()
+{
+	std::unique_lock<std::mutex> lock(sJournalsLock);
+
+	for (auto& it : sJournals)
+	{
+		syncJournalFile(it.second);
+		fclose(it.second.file);
+	}
+
+	sJournals.clear();
+}
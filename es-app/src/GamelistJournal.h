@@ -0,0 +1,41 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_JOURNAL_H
+#define ES_APP_GAMELIST_JOURNAL_H
+
+#include <functional>
+#include <string>
+
+namespace pugi { class xml_node; }
+
+class SystemData;
+
+// Metadata changes that are not written to gamelist.xml yet, appended to a single file per system ( recovery/<system>.journal ).
+// The journal is replayed when the gamelist is parsed, and removed once gamelist.xml is saved.
+// Records are checksummed : a record truncated by a crash ends the replay, the records before it are kept.
+class GamelistJournal
+{
+public:
+	// Appends the XML node of a file, as written in gamelist.xml. Records are synced to disk by batches.
+	static bool append(SystemData* system, const std::string& node);
+
+	// Calls apply for each valid record, in the order they were written.
+	// A journal written for another version of gamelist.xml ( gamelistHash ) is discarded.
+	static bool replay(SystemData* system, size_t gamelistHash, const std::function<void(pugi::xml_node&)>& apply);
+
+	static bool exists(SystemData* system);
+	static void clear(SystemData* system);
+
+	// Same, on the journal file at path
+	static bool append(const std::string& path, size_t gamelistHash, const std::string& node);
+	static bool replay(const std::string& path, size_t gamelistHash, const std::function<void(pugi::xml_node&)>& apply);
+	static void clear(const std::string& path);
+
+	// Forces the pending records of every journal to disk. close() also closes the files.
+	static void sync();
+	static void close();
+
+private:
+	static std::string getJournalPath(SystemData* system);
+};
+
+#endif // ES_APP_GAMELIST_JOURNAL_H
@@ -5,18 +5,137 @@
 #include "Log.h"
 #include <pugixml/src/pugixml.hpp>
 #include "SystemData.h"
+#include "FileData.h"
 #include "LocaleES.h"
 #include "Settings.h"
+#include <mutex>
+#include <unordered_map>
 
 static std::vector<MetaDataDecl> gameMDD;
 static std::vector<MetaDataDecl> folderMDD;
 
-static std::string* mDefaultGameMap = nullptr;
+static const MetaDataValue** mDefaultGameMap = nullptr;
 static MetaDataType* mGameTypeMap = nullptr;
 
-static std::string* mDefaultFolderMap = nullptr;
+static const MetaDataValue** mDefaultFolderMap = nullptr;
 static MetaDataType* mFolderTypeMap = nullptr;
 
+// Interned values. They are never released : their count is bounded by the number of distinct genres, developers...
+static std::unordered_map<std::string, MetaDataValue*> mSharedValues;
+static std::mutex mSharedValuesLock;
+
+
+static double parseMetaDataNumber(const std::string& value)
+{
+	// Dates : "19950101T000000" -> 19950101000000
+	if (value.size() == 15 && value[8] == 'T')
+	{
+		double ret = 0;
+
+		for (int i = 0; i < 15; i++)
+		{
+			if (i == 8)
+				continue;
+
+			if (value[i] < '0' || value[i] > '9')
+				return atof(value.c_str());
+
+			ret = ret * 10 + (value[i] - '0');
+		}
+
+		return ret;
+	}
+
+	return atof(value.c_str());
+}
+
+MetaDataValue::MetaDataValue(const std::string& val) : value(val), number(parseMetaDataNumber(val)), mResolved(nullptr), mResolvedIsPrefix(false)
+{
+}
+
+static const MetaDataValue* getSharedValue(const std::string& value)
+{
+	std::unique_lock<std::mutex> lock(mSharedValuesLock);
+
+	auto it = mSharedValues.find(value);
+	if (it != mSharedValues.cend())
+		return it->second;
+
+	MetaDataValue* ret = new MetaDataValue(value);
+	mSharedValues[value] = ret;
+	return ret;
+}
+
+MetaDataValue::MetaDataValue(const std::string& val, const std::string& resolvedPath) : value(val), number(0), mResolved(nullptr), mResolvedIsPrefix(false)
+{
+	if (resolvedPath == val)
+		return;
+
+	size_t tail = val.size() - 1;
+	if (val.size() > 0 && resolvedPath.size() >= tail && resolvedPath.compare(resolvedPath.size() - tail, tail, val, 1, tail) == 0)
+	{
+		// The prefixes are interned with the shared values : one per ROM folder
+		mResolved = &getSharedValue(resolvedPath.substr(0, resolvedPath.size() - tail))->value;
+		mResolvedIsPrefix = true;
+	}
+	else
+		mResolved = new std::string(resolvedPath);
+}
+
+MetaDataValue::MetaDataValue(const MetaDataValue& other) : value(other.value), number(other.number), mResolvedIsPrefix(other.mResolvedIsPrefix)
+{
+	mResolved = (other.mResolved != nullptr && !other.mResolvedIsPrefix) ? new std::string(*other.mResolved) : other.mResolved;
+}
+
+MetaDataValue::~MetaDataValue()
+{
+	if (!mResolvedIsPrefix)
+		delete mResolved;
+}
+
+std::string MetaDataValue::getResolvedPath() const
+{
+	if (mResolved == nullptr)
+		return value;
+
+	if (!mResolvedIsPrefix)
+		return *mResolved;
+
+	std::string ret;
+	ret.reserve(mResolved->size() + value.size() - 1);
+	ret.append(*mResolved);
+	ret.append(value, 1, std::string::npos);
+	return ret;
+}
+
+// Values that are mostly unique to each game are owned by the MetaDataList, the others are shared
+static bool isOwnedValue(MetaDataId id)
+{
+	switch (id)
+	{
+	case Name:
+	case SortName:
+	case Desc:
+	case Image:
+	case Video:
+	case Marquee:
+	case Thumbnail:
+	case LastPlayed:
+	case Crc32:
+	case Md5:
+	case GameTime:
+		return true;
+	}
+
+	return false;
+}
+
+size_t MetaDataList::getSharedValuesCount()
+{
+	std::unique_lock<std::mutex> lock(mSharedValuesLock);
+	return mSharedValues.size();
+}
+
 static std::map<std::string, MetaDataId> mGameIdMap;
 static std::map<std::string, MetaDataId> mFolderIdMap;
 
@@ -103,15 +222,18 @@ void MetaDataList::initMetadata()
 		if (mDefaultGameMap != nullptr) delete[] mDefaultGameMap;
 		if (mGameTypeMap != nullptr) delete[] mGameTypeMap;
 
-		mDefaultGameMap = new std::string[maxID];
+		mDefaultGameMap = new const MetaDataValue*[maxID];
 		mGameTypeMap = new MetaDataType[maxID];
 
 		for (int i = 0; i < maxID; i++)
+		{
+			mDefaultGameMap[i] = getSharedValue("");
 			mGameTypeMap[i] = MD_STRING;
+		}
 		
 		for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
 		{
-			mDefaultGameMap[iter->id] = iter->defaultValue;
+			mDefaultGameMap[iter->id] = getSharedValue(iter->defaultValue);
 			mGameTypeMap[iter->id] = iter->type;
 			mGameIdMap[iter->key] = iter->id;
 		}
@@ -126,15 +248,18 @@ void MetaDataList::initMetadata()
 		if (mDefaultFolderMap != nullptr) delete[] mDefaultFolderMap;
 		if (mFolderTypeMap != nullptr) delete[] mFolderTypeMap;
 
-		mDefaultFolderMap = new std::string[maxID];
+		mDefaultFolderMap = new const MetaDataValue*[maxID];
 		mFolderTypeMap = new MetaDataType[maxID];
 
 		for (int i = 0; i < maxID; i++)
+		{
+			mDefaultFolderMap[i] = getSharedValue("");
 			mFolderTypeMap[i] = MD_STRING;
+		}
 
 		for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
 		{
-			mDefaultFolderMap[iter->id] = iter->defaultValue;
+			mDefaultFolderMap[iter->id] = getSharedValue(iter->defaultValue);
 			mFolderTypeMap[iter->id] = iter->type;
 			mFolderIdMap[iter->key] = iter->id;
 		}
@@ -151,14 +276,125 @@ MetaDataId MetaDataList::getId(const std::string& key) const
 	return mType == GAME_METADATA ? mGameIdMap[key] : mFolderIdMap[key];
 }
 
+const MetaDataValue* MetaDataList::getDefault(MetaDataId id) const
+{
+	return mType == GAME_METADATA ? mDefaultGameMap[id] : mDefaultFolderMap[id];
+}
+
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 {
 	return type == FOLDER_METADATA ? folderMDD : gameMDD;
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr), mOwner(nullptr)
+{
+	for (int i = 0; i < SlotCount; i++)
+		mValues[i] = nullptr;
+}
+
+MetaDataList::MetaDataList(const MetaDataList& other) : mType(other.mType), mWasChanged(other.mWasChanged), mRelativeTo(other.mRelativeTo), mOwner(nullptr)
+{
+	for (int i = 0; i < SlotCount; i++)
+		mValues[i] = nullptr;
+
+	copyValues(other);
+}
+
+MetaDataList::MetaDataList(MetaDataList&& other) : mType(other.mType), mWasChanged(other.mWasChanged), mRelativeTo(other.mRelativeTo), mOwner(nullptr)
+{
+	for (int i = 0; i < SlotCount; i++)
+	{
+		mValues[i] = other.mValues[i];
+		other.mValues[i] = nullptr;
+	}
+}
+
+MetaDataList::~MetaDataList()
+{
+	clearValues();
+}
+
+MetaDataList& MetaDataList::operator=(const MetaDataList& other)
+{
+	if (this != &other)
+	{
+		mType = other.mType;
+		setChanged(other.mWasChanged);
+		mRelativeTo = other.mRelativeTo;
+		copyValues(other);
+
+		if (mOwner != nullptr)
+			mOwner->onMetadataValueChanged();
+	}
+
+	return *this;
+}
+
+MetaDataList& MetaDataList::operator=(MetaDataList&& other)
+{
+	if (this != &other)
+	{
+		clearValues();
+
+		mType = other.mType;
+		setChanged(other.mWasChanged);
+		mRelativeTo = other.mRelativeTo;
+
+		for (int i = 0; i < SlotCount; i++)
+		{
+			mValues[i] = other.mValues[i];
+			other.mValues[i] = nullptr;
+		}
+
+		if (mOwner != nullptr)
+			mOwner->onMetadataValueChanged();
+	}
+
+	return *this;
+}
+
+void MetaDataList::clearValues()
 {
+	for (int i = 0; i < SlotCount; i++)
+	{
+		if (mValues[i] != nullptr && isOwnedValue((MetaDataId)i))
+			delete mValues[i];
 
+		mValues[i] = nullptr;
+	}
+}
+
+void MetaDataList::copyValues(const MetaDataList& other)
+{
+	clearValues();
+
+	for (int i = 0; i < SlotCount; i++)
+	{
+		if (other.mValues[i] != nullptr && isOwnedValue((MetaDataId)i))
+			mValues[i] = new MetaDataValue(*other.mValues[i]); // Same mRelativeTo : the resolved path is still valid
+		else
+			mValues[i] = other.mValues[i];
+	}
+}
+
+void MetaDataList::setValue(MetaDataId id, const std::string& value)
+{
+	if (id < 0 || id >= SlotCount)
+		return;
+
+	if (isOwnedValue(id))
+	{
+		if (mValues[id] != nullptr)
+			delete mValues[id];
+
+		// Paths are read far more often than they are set ( gamelist views, image loads... ) : resolved here, once
+		if (mRelativeTo != nullptr && getType(id) == MD_PATH)
+			mValues[id] = new MetaDataValue(value, Utils::FileSystem::resolveRelativePath(value, mRelativeTo->getStartPath(), true));
+		else
+			mValues[id] = new MetaDataValue(value);
+	}
+	else
+		mValues[id] = getSharedValue(value);
 }
 
 
@@ -193,12 +429,14 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 				value = Utils::String::replace(value, "1-", "");
 			
 			if (iter->id == 0)
-				mdl.mName = value;
+				mdl.setValue(MetaDataId::Name, value);
 			else
 				mdl.set(iter->key, value);
 		}
 	}
 
+	// Values read from the gamelist are not changes
+	mdl.mWasChanged = false;
 	return mdl;
 }
 
@@ -210,20 +448,20 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 	{
 		if (mddIter->id == 0)
 		{
-			parent.append_child("name").text().set(mName.c_str());
+			parent.append_child("name").text().set(getName().c_str());
 			continue;
 		}
 
-		auto mapIter = mMap.find(mddIter->id);
-		if(mapIter != mMap.cend())
+		const MetaDataValue* mdValue = mValues[mddIter->id];
+		if (mdValue != nullptr)
 		{
 			// we have this value!
 			// if it's just the default (and we ignore defaults), don't write it
-			if(ignoreDefaults && mapIter->second == mddIter->defaultValue)
+			if(ignoreDefaults && mdValue->value == mddIter->defaultValue)
 				continue;
 			
 			// try and make paths relative if we can
-			std::string value = mapIter->second;
+			std::string value = mdValue->value;
 			if (mddIter->type == MD_PATH)
 				value = Utils::FileSystem::createRelativePath(value, relativeTo, true);
 
@@ -234,17 +472,17 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 
 const std::string& MetaDataList::getName() const
 {
-	return mName;
+	return getValue(MetaDataId::Name);
 }
 
 void MetaDataList::set(const std::string& key, const std::string& value)
 {
 	if (key == "name")
 	{
-		if (mName == value)
+		if (getName() == value)
 			return;
 
-		mName = value;
+		setValue(MetaDataId::Name, value);
 	}
 	else
 	{
@@ -253,41 +491,53 @@ void MetaDataList::set(const std::string& key, const std::string& value)
 		// Players -> remove "1-"
 		if (mType == GAME_METADATA && id == 12 && Utils::String::startsWith(value, "1-")) // "players"
 		{
-			mMap[id] = Utils::String::replace(value, "1-", "");
+			setValue(id, Utils::String::replace(value, "1-", ""));
 			return;
 		}
 
-		auto prev = mMap.find(id);
-		if (prev != mMap.cend() && prev->second == value)
+		if (mValues[id] != nullptr && mValues[id]->value == value)
 			return;
 
 		if (getType(id) == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			mMap[id] = Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true);
+			setValue(id, Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true));
 		else
-			mMap[id] = Utils::String::trim(value);
+			setValue(id, Utils::String::trim(value));
 	}
 
-	mWasChanged = true;
+	setChanged(true);
+
+	if (mOwner != nullptr)
+		mOwner->onMetadataValueChanged();
 }
 
-const std::string MetaDataList::get(MetaDataId id, bool resolveRelativePaths) const
+const std::string& MetaDataList::getValue(MetaDataId id) const
 {
-	if (id == MetaDataId::Name)
-		return mName;
+	const MetaDataValue* value = mValues[id];
+	if (value == nullptr)
+		value = getDefault(id);
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
-	{
-		if (resolveRelativePaths && getType(id) == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+	return value->value;
+}
 
-		return it->second;
-	}
+double MetaDataList::getNumber(MetaDataId id) const
+{
+	const MetaDataValue* value = mValues[id];
+	if (value == nullptr)
+		value = getDefault(id);
 
-	if (mType == GAME_METADATA)
-		return mDefaultGameMap[id];
+	return value->number;
+}
 
-	return mDefaultFolderMap[id];
+const std::string MetaDataList::get(MetaDataId id, bool resolveRelativePaths) const
+{
+	const MetaDataValue* value = mValues[id];
+	if (value == nullptr)
+		return getDefault(id)->value;
+
+	if (resolveRelativePaths && mRelativeTo != nullptr)
+		return value->getResolvedPath();
+
+	return value->value;
 }
 
 const std::string MetaDataList::get(const std::string& key, bool resolveRelativePaths) const
@@ -297,12 +547,12 @@ const std::string MetaDataList::get(const std::string& key, bool resolveRelative
 
 int MetaDataList::getInt(const std::string& key) const
 {
-	return atoi(get(key).c_str());
+	return getInt(getId(key));
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
-	return (float)atof(get(key).c_str());
+	return getFloat(getId(key));
 }
 
 bool MetaDataList::wasChanged() const
@@ -312,7 +562,18 @@ bool MetaDataList::wasChanged() const
 
 void MetaDataList::resetChangedFlag()
 {
-	mWasChanged = false;
+	setChanged(false);
+}
+
+void MetaDataList::setChanged(bool changed)
+{
+	if (mWasChanged == changed)
+		return;
+
+	mWasChanged = changed;
+
+	if (mOwner != nullptr)
+		mOwner->onMetadataChanged(changed);
 }
 
 void MetaDataList::importScrappedMetadata(const MetaDataList& source)
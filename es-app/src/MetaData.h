@@ -3,10 +3,12 @@
 #define ES_APP_META_DATA_H
 
 #include <map>
+#include <string>
 #include <vector>
 #include <functional>
 
 class SystemData;
+class FileData;
 
 namespace pugi { class xml_node; }
 
@@ -110,8 +112,34 @@ enum MetaDataListType
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type);
 
+// An immutable metadata value, with its numeric conversion computed once.
+// Low cardinality values ( genres, developers, ratings, flags... ) are interned & shared by all the games,
+// the others ( names, paths, descriptions... ) are owned by their MetaDataList.
+struct MetaDataValue
+{
+	MetaDataValue(const std::string& val);
+	MetaDataValue(const std::string& val, const std::string& resolvedPath); // MD_PATH values, with their relative path resolved once
+	MetaDataValue(const MetaDataValue& other);
+	~MetaDataValue();
+
+	MetaDataValue& operator=(const MetaDataValue&) = delete;
+
+	std::string getResolvedPath() const;
+
+	const std::string	value;
+	const double		number; // atof of the value. Dates ( 19950101T000000 ) are packed as YYYYMMDDHHMMSS
+
+private:
+	// nullptr when the value resolves to itself. Most relative paths resolve to the ROM folder followed by the value without
+	// its leading '.' : only this prefix is kept, shared by all the games of the system
+	const std::string*	mResolved;
+	bool				mResolvedIsPrefix;
+};
+
 class MetaDataList
 {
+	friend class GamelistCache;
+
 public:
 	static void initMetadata();
 
@@ -119,22 +147,39 @@ public:
 	void appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const;
 
 	MetaDataList(MetaDataListType type);
+	MetaDataList(const MetaDataList& other);
+	MetaDataList(MetaDataList&& other);
+	~MetaDataList();
+
+	MetaDataList& operator=(const MetaDataList& other);
+	MetaDataList& operator=(MetaDataList&& other);
 	
 	void set(const std::string& key, const std::string& value);
 
 	const std::string get(MetaDataId id, bool resolveRelativePaths = true) const;
 	const std::string get(const std::string& key, bool resolveRelativePaths = true) const;
 
+	// Stored value, without copy. Relative paths are not resolved
+	const std::string& getValue(MetaDataId id) const;
+
 	int getInt(const std::string& key) const;
 	float getFloat(const std::string& key) const;
 
+	// Pre-parsed numeric values
+	int getInt(MetaDataId id) const { return (int)getNumber(id); }
+	float getFloat(MetaDataId id) const { return (float)getNumber(id); }
+	double getNumber(MetaDataId id) const;
+
 	bool wasChanged() const;
 	void resetChangedFlag();
 	const void setDirty() 
 	{ 
-		mWasChanged = true; 
+		setChanged(true);
 	}
 
+	// The owner is notified when the changed flag is set or reset ( SystemData dirty files ), and when a value is modified ( filter indexes )
+	void setOwner(FileData* owner) { mOwner = owner; }
+
 	inline MetaDataListType getType() const { return mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 
@@ -142,15 +187,27 @@ public:
 
 	void importScrappedMetadata(const MetaDataList& source);
 
+	static size_t getSharedValuesCount();
+
 private:
-	std::string		mName;
+	static const int SlotCount = MetaDataId::Region + 1;
+
 	MetaDataListType mType;
-	std::map<MetaDataId, std::string> mMap;
 	bool mWasChanged;
 	SystemData*		mRelativeTo;
+	FileData*		mOwner;
+
+	// One slot per MetaDataId, nullptr when the metadata has its default value
+	const MetaDataValue* mValues[SlotCount];
+
+	void setValue(MetaDataId id, const std::string& value);
+	void setChanged(bool changed);
+	void copyValues(const MetaDataList& other);
+	void clearValues();
 
 	inline MetaDataType getType(MetaDataId id) const;
 	inline MetaDataId getId(const std::string& key) const;
+	inline const MetaDataValue* getDefault(MetaDataId id) const;
 };
 
 #endif // ES_APP_META_DATA_H
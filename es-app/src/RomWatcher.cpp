@@ -0,0 +1,604 @@
+#include "RomWatcher.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "views/gamelist/IGameListView.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "FolderScanner.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "SystemData.h"
+#include "Window.h"
+#include <chrono>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define WATCHER_DEBOUNCE_MS 500
+#define WATCHER_POLL_MS 100
+
+RomWatcher* RomWatcher::mInstance = nullptr;
+
+namespace
+{
+	long long getTicks()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Path relative to the root folder of the system, false if the path is not inside
+	bool getRelativePath(SystemData* system, const std::string& path, std::string& relative)
+	{
+		const std::string& root = system->getRootFolder()->getPath();
+		if (path.size() <= root.size() + 1 || path.compare(0, root.size(), root) != 0 || path[root.size()] != '/')
+			return false;
+
+		relative = path.substr(root.size() + 1);
+		return true;
+	}
+
+	// Same rules as SystemData::populateFolder : media folders are never scanned, their files are only referenced by metadata
+	bool isMediaPath(SystemData* system, const std::string& path)
+	{
+		std::string parent = Utils::FileSystem::getParent(path);
+		if (parent != system->getRootFolder()->getPath() && FolderScanner::isMediaFolder(parent))
+			return true;
+
+		return Utils::FileSystem::isDirectory(path) && FolderScanner::isMediaFolder(path);
+	}
+
+	bool isHiddenPath(SystemData* system, const std::string& relative)
+	{
+		if (system->getShowHiddenFiles())
+			return false;
+
+		std::string path = system->getRootFolder()->getPath();
+		for (auto& name : Utils::FileSystem::getPathList(relative))
+		{
+			path = Utils::FileSystem::combine(path, name);
+			if (Utils::FileSystem::isHidden(path))
+				return true;
+		}
+
+		return false;
+	}
+
+	FileData* findChild(FolderData* folder, const std::string& path)
+	{
+		for (auto child : folder->getChildren())
+			if (child->getPath() == path)
+				return child;
+
+		return nullptr;
+	}
+
+	FileData* findFile(SystemData* system, const std::string& relative)
+	{
+		FileData* item = system->getRootFolder();
+
+		for (auto& name : Utils::FileSystem::getPathList(relative))
+		{
+			if (item->getType() != FOLDER)
+				return nullptr;
+
+			item = findChild((FolderData*)item, Utils::FileSystem::combine(item->getPath(), name));
+			if (item == nullptr)
+				return nullptr;
+		}
+
+		return item;
+	}
+
+	// The top level files of a grouped system are also referenced by a virtual folder of the group
+	FolderData* getGroupFolder(SystemData* system)
+	{
+		if (!system->isGroupChildSystem())
+			return nullptr;
+
+		SystemData* group = system->getParentGroupSystem();
+		if (group == system)
+			return nullptr;
+
+		for (auto child : group->getRootFolder()->getChildren())
+			if (child->getType() == FOLDER && child->getSystem() == system && ((FolderData*)child)->isVirtualStorage())
+				return (FolderData*)child;
+
+		return nullptr;
+	}
+
+	std::shared_ptr<IGameListView> getGameListView(SystemData* system)
+	{
+		return ViewController::get()->getGameListView(system->getParentGroupSystem(), false);
+	}
+
+	void addChild(SystemData* system, FolderData* folder, FileData* file)
+	{
+		folder->addChild(file);
+
+		if (folder == system->getRootFolder())
+		{
+			FolderData* groupFolder = getGroupFolder(system);
+			if (groupFolder != nullptr)
+				groupFolder->addChild(file, false);
+		}
+	}
+
+	// Returns the folder holding the path, creates the missing ones
+	FolderData* getParentFolder(SystemData* system, const std::string& relative)
+	{
+		FolderData* folder = system->getRootFolder();
+
+		auto names = Utils::FileSystem::getPathList(relative);
+		names.pop_back();
+
+		for (auto& name : names)
+		{
+			std::string path = Utils::FileSystem::combine(folder->getPath(), name);
+
+			FileData* item = findChild(folder, path);
+			if (item != nullptr && item->getType() != FOLDER)
+				return nullptr;
+
+			if (item == nullptr)
+			{
+				item = new FolderData(path, system);
+				addChild(system, folder, item);
+			}
+
+			folder = (FolderData*)item;
+		}
+
+		return folder;
+	}
+
+	FileData* addGame(SystemData* system, const std::string& path, const std::string& relative)
+	{
+		if (!system->getSystemEnvData()->isValidExtension(Utils::String::toLower(Utils::FileSystem::getExtension(path))))
+			return nullptr;
+
+		FileData* game = new FileData(GAME, path, system);
+		if (game->isArcadeAsset())
+		{
+			delete game;
+			return nullptr;
+		}
+
+		FolderData* folder = getParentFolder(system, relative);
+		if (folder == nullptr)
+		{
+			delete game;
+			return nullptr;
+		}
+
+		addChild(system, folder, game);
+		system->addToIndex(game);
+		return game;
+	}
+
+	// A folder was created or moved in : adds what populateFolder would have found
+	void addFolder(SystemData* system, const std::string& path, const std::string& relative, std::vector<FileData*>& added)
+	{
+		FileData* game = addGame(system, path, relative);
+		if (game != nullptr)
+		{
+			added.push_back(game);
+			return;
+		}
+
+		bool showHidden = system->getShowHiddenFiles();
+
+		for (auto& fileInfo : Utils::FileSystem::getDirectoryFiles(path))
+		{
+			if (!showHidden && fileInfo.hidden)
+				continue;
+
+			std::string childRelative = relative + "/" + Utils::FileSystem::getFileName(fileInfo.path);
+
+			if (findFile(system, childRelative) != nullptr)
+				continue;
+
+			game = addGame(system, fileInfo.path, childRelative);
+			if (game != nullptr)
+				added.push_back(game);
+			else if (fileInfo.directory && !FolderScanner::isMediaFolder(fileInfo.path))
+				addFolder(system, fileInfo.path, childRelative, added);
+		}
+	}
+
+	void removeFromGroup(SystemData* system, FileData* file)
+	{
+		FolderData* groupFolder = getGroupFolder(system);
+		if (groupFolder != nullptr && file->getParent() == system->getRootFolder())
+			groupFolder->removeChild(file);
+	}
+
+	// Returns true if folders were deleted
+	bool removeFile(SystemData* system, FileData* file)
+	{
+		if (file->getType() == FOLDER)
+		{
+			// Copy : the children are removed from the folder while iterating
+			std::vector<FileData*> children = ((FolderData*)file)->getChildren();
+			for (auto child : children)
+				removeFile(system, child);
+
+			if (((FolderData*)file)->getChildren().size() > 0)
+				return false;
+
+			removeFromGroup(system, file);
+			delete file; // Removes it from its parent
+			return true;
+		}
+
+		CollectionSystemManager::get()->deleteCollectionFiles(file);
+		removeFromGroup(system, file);
+
+		auto view = getGameListView(system);
+		if (view != nullptr)
+			view->remove(file, false);
+		else
+			delete file;
+
+		return false;
+	}
+
+	// populateFolder ignores folders that do not contain games
+	bool removeEmptyFolders(SystemData* system, FolderData* folder)
+	{
+		bool removed = false;
+
+		while (folder != nullptr && folder != system->getRootFolder() && folder->getChildren().size() == 0)
+		{
+			FolderData* parent = folder->getParent();
+
+			removeFromGroup(system, folder);
+			delete folder;
+			folder = parent;
+			removed = true;
+		}
+
+		return removed;
+	}
+
+	void onMediaChanged(SystemData* system, const std::string& path)
+	{
+		auto view = getGameListView(system);
+		if (view == nullptr)
+			return;
+
+		for (auto game : system->getRootFolder()->getFilesRecursive(GAME))
+		{
+			if (game->getMetadata(MetaDataId::Image) == path || game->getMetadata(MetaDataId::Thumbnail) == path ||
+				game->getMetadata(MetaDataId::Marquee) == path || game->getMetadata(MetaDataId::Video) == path)
+			{
+				view->onFileChanged(game, FILE_METADATA_CHANGED);
+				return; // The view reloads all its games
+			}
+		}
+	}
+
+	void addToFileMap(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
+	{
+		for (auto child : folder->getChildren())
+		{
+			fileMap[child->getPath()] = child;
+
+			if (child->getType() == FOLDER)
+				addToFileMap((FolderData*)child, fileMap);
+		}
+	}
+
+	// gamelist.xml was written by another program ( external scraper, manual edit... )
+	void reloadGamelist(SystemData* system)
+	{
+		if (system->hasDirtyFiles())
+		{
+			LOG(LogInfo) << "RomWatcher : " << system->getName() << " has unsaved metadata changes, gamelist.xml is not reloaded";
+			return;
+		}
+
+		LOG(LogInfo) << "RomWatcher : reloading gamelist of " << system->getName();
+
+		FolderData* root = system->getRootFolder();
+
+		std::unordered_map<FileData*, std::string> states;
+		for (auto game : root->getFilesRecursive(GAME))
+		{
+			system->removeFromIndex(game);
+			states[game] = game->getMetadata(MetaDataId::Favorite) + "|" + game->getMetadata(MetaDataId::PlayCount);
+		}
+
+		std::unordered_map<std::string, FileData*> fileMap;
+		addToFileMap(root, fileMap);
+		parseGamelist(system, fileMap);
+
+		for (auto game : root->getFilesRecursive(GAME))
+		{
+			system->addToIndex(game);
+
+			auto it = states.find(game);
+			if (it == states.cend())
+				CollectionSystemManager::get()->addToAutoCollections(game);
+			else if (it->second != game->getMetadata(MetaDataId::Favorite) + "|" + game->getMetadata(MetaDataId::PlayCount))
+				CollectionSystemManager::get()->refreshCollectionSystems(game);
+		}
+
+		auto view = getGameListView(system);
+		if (view != nullptr)
+			view->onFileChanged(root, FILE_METADATA_CHANGED);
+	}
+}
+
+void RomWatcher::applyChanges(const std::set<std::string>& paths)
+{
+	for (auto system : SystemData::sSystemVector)
+	{
+		if (system->isCollection() || system->getSystemEnvData() == nullptr || system->getSystemEnvData()->mStartPath.empty())
+			continue;
+
+		std::string gamelist = system->getRootFolder()->getPath() + "/gamelist.xml";
+
+		std::vector<FileData*> added;
+		std::vector<std::string> parents; // relative paths : the folders may be deleted meanwhile
+		bool removed = false;
+		bool foldersRemoved = false;
+
+		for (auto& path : paths)
+		{
+			if (path == gamelist)
+			{
+				reloadGamelist(system);
+				continue;
+			}
+
+			std::string relative;
+			if (!getRelativePath(system, path, relative))
+				continue;
+
+			if (isMediaPath(system, path))
+			{
+				onMediaChanged(system, path);
+				continue;
+			}
+
+			FileData* file = findFile(system, relative);
+
+			if (Utils::FileSystem::exists(path))
+			{
+				if (isHiddenPath(system, relative))
+					continue;
+
+				if (file == nullptr && !Utils::FileSystem::isDirectory(path))
+				{
+					FileData* game = addGame(system, path, relative);
+					if (game != nullptr)
+						added.push_back(game);
+				}
+				else if (file == nullptr || file->getType() == FOLDER)
+					addFolder(system, path, relative, added);
+			}
+			else if (file != nullptr)
+			{
+				LOG(LogInfo) << "RomWatcher : " << path << " removed";
+
+				if (relative.find('/') != std::string::npos)
+					parents.push_back(Utils::FileSystem::getParent(relative));
+
+				foldersRemoved |= removeFile(system, file);
+				removed = true;
+			}
+		}
+
+		for (auto game : added)
+		{
+			LOG(LogInfo) << "RomWatcher : " << game->getPath() << " added";
+			CollectionSystemManager::get()->addToAutoCollections(game);
+		}
+
+		for (auto& relative : parents)
+		{
+			FileData* folder = findFile(system, relative);
+			if (folder != nullptr && folder->getType() == FOLDER)
+				foldersRemoved |= removeEmptyFolders(system, (FolderData*)folder);
+		}
+
+		if (!removed && added.size() == 0)
+			continue;
+
+		system->updateDisplayedGameCount();
+		if (system->getParentGroupSystem() != system)
+			system->getParentGroupSystem()->updateDisplayedGameCount();
+
+		auto view = getGameListView(system);
+		if (view == nullptr)
+			continue;
+
+		// The view may be showing a folder that was deleted
+		if (foldersRemoved)
+			ViewController::get()->reloadGameListView(view.get());
+		else if (added.size() > 0)
+			view->onFileChanged(system->getRootFolder(), FILE_ADDED);
+	}
+}
+
+#if defined(__linux__)
+
+void RomWatcher::start(Window* window)
+{
+	if (mInstance != nullptr || window == nullptr)
+		return;
+
+	mInstance = new RomWatcher(window);
+}
+
+void RomWatcher::stop()
+{
+	if (mInstance == nullptr)
+		return;
+
+	delete mInstance;
+	mInstance = nullptr;
+}
+
+RomWatcher::RomWatcher(Window* window) : mWindow(window), mLastEvent(0), mHandle(nullptr), mExit(false)
+{
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (mFd < 0)
+	{
+		LOG(LogError) << "RomWatcher : inotify_init failed";
+		return;
+	}
+
+	// Watches are added on the calling thread, so that nothing is missed once start() returns
+	for (auto system : SystemData::sSystemVector)
+	{
+		if (system->isCollection() || system->getSystemEnvData() == nullptr || system->getSystemEnvData()->mStartPath.empty())
+			continue;
+
+		addWatch(system->getRootFolder()->getPath());
+	}
+
+	LOG(LogInfo) << "RomWatcher : watching " << mWatches.size() << " folders";
+
+	mHandle = new std::thread(&RomWatcher::run, this);
+}
+
+RomWatcher::~RomWatcher()
+{
+	mExit = true;
+
+	if (mHandle != nullptr)
+	{
+		mHandle->join();
+		delete mHandle;
+	}
+
+	if (mFd >= 0)
+		close(mFd);
+}
+
+void RomWatcher::addWatch(const std::string& path)
+{
+	if (mWatchedPaths.find(path) != mWatchedPaths.cend() || !Utils::FileSystem::isDirectory(path))
+		return;
+
+	int wd = inotify_add_watch(mFd, path.c_str(), IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+	if (wd < 0)
+	{
+		LOG(LogWarning) << "RomWatcher : unable to watch " << path << " (fs.inotify.max_user_watches ?)";
+		return;
+	}
+
+	mWatches[wd] = path;
+	mWatchedPaths.insert(path);
+
+	// Media folders are watched too : their files are not games, but they are referenced by metadata
+	for (auto& fileInfo : Utils::FileSystem::getDirectoryFiles(path))
+		if (fileInfo.directory)
+			addWatch(fileInfo.path);
+}
+
+void RomWatcher::removeWatch(const std::string& path)
+{
+	std::string prefix = path + "/";
+
+	for (auto it = mWatches.begin(); it != mWatches.end(); )
+	{
+		if (it->second == path || Utils::String::startsWith(it->second, prefix))
+		{
+			inotify_rm_watch(mFd, it->first);
+			mWatchedPaths.erase(it->second);
+			it = mWatches.erase(it);
+		}
+		else
+			it++;
+	}
+}
+
+void RomWatcher::readEvents()
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	while (true)
+	{
+		ssize_t len = read(mFd, buffer, sizeof(buffer));
+		if (len <= 0)
+			return;
+
+		for (char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len)
+		{
+			const struct inotify_event* evt = (const struct inotify_event*)ptr;
+
+			if (evt->mask & IN_Q_OVERFLOW)
+			{
+				LOG(LogWarning) << "RomWatcher : event queue overflow, some changes were missed. Update the gamelists to resync";
+				continue;
+			}
+
+			auto it = mWatches.find(evt->wd);
+			if (it == mWatches.cend())
+				continue;
+
+			if (evt->mask & IN_IGNORED)
+			{
+				mWatchedPaths.erase(it->second);
+				mWatches.erase(it);
+				continue;
+			}
+
+			if (evt->len == 0)
+				continue;
+
+			std::string path = it->second + "/" + evt->name;
+			mPending.insert(path);
+			mLastEvent = getTicks();
+
+			// Watch new folders right away, files copied inside are reported as well
+			if ((evt->mask & IN_ISDIR) && (evt->mask & (IN_CREATE | IN_MOVED_TO)))
+				addWatch(path);
+
+			// A moved folder keeps its watches, but they are known by the old path : drop them, the new path is
+			// watched on IN_MOVED_TO ( inside the tree ), and a folder created later at the old path is watched again
+			if ((evt->mask & IN_ISDIR) && (evt->mask & IN_MOVED_FROM))
+				removeWatch(path);
+		}
+	}
+}
+
+void RomWatcher::run()
+{
+	struct pollfd pfd;
+	pfd.fd = mFd;
+	pfd.events = POLLIN;
+
+	while (!mExit)
+	{
+		if (poll(&pfd, 1, WATCHER_POLL_MS) > 0 && (pfd.revents & POLLIN))
+			readEvents();
+
+		if (mPending.size() == 0 || getTicks() - mLastEvent < WATCHER_DEBOUNCE_MS)
+			continue;
+
+		std::set<std::string> paths;
+		std::swap(paths, mPending);
+
+		mWindow->postToUiThread([paths](Window* window) { RomWatcher::applyChanges(paths); });
+	}
+}
+
+#else
+
+void RomWatcher::start(Window* window)
+{
+	LOG(LogInfo) << "RomWatcher : not supported on this platform";
+}
+
+void RomWatcher::stop() { }
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef ES_APP_ROM_WATCHER_H
+#define ES_APP_ROM_WATCHER_H
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+
+class Window;
+
+// Watches the ROM folders of the loaded systems ( inotify, linux only ) and applies the added, removed & modified files
+// to the FolderData trees, the filter indexes and the auto collections, instead of reloading every system.
+// Media folders & gamelist.xml are watched as well. Events are collected on a thread, then applied on the UI thread
+// once the folders have been quiet for a moment.
+class RomWatcher
+{
+public:
+	static void start(Window* window);
+	static void stop();
+	static bool isRunning() { return mInstance != nullptr; }
+
+	// Applies a batch of changed paths to the loaded systems. UI thread only
+	static void applyChanges(const std::set<std::string>& paths);
+
+private:
+	RomWatcher(Window* window);
+	~RomWatcher();
+
+	void run();
+	void addWatch(const std::string& path); // recursive
+	void removeWatch(const std::string& path); // recursive
+	void readEvents();
+
+	Window*		mWindow;
+	int			mFd;
+
+	std::map<int, std::string>	mWatches;
+	std::set<std::string>		mWatchedPaths;
+
+	// Changed paths, waiting for the debounce delay. Watcher thread only
+	std::set<std::string>		mPending;
+	long long					mLastEvent;
+
+	std::thread*		mHandle;
+	std::atomic<bool>	mExit;
+
+	static RomWatcher* mInstance;
+};
+
+#endif // ES_APP_ROM_WATCHER_H
@@ -6,9 +6,13 @@
 #include "CollectionSystemManager.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
+#include "FolderScanner.h"
 #include "Gamelist.h"
+#include "GamelistJournal.h"
 #include "Log.h"
 #include "platform.h"
+#include "Profiler.h"
+#include "RomWatcher.h"
 #include "Settings.h"
 #include "ThemeData.h"
 #include "views/UIModeController.h"
@@ -32,7 +36,12 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 	mIsGroupSystem = groupedSystem;
 	mGameListHash = 0;
 	mGameCount = -1;
+	mDisplayGeneration = 0;
+	mMetadataGeneration = 0;
 	mSortId = Settings::getInstance()->getInt(getName() + ".sort");
+	mShowHiddenFilesSetting = Settings::Key(getName() + ".ShowHiddenFiles");
+	mFolderViewModeSetting = Settings::Key(getName() + ".FolderViewMode");
+	mHiddenExtSetting = Settings::Key(getName() + ".HiddenExt");
 	mGridSizeOverride = Vector2f(0, 0);
 
 	mFilterIndex = nullptr;
@@ -46,18 +55,34 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 		mRootFolder = new FolderData(mEnvData->mStartPath, this);
 		mRootFolder->getMetadata().set("name", mFullName);
 
-		std::unordered_map<std::string, FileData*> fileMap;
-		fileMap[mEnvData->mStartPath] = mRootFolder;
-
-		if (!Settings::getInstance()->getBool("ParseGamelistOnly"))
+		if (!GamelistCache::load(this))
 		{
-			populateFolder(mRootFolder, fileMap);
-			if (mRootFolder->getChildren().size() == 0)
-				return;
-		}
+			std::unordered_map<std::string, FileData*> fileMap;
+			fileMap[mEnvData->mStartPath] = mRootFolder;
+
+			if (!Settings::getInstance()->getBool("ParseGamelistOnly"))
+			{
+				if (Settings::getInstance()->getBool("ThreadedLoading"))
+				{
+					// Enumerate the folders in parallel first, the tree is then built from the listings in a single thread
+					FolderScanner scanner(mEnvData, getShowHiddenFiles());
+					scanner.scan(mEnvData->mStartPath);
+					populateFolder(mRootFolder, fileMap, &scanner);
+				}
+				else
+					populateFolder(mRootFolder, fileMap);
+
+				if (mRootFolder->getChildren().size() == 0)
+					return;
+			}
+
+			if (!Settings::getInstance()->getBool("IgnoreGamelist") && mName != "imageviewer")
+				parseGamelist(this, fileMap);
 
-		if(!Settings::getInstance()->getBool("IgnoreGamelist") && mName != "imageviewer")
-			parseGamelist(this, fileMap);
+			// Pending recovery changes are merged into gamelist.xml at exit, the snapshot will be rebuilt after that
+			if (!hasGamelistRecovery(this))
+				GamelistCache::save(this);
+		}
 	}
 	else
 	{
@@ -77,10 +102,17 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 
 SystemData::~SystemData()
 {
-	delete mRootFolder;
-
+	// The index goes first : its games don't have to be removed from it one by one
 	if (mFilterIndex != nullptr)
+	{
 		delete mFilterIndex;
+		mFilterIndex = nullptr;
+	}
+
+	delete mRootFolder;
+
+	// getChildrenListToDisplay keys its cached lists by the address of the system, which can be reused
+	FolderData::invalidateDisplayCache();
 }
 
 void SystemData::setIsGameSystemStatus()
@@ -91,7 +123,57 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mName != "retropie");
 }
 
-void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
+bool SystemData::getShowHiddenFiles()
+{
+	static Settings::Key showHiddenFiles("ShowHiddenFiles");
+
+	bool showHidden = Settings::getInstance()->getBool(showHiddenFiles);
+
+	auto shv = getShowHiddenFilesOverride();
+	if (shv == "1") showHidden = true;
+	else if (shv == "0") showHidden = false;
+
+	return showHidden;
+}
+
+std::string SystemData::getShowHiddenFilesOverride()
+{
+	return Settings::getInstance()->getString(mShowHiddenFilesSetting);
+}
+
+std::string SystemData::getFolderViewModeOverride()
+{
+	return Settings::getInstance()->getString(mFolderViewModeSetting);
+}
+
+std::string SystemData::getHiddenExtensions()
+{
+	return Settings::getInstance()->getString(mHiddenExtSetting);
+}
+
+void SystemData::setDirtyFile(FileData* file, bool dirty)
+{
+	std::unique_lock<std::mutex> lock(mDirtyFilesLock);
+
+	if (dirty)
+		mDirtyFiles.insert(file);
+	else
+		mDirtyFiles.erase(file);
+}
+
+bool SystemData::hasDirtyFiles()
+{
+	std::unique_lock<std::mutex> lock(mDirtyFilesLock);
+	return mDirtyFiles.size() > 0;
+}
+
+std::vector<FileData*> SystemData::getDirtyFiles()
+{
+	std::unique_lock<std::mutex> lock(mDirtyFilesLock);
+	return std::vector<FileData*>(mDirtyFiles.cbegin(), mDirtyFiles.cend());
+}
+
+void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap, FolderScanner* scanner)
 {
 	const std::string& folderPath = folder->getPath();
 	if(!Utils::FileSystem::isDirectory(folderPath))
@@ -114,13 +196,27 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 	std::string filePath;
 	std::string extension;
 	bool isGame;
-	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
+	bool showHidden = getShowHiddenFiles();
 
-	auto shv = Settings::getInstance()->getString(getName() + ".ShowHiddenFiles");
-	if (shv == "1") showHidden = true;
-	else if (shv == "0") showHidden = false;
+	GamelistCache::FolderStamp stamp;
+	stamp.path = folderPath;
+
+	Utils::FileSystem::fileList dirContent;
+
+	FolderScanner::Listing* listing = scanner != nullptr ? scanner->getListing(folderPath) : nullptr;
+	if (listing != nullptr)
+	{
+		stamp.time = listing->time;
+		dirContent = std::move(listing->files);
+	}
+	else
+	{
+		stamp.time = Utils::FileSystem::getFileModificationDate(folderPath).getTime();
+		dirContent = Utils::FileSystem::getDirectoryFiles(folderPath);
+	}
+
+	mFolderStamps.push_back(stamp);
 
-	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirectoryFiles(folderPath);
 	for (auto fileInfo : dirContent)
 	{
 		filePath = fileInfo.path;
@@ -154,14 +250,11 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		if(!isGame && fileInfo.directory)
 		{
 			// Don't loose time looking in downloaded_images, downloaded_videos & media folders
-			if (filePath.rfind("downloaded_") != std::string::npos || 
-				filePath.rfind("media") != std::string::npos || 
-				filePath.rfind("images") != std::string::npos ||
-				filePath.rfind("videos") != std::string::npos)
+			if (FolderScanner::isMediaFolder(filePath))
 				continue;
 
 			FolderData* newFolder = new FolderData(filePath, this);
-			populateFolder(newFolder, fileMap);
+			populateFolder(newFolder, fileMap, scanner);
 
 			//ignore folders that do not contain games
 			if(newFolder->getChildren().size() == 0)
@@ -685,6 +778,8 @@ bool SystemData::isFeatureSupported(std::string emulatorName, std::string coreNa
 //creates systems from information located in a config file
 bool SystemData::loadConfig(Window* window)
 {
+	PROFILE_ZONE("SystemData::loadConfig");
+
 	deleteSystems();
 	ThemeData::setDefaultTheme(nullptr);
 
@@ -738,19 +833,19 @@ bool SystemData::loadConfig(Window* window)
 
 	typedef SystemData* SystemDataPtr;
 
-	ThreadPool* pThreadPool = NULL;
+	TaskGroup* pThreadPool = NULL;
 	SystemDataPtr* systems = NULL;
 
 	// Allow threaded loading only if processor threads > 2 so it does not apply on machines like Pi0.
 	if (std::thread::hardware_concurrency() > 2 && Settings::getInstance()->getBool("ThreadedLoading"))
 	{
-		pThreadPool = new ThreadPool();
+		pThreadPool = new TaskGroup();
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
 			systems[i] = nullptr;
 
-		pThreadPool->queueWorkItem([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
+		pThreadPool->run([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
 	}
 
 	int processedSystem = 0;
@@ -759,7 +854,7 @@ bool SystemData::loadConfig(Window* window)
 	{
 		if (pThreadPool != NULL)
 		{
-			pThreadPool->queueWorkItem([system, currentSystem, systems, &processedSystem]
+			pThreadPool->run([system, currentSystem, systems, &processedSystem]
 			{
 				systems[currentSystem] = loadSystem(system);
 				processedSystem++;
@@ -831,18 +926,24 @@ bool SystemData::loadConfig(Window* window)
 	}
 
 	loadFeatures();
+	GamelistCache::onLoadConfigCompleted();
 
 	if (window != nullptr && SystemConf::getInstance()->getBool("global.netplay") && !ThreadedHasher::isRunning())
 	{
 		if (Settings::getInstance()->getBool("NetPlayCheckIndexesAtStart"))
 			ThreadedHasher::start(window, false, true);
 	}
+
+	if (window != nullptr && Settings::getInstance()->getBool("WatchRomFolders"))
+		RomWatcher::start(window);
 	
 	return true;
 }
 
 SystemData* SystemData::loadSystem(pugi::xml_node system)
 {
+	PROFILE_ZONE("SystemData::loadSystem");
+
 	std::string name, fullname, path, cmd, themeFolder;
 
 	name = system.child("name").text().get();
@@ -1026,6 +1127,8 @@ bool SystemData::hasDirtySystems()
 
 void SystemData::deleteSystems()
 {
+	RomWatcher::stop();
+
 	bool saveOnExit = !Settings::getInstance()->getBool("IgnoreGamelist") && Settings::getInstance()->getBool("SaveGamelistsOnExit");
 
 	for (unsigned int i = 0; i < sSystemVector.size(); i++)
@@ -1039,6 +1142,7 @@ void SystemData::deleteSystems()
 		delete pData;
 	}
 
+	GamelistJournal::close();
 	sSystemVector.clear();
 }
 
@@ -4,7 +4,9 @@
 
 #include "PlatformId.h"
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
@@ -12,10 +14,13 @@
 #include <unordered_map>
 #include <unordered_set>
 #include "FileFilterIndex.h"
+#include "GamelistCache.h"
 #include "math/Vector2f.h"
+#include "Settings.h"
 
 class FileData;
 class FolderData;
+class FolderScanner;
 class ThemeData;
 class Window;
 
@@ -204,6 +209,22 @@ public:
 	void setGamelistHash(size_t size) { mGameListHash = size; }
 	size_t getGamelistHash() { return mGameListHash; }
 
+	// Files having metadata changes that are not written to gamelist.xml yet
+	void setDirtyFile(FileData* file, bool dirty);
+	bool hasDirtyFiles();
+	std::vector<FileData*> getDirtyFiles();
+
+	bool getShowHiddenFiles();
+
+	// Per-system settings, "" when not overriden
+	std::string getShowHiddenFilesOverride();
+	std::string getFolderViewModeOverride();
+	std::string getHiddenExtensions();
+
+	// Folders enumerated by populateFolder, with their modification date. Used to validate the gamelist cache.
+	const std::vector<GamelistCache::FolderStamp>& getFolderStamps() { return mFolderStamps; }
+	void setFolderStamps(const std::vector<GamelistCache::FolderStamp>& stamps) { mFolderStamps = stamps; }
+
 	bool isNetplaySupported();
 	static bool isNetplayActivated();
 
@@ -226,10 +247,26 @@ public:
 
 	FileFilterIndex* getFilterIndex() { return mFilterIndex; }
 
+	// Bumped when the files of the system are added, removed or changed : the folders drop the lists cached by getChildrenListToDisplay
+	unsigned int getDisplayGeneration() const { return mDisplayGeneration; }
+	void invalidateDisplayCache() { mDisplayGeneration++; }
+
+	// Bumped each time a metadata value of one of the games of the system changes, the game keeps the new value :
+	// the filter indexes containing games of the system index the changed ones again
+	unsigned int getMetadataGeneration() const { return mMetadataGeneration; }
+	unsigned int onMetadataValueChanged() { return ++mMetadataGeneration; }
+
 private:
 	static void createGroupedSystems();
 
 	size_t mGameListHash;
+	std::vector<GamelistCache::FolderStamp> mFolderStamps;
+
+	std::mutex mDirtyFilesLock;
+	std::unordered_set<FileData*> mDirtyFiles;
+
+	std::atomic<unsigned int> mDisplayGeneration;
+	std::atomic<unsigned int> mMetadataGeneration;
 
 	bool mIsCollectionSystem;
 	bool mIsGameSystem;
@@ -241,7 +278,7 @@ private:
 	std::string mThemeFolder;
 	std::shared_ptr<ThemeData> mTheme;
 
-	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap);
+	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap, FolderScanner* scanner = nullptr);
 	void indexAllGameFilters(const FolderData* folder);
 	void setIsGameSystemStatus();
 	
@@ -255,6 +292,11 @@ private:
 	
 	unsigned int mSortId;
 	std::string mViewMode;
+
+	Settings::Key mShowHiddenFilesSetting;
+	Settings::Key mFolderViewModeSetting;
+	Settings::Key mHiddenExtSetting;
+
 	Vector2f    mGridSizeOverride;	
 
 	int			mGameCount;
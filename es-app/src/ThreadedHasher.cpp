@@ -5,6 +5,7 @@
 #include "LocaleES.h"
 #include "guis/GuiMsgBox.h"
 #include "Gamelist.h"
+#include "GamelistJournal.h"
 
 #include "SystemConf.h"
 #include "SystemData.h"
@@ -12,10 +13,16 @@
 #include <unordered_set>
 #include <queue>
 #include "ApiSystem.h"
+#include "FileHasher.h"
 #include "utils/StringUtil.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
 
 #define ICONINDEX _U("\uF1EC ")
 
+// Files hashed at the same time
+#define HASHER_MAX_TASKS 4
+
 ThreadedHasher* ThreadedHasher::mInstance = nullptr;
 bool ThreadedHasher::mPaused = false;
 
@@ -23,6 +30,7 @@ ThreadedHasher::ThreadedHasher(Window* window, std::queue<FileData*> searchQueue
 	: mWindow(window)
 {
 	mExit = false;
+	mRunningTasks = 0;
 
 	mSearchQueue = searchQueue;
 	mTotal = mSearchQueue.size();
@@ -49,16 +57,7 @@ std::string ThreadedHasher::formatGameName(FileData* game)
 
 void ThreadedHasher::hashFile(FileData* fileData)
 {
-	std::string systemName = fileData->getSystemName();
-
-	std::string idx = std::to_string(mTotal + 1 - mSearchQueue.size()) + "/" + std::to_string(mTotal);
-	int percent = 100 - (mSearchQueue.size() * 100 / mTotal);
-
-	
-	mWndNotification->updateText(formatGameName(fileData));
-	mWndNotification->updatePercent(percent);
-
-	auto crc = ApiSystem::getInstance()->getCRC32(fileData->getPath(), !fileData->isArcadeAsset());
+	auto crc = FileHasher::getCRC32(fileData->getPath(), !fileData->isArcadeAsset());
 	if (!crc.empty())
 	{
 		fileData->setMetadata("crc32", Utils::String::toUpper(crc));
@@ -71,6 +70,11 @@ void ThreadedHasher::hashFile(FileData* fileData)
 
 void ThreadedHasher::run()
 {
+	// Files are read sequentially & the hashing is I/O bound : more parallel reads on a SD card or a HDD would only add seeks
+	int maxTasks = std::max(1, std::min(Utils::ThreadPool::getInstance()->getThreadCount(), HASHER_MAX_TASKS));
+
+	Utils::TaskGroup tasks;
+
 	while (!mExit && !mSearchQueue.empty())
 	{
 		if (mPaused)
@@ -82,10 +86,32 @@ void ThreadedHasher::run()
 			}
 		}
 
-		hashFile(mSearchQueue.front());
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			mEvent.wait(lock, [this, maxTasks] { return mRunningTasks < maxTasks; });
+			mRunningTasks++;
+		}
+
+		FileData* fileData = mSearchQueue.front();
 		mSearchQueue.pop();
+
+		mWndNotification->updateText(formatGameName(fileData));
+		mWndNotification->updatePercent(100 - (mSearchQueue.size() * 100 / mTotal));
+
+		tasks.run([this, fileData]
+		{
+			hashFile(fileData);
+
+			std::unique_lock<std::mutex> lock(mLock);
+			mRunningTasks--;
+			mEvent.notify_one();
+		});
 	}
 
+	tasks.wait();
+
+	GamelistJournal::sync();
+
 	delete this;
 	ThreadedHasher::mInstance = nullptr;
 }
@@ -2,6 +2,8 @@
 
 #include <thread>
 #include <queue>
+#include <mutex>
+#include <condition_variable>
 #include "components/AsyncNotificationComponent.h"
 
 class FileData;
@@ -35,6 +37,11 @@ private:
 
 	std::thread* mHandle;
 
+	// Files being hashed on the ThreadPool
+	std::mutex mLock;
+	std::condition_variable mEvent;
+	int mRunningTasks;
+
 	int mTotal;
 	bool mExit;
 
@@ -308,6 +308,8 @@ void TextListComponent<T>::update(int deltaTime)
 {
 	listUpdate(deltaTime);
 
+	int prevMarqueeOffset = mMarqueeOffset;
+
 	if(!isScrolling() && size() > 0)
 	{
 		// always reset the marquee offsets
@@ -341,6 +343,9 @@ void TextListComponent<T>::update(int deltaTime)
 		}
 	}
 
+	if(mMarqueeOffset != prevMarqueeOffset)
+		Window::invalidate();
+
 	GuiComponent::update(deltaTime);
 }
 
@@ -19,6 +19,8 @@
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "GamelistCache.h"
+#include "RomWatcher.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
@@ -603,6 +605,21 @@ void GuiMenu::openDeveloperSettings()
 	s->addWithLabel(_("SEARCH FOR LOCAL ART"), local_art);
 	s->addSaveFunc([local_art] { Settings::getInstance()->setBool("LocalArt", local_art->getState()); });
 
+	// apply added & removed roms without reloading the gamelists
+	auto watch_roms = std::make_shared<SwitchComponent>(mWindow);
+	watch_roms->setState(Settings::getInstance()->getBool("WatchRomFolders"));
+	s->addWithLabel(_("WATCH ROM FOLDERS"), watch_roms);
+	s->addSaveFunc([this, watch_roms]
+	{
+		if (Settings::getInstance()->setBool("WatchRomFolders", watch_roms->getState()))
+		{
+			if (watch_roms->getState())
+				RomWatcher::start(mWindow);
+			else
+				RomWatcher::stop();
+		}
+	});
+
 	s->addEntry(_("RESET FILE EXTENSIONS"), false, [this, s]
 	{
 		for (auto system : SystemData::sSystemVector)
@@ -1680,6 +1697,7 @@ void GuiMenu::updateGameLists(Window* window)
 	
 	window->pushGui(new GuiMsgBox(window, _("REALLY UPDATE GAMES LISTS ?"), _("YES"), [window]
 		{
+			GamelistCache::resetCache();
 			reloadAllGames(window, true);
 		}, 
 		_("NO"), nullptr));
@@ -2786,7 +2804,6 @@ void GuiMenu::openUISettings()
 	{ 
 		if (Settings::getInstance()->setBool("ShowFilenames", showFilesnames->getState()))
 		{
-			FileData::resetSettings();
 			s->setVariable("reloadCollections", true);
 			s->setVariable("reloadAll", true);
 		}
@@ -42,9 +42,13 @@ void GuiSettings::save()
 	if(!mSaveFuncs.size())
 		return;
 
+	// One settings snapshot for the whole page
+	Settings::getInstance()->beginUpdate();
+
 	for(auto it = mSaveFuncs.cbegin(); it != mSaveFuncs.cend(); it++)
 		(*it)();
 
+	Settings::getInstance()->endUpdate();
 	Settings::getInstance()->saveFile();
 	SystemConf::getInstance()->saveSystemConf();
 }
@@ -30,6 +30,9 @@
 #include "ThreadedHasher.h"
 #include <FreeImage.h>
 #include "ImageIO.h"
+#include "resources/Font.h"
+#include "resources/TextureResource.h"
+#include "utils/ThreadPool.h"
 #include "components/VideoVlcComponent.h"
 #include <csignal>
 
@@ -39,6 +42,8 @@
 #define PATH_MAX MAX_PATH
 #endif
 
+#define IDLE_WAIT_MS 100
+
 static bool scrape_cmdline = false;
 static std::string gPlayVideo;
 static int gPlayVideoDuration = 0;
@@ -151,6 +156,9 @@ bool parseArgs(int argc, char* argv[])
 		}else if(strcmp(argv[i], "--draw-framerate") == 0)
 		{
 			Settings::getInstance()->setBool("DrawFramerate", true);
+		}else if(strcmp(argv[i], "--profile") == 0)
+		{
+			Settings::getInstance()->setBool("Profiler", true);
 		}else if(strcmp(argv[i], "--no-exit") == 0)
 		{
 			Settings::getInstance()->setBool("ShowExit", false);
@@ -199,6 +207,17 @@ bool parseArgs(int argc, char* argv[])
 		{
 			Settings::getInstance()->setBool("ForceDisableFilters", true);
 		}
+		else if (strcmp(argv[i], "--headless-dump") == 0)
+		{
+			if (i >= argc - 1)
+			{
+				std::cerr << "Invalid headless dump path supplied.";
+				return false;
+			}
+
+			Settings::getInstance()->setString("HeadlessDumpPath", argv[i + 1]);
+			i++; // skip the path
+		}
 		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
 		{
 #ifdef WIN32
@@ -218,6 +237,7 @@ bool parseArgs(int argc, char* argv[])
 				"--gamelist-only			skip automatic game search, only read from gamelist.xml\n"
 				"--ignore-gamelist		ignore the gamelist (useful for troubleshooting)\n"
 				"--draw-framerate		display the framerate\n"
+				"--profile			record timing zones from startup, Ctrl-P saves a trace\n"
 				"--no-exit			don't show the exit option in the menu\n"
 				"--no-splash			don't show the splash screen\n"
 				"--debug				more logging, show console on Windows\n"
@@ -230,6 +250,7 @@ bool parseArgs(int argc, char* argv[])
 				"--force-disable-filters		Force the UI to ignore applied filters in gamelist\n"
 				"--home [path]		Directory to use as home path\n"
 				"--help, -h			summon a sentient, angry tuba\n\n"
+				"--headless-dump [path]		with the headless renderer, save rendered frames to path\n"
 				"--monitor [index]			monitor index\n\n"				
 				"More information available in README.md.\n";
 			return false; //exit after printing help
@@ -590,13 +611,19 @@ int main(int argc, char* argv[])
 
 	bool running = true;
 
+	bool idle = false;
+
 	while(running)
 	{
 		SDL_Event event;
+		bool hadEvent = false;
 
+		// Nothing moved during the previous frame : wait for input, and keep updating a few times per second for the timers
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
-		if(ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+		if(ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : idle ? SDL_WaitEventTimeout(&event, IDLE_WAIT_MS) : SDL_PollEvent(&event))
 		{
+			hadEvent = true;
+
 			// PowerSaver can push events to exit SDL_WaitEventTimeout immediatly
 			// Reset this event's state
 			TRYCATCH("resetRefreshEvent", PowerSaver::resetRefreshEvent());
@@ -641,13 +668,22 @@ int main(int argc, char* argv[])
 			deltaTime = 1000;
 
 		TRYCATCH("Window.update" ,window.update(deltaTime))	
-		TRYCATCH("Window.render", window.render())
 
-		Renderer::swapBuffers();
+		idle = Settings::getInstance()->getBool("IdleFrameSkip") && !window.needsRender(hadEvent);
+		if (idle)
+			window.skipFrame();
+		else
+		{
+			TRYCATCH("Window.render", window.render())
+			Renderer::swapBuffers();
+		}
 
 		Log::flush();
 	}
 
+	if (Settings::getInstance()->getBool("IdleFrameSkip"))
+		LOG(LogInfo) << "Idle frame skipping : " << window.getSkippedFrames() << " frames skipped";
+
 	if (isFastShutdown())
 		Settings::getInstance()->setBool("IgnoreGamelist", true);
 
@@ -661,10 +697,15 @@ int main(int argc, char* argv[])
 		window.renderSplashScreen(_("SAVING METADATAS. PLEASE WAIT..."));
 
 	ImageIO::saveImageCache();
+	Font::saveGlyphCache();
 	MameNames::deinit();
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
 
+	// Nothing left to load : the workers only finish what they are running, then they are joined
+	TextureResource::cancelAllAsync();
+	Utils::ThreadPool::deinit();
+
 	// call this ONLY when linking with FreeImage as a static library
 #ifdef FREEIMAGE_LIB
 	FreeImage_DeInitialise();
@@ -7,6 +7,7 @@
 #include "Settings.h"
 #include "SystemData.h"
 #include <FreeImage.h>
+#include <algorithm>
 #include <fstream>
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
@@ -100,6 +101,78 @@ void ScraperSearchHandle::update()
 
 
 
+// ScraperRateLimiter
+#define RATELIMIT_MAX_PENALTY	4
+#define RATELIMIT_RECOVERY		10 // Successful requests needed to raise the number of games in flight again
+
+std::mutex ScraperRateLimiter::sInstancesLock;
+std::map<std::string, ScraperRateLimiter*> ScraperRateLimiter::sInstances;
+
+ScraperRateLimiter::ScraperRateLimiter() : mPenalty(0), mSuccessCount(0)
+{
+	mPausedUntil = std::chrono::steady_clock::now();
+}
+
+ScraperRateLimiter* ScraperRateLimiter::getInstance()
+{
+	std::string name = Settings::getInstance()->getString("Scraper");
+
+	std::unique_lock<std::mutex> lock(sInstancesLock);
+
+	auto it = sInstances.find(name);
+	if (it != sInstances.cend())
+		return it->second;
+
+	ScraperRateLimiter* instance = new ScraperRateLimiter();
+	sInstances[name] = instance;
+	return instance;
+}
+
+void ScraperRateLimiter::onSuccess()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (mPenalty == 0)
+		return;
+
+	mSuccessCount++;
+	if (mSuccessCount >= RATELIMIT_RECOVERY)
+	{
+		mSuccessCount = 0;
+		mPenalty--;
+	}
+}
+
+void ScraperRateLimiter::onTooManyRequests(int retryCount)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto until = std::chrono::steady_clock::now() + std::chrono::seconds(retryCount < 3 ? 5 : 10);
+	if (until > mPausedUntil)
+		mPausedUntil = until;
+
+	mSuccessCount = 0;
+	if (mPenalty < RATELIMIT_MAX_PENALTY)
+		mPenalty++;
+}
+
+bool ScraperRateLimiter::isPaused()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	return std::chrono::steady_clock::now() < mPausedUntil;
+}
+
+int ScraperRateLimiter::getMaxGames(int configured)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	return std::max(1, configured >> mPenalty);
+}
+
+bool ScraperRateLimiter::canStartGame(int inFlight, int configured)
+{
+	return inFlight < getMaxGames(configured) && !isPaused();
+}
+
 // ScraperRequest
 ScraperRequest::ScraperRequest(std::vector<ScraperSearchResult>& resultsWrite) : mResults(resultsWrite)
 {
@@ -122,6 +195,16 @@ ScraperHttpRequest::~ScraperHttpRequest()
 
 void ScraperHttpRequest::update()
 {
+	// Waiting for the rate limiter before retrying
+	if (mRequest == nullptr)
+	{
+		if (ScraperRateLimiter::getInstance()->isPaused())
+			return;
+
+		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying";
+		mRequest = new HttpReq(mRetryUrl);
+	}
+
 	HttpReq::Status status = mRequest->status();
 
 	// not ready yet
@@ -130,6 +213,8 @@ void ScraperHttpRequest::update()
 
 	if(status == HttpReq::REQ_SUCCESS)
 	{
+		ScraperRateLimiter::getInstance()->onSuccess();
+
 		setStatus(ASYNC_DONE); // if process() has an error, status will be changed to ASYNC_ERROR
 		process(mRequest, mResults);
 		return;
@@ -148,14 +233,11 @@ void ScraperHttpRequest::update()
 
 		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Wait before Retrying";
 
-		std::string url = mRequest->getUrl();
-		std::this_thread::sleep_for(std::chrono::seconds(mRetryCount < 3 ? 5 : 10));
-		
-		delete mRequest;
-		mRequest = new HttpReq(url);
-
-		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying";
+		ScraperRateLimiter::getInstance()->onTooManyRequests(mRetryCount);
 
+		mRetryUrl = mRequest->getUrl();
+		delete mRequest;
+		mRequest = nullptr;
 		return;
 	}
 
@@ -382,7 +464,7 @@ std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url,
 }
 
 ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::string& path, int maxWidth, int maxHeight) : 
-	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight)
+	mRetryCount(0), mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight)
 {
 	mRequest = new HttpReq(url, path);
 }
@@ -394,7 +476,7 @@ ImageDownloadHandle::~ImageDownloadHandle()
 
 int ImageDownloadHandle::getPercent()
 {
-	if (mRequest->status() == HttpReq::REQ_IN_PROGRESS)
+	if (mRequest != nullptr && mRequest->status() == HttpReq::REQ_IN_PROGRESS)
 		return mRequest->getPercent();
 
 	return -1;
@@ -402,6 +484,16 @@ int ImageDownloadHandle::getPercent()
 
 void ImageDownloadHandle::update()
 {
+	// Waiting for the rate limiter before retrying
+	if (mRequest == nullptr)
+	{
+		if (ScraperRateLimiter::getInstance()->isPaused())
+			return;
+
+		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying";
+		mRequest = new HttpReq(mRetryUrl, mSavePath);
+	}
+
 	HttpReq::Status status = mRequest->status();
 
 	if (status == HttpReq::REQ_IN_PROGRESS)
@@ -420,17 +512,17 @@ void ImageDownloadHandle::update()
 
 		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Wait before Retrying";
 
-		std::string url = mRequest->getUrl();
-		std::this_thread::sleep_for(std::chrono::seconds(mRetryCount < 3 ? 5 : 10));
+		ScraperRateLimiter::getInstance()->onTooManyRequests(mRetryCount);
 
+		mRetryUrl = mRequest->getUrl();
 		delete mRequest;
-		mRequest = new HttpReq(url, mSavePath);
-
-		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying";
-
+		mRequest = nullptr;
 		return;
 	}
 
+	if (status == HttpReq::REQ_SUCCESS)
+		ScraperRateLimiter::getInstance()->onSuccess();
+
 	// Ignored errors
 	if (status == HttpReq::REQ_404_NOTFOUND || status == HttpReq::REQ_IO_ERROR)
 	{
@@ -5,8 +5,11 @@
 #include "AsyncHandle.h"
 #include "HttpReq.h"
 #include "MetaData.h"
+#include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <queue>
 #include <utility>
 #include <assert.h>
@@ -102,6 +105,7 @@ protected:
 private:
 	HttpReq* mRequest;
 	int	mRetryCount;
+	std::string mRetryUrl;
 };
 
 // a request to get a list of results
@@ -120,6 +124,34 @@ protected:
 	std::vector<ScraperSearchResult> mResults;
 };
 
+// Shared by all the requests of the current scraper : a 429 answer pauses every request instead of sleeping in the one which got it,
+// and lowers the number of games ThreadedScraper keeps in flight until the server accepts requests again.
+class ScraperRateLimiter
+{
+public:
+	static ScraperRateLimiter* getInstance();
+
+	void onSuccess();
+	void onTooManyRequests(int retryCount);
+
+	bool isPaused();
+	int getMaxGames(int configured);
+
+	// Back-pressure : no new game while paused, and fewer games in flight after a 429
+	bool canStartGame(int inFlight, int configured);
+
+private:
+	ScraperRateLimiter();
+
+	std::mutex mLock;
+	std::chrono::steady_clock::time_point mPausedUntil;
+	int mPenalty;
+	int mSuccessCount;
+
+	static std::mutex sInstancesLock;
+	static std::map<std::string, ScraperRateLimiter*> sInstances;
+};
+
 // will use the current scraper settings to pick the result source
 std::unique_ptr<ScraperSearchHandle> startScraperSearch(const ScraperSearchParams& params);
 
@@ -204,6 +236,7 @@ public:
 private:
 	HttpReq* mRequest;
 	int	mRetryCount;
+	std::string mRetryUrl;
 
 	std::string mSavePath;
 	int mMaxWidth;
@@ -10,7 +10,7 @@
 #include <pugixml/src/pugixml.hpp>
 #include <cstring>
 #include "SystemConf.h"
-#include "md5.h"
+#include "FileHasher.h"
 #include <thread>
 #include "LangParser.h"
 
@@ -182,37 +182,9 @@ void screenscraper_generate_scraper_requests(const ScraperSearchParams& params,
 		int length = Utils::FileSystem::getFileSize(params.game->getFullPath());
 		if (length <= 131072 * 1024) // 128 Mb max
 		{
-			try
-			{
-				// 64 Kb blocks
-				#define MD5BUFFERSIZE 64 * 1024
-
-				char* buffer = new char[MD5BUFFERSIZE];
-				if (buffer)
-				{
-					size_t size;
-
-					FILE* file = fopen(params.game->getFullPath().c_str(), "rb");
-					if (file)
-					{
-						MD5 md5 = MD5();
-
-						while (size = fread(buffer, 1, MD5BUFFERSIZE, file))
-							md5.update(buffer, size);
-
-						md5.finalize();
-
-						std::string val = md5.hexdigest();
-						if (!val.empty())
-							path += "&md5=" + val;
-
-						fclose(file);
-					}
-
-					delete buffer;
-				}
-			}
-			catch (std::bad_alloc& ex) {}
+			std::string val = FileHasher::getMD5(params.game->getFullPath());
+			if (!val.empty())
+				path += "&md5=" + val;
 		}
 	}
 	else
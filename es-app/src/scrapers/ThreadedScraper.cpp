@@ -5,9 +5,14 @@
 #include "LocaleES.h"
 #include "guis/GuiMsgBox.h"
 #include "Gamelist.h"
+#include "GamelistJournal.h"
 #include "Log.h"
+#include "Profiler.h"
+#include "Settings.h"
+#include <algorithm>
 
 #define GUIICON _U("\uF03E ")
+#define SCRAPER_MAX_GAMES 8
 
 ThreadedScraper* ThreadedScraper::mInstance = nullptr;
 bool ThreadedScraper::mPaused = false;
@@ -17,11 +22,12 @@ ThreadedScraper::ThreadedScraper(Window* window, const std::queue<ScraperSearchP
 {
 	mExit = false;
 	mTotal = (int) mSearchQueue.size();
+	mStarted = 0;
+	mMaxGames = std::max(1, std::min(Settings::getInstance()->getInt("ScraperThreads"), SCRAPER_MAX_GAMES));
 
 	mWndNotification = new AsyncNotificationComponent(window);
 
 	mWindow->registerNotificationComponent(mWndNotification);
-	search(mSearchQueue.front());
 	mHandle = new std::thread(&ThreadedScraper::run, this);	
 }
 
@@ -40,21 +46,16 @@ std::string ThreadedScraper::formatGameName(FileData* game)
 
 void ThreadedScraper::search(const ScraperSearchParams& params)
 {
-	LOG(LogDebug) << "ThreadedScraper::formatGameName";
+	PROFILE_ZONE("ThreadedScraper::search");
 
-	std::string gameName = formatGameName(params.game);
+	LOG(LogInfo) << "ThreadedScraper::search >> " << formatGameName(params.game);
 
-	LOG(LogInfo) << "ThreadedScraper::search >> " << gameName;
+	ScrapeJob* job = new ScrapeJob();
+	job->params = params;
+	job->search = startScraperSearch(params);
+	mJobs.push_back(std::unique_ptr<ScrapeJob>(job));
 
-	mCurrentAction = "";
-	mLastSearch = params;
-	mSearchHandle = startScraperSearch(params);
-
-	std::string idx = std::to_string(mTotal + 1 - mSearchQueue.size()) + "/" + std::to_string(mTotal);
-
-	mWndNotification->updateTitle(GUIICON + _("SCRAPING") + "... " + idx);
-	mWndNotification->updateText(gameName, _("Searching")+"...");
-	mWndNotification->updatePercent(-1);
+	mStarted++;
 
 	LOG(LogDebug) << "ThreadedScraper::search <<";
 }
@@ -72,93 +73,157 @@ void ThreadedScraper::processError(int status, const std::string statusString)
 		mErrors.push_back(statusString);
 }
 
-void ThreadedScraper::run()
+// Moves a game to its next stage, returns false while its current request is still running
+bool ThreadedScraper::updateJob(ScrapeJob* job)
 {
-	while (!mExit && !mSearchQueue.empty())
+	PROFILE_ZONE("ThreadedScraper::updateJob");
+
+	if (job->search)
 	{
-		if (mPaused)
+		if (job->search->status() == ASYNC_IN_PROGRESS)
+			return false;
+
+		auto status = job->search->status();
+		auto results = job->search->getResults();
+		auto statusString = job->search->getStatusString();
+		auto httpCode = job->search->getErrorCode();
+
+		LOG(LogDebug) << "ThreadedScraper::SearchResponse : " << httpCode << " " << statusString;
+
+		job->search.reset();
+
+		if (status == ASYNC_DONE)
 		{
-			while (!mExit && mPaused)
+			if (results.size() > 0)
 			{
-				std::this_thread::yield();
-				std::this_thread::sleep_for(std::chrono::milliseconds(500));
+				if (results[0].hadMedia())
+					processMedias(job, results[0]);
+				else
+					acceptResult(job->params.game, results[0]);
 			}
 		}
+		else if (status == ASYNC_ERROR)
+			processError(httpCode, statusString);
 
-		if (mSearchHandle && mSearchHandle->status() != ASYNC_IN_PROGRESS)
-		{
-			auto status = mSearchHandle->status();
-			auto results = mSearchHandle->getResults();
-			auto statusString = mSearchHandle->getStatusString();
-			auto httpCode = mSearchHandle->getErrorCode();
+		return true;
+	}
 
-			LOG(LogDebug) << "ThreadedScraper::SearchResponse : " << httpCode << " " << statusString;
+	if (job->resolve)
+	{
+		if (job->resolve->status() == ASYNC_IN_PROGRESS)
+			return false;
 
-			mSearchHandle.reset();
+		auto status = job->resolve->status();
+		auto result = job->resolve->getResult();
+		auto statusString = job->resolve->getStatusString();
+		auto httpCode = job->resolve->getErrorCode();
 
-			if (status == ASYNC_DONE)
-			{
-				if (results.size() > 0)
-				{
-					if (results[0].hadMedia())
-						processMedias(results[0]);
-					else
-						acceptResult(results[0]);
-				}
-			}
-			else if (status == ASYNC_ERROR)
-				processError(httpCode, statusString);				
-		}
+		LOG(LogDebug) << "ThreadedScraper::ResolveResponse : " << statusString;
 
-		if (mMDResolveHandle && mMDResolveHandle->status() != ASYNC_IN_PROGRESS)
-		{
-			auto status = mMDResolveHandle->status();
-			auto result = mMDResolveHandle->getResult();
-			auto statusString = mMDResolveHandle->getStatusString();
-			auto httpCode = mMDResolveHandle->getErrorCode();
+		job->resolve.reset();
+
+		if (status == ASYNC_DONE)
+			acceptResult(job->params.game, result);
+		else if (status == ASYNC_ERROR)
+			processError(httpCode, statusString);
+
+		return true;
+	}
+
+	return true;
+}
 
-			LOG(LogDebug) << "ThreadedScraper::ResolveResponse : " << statusString;
+void ThreadedScraper::updateNotification()
+{
+	mWndNotification->updateTitle(GUIICON + _("SCRAPING") + "... " + std::to_string(mStarted) + "/" + std::to_string(mTotal));
 
-			mCurrentAction = "";
-			mMDResolveHandle.reset();
+	if (mJobs.empty())
+		return;
 
-			if (status == ASYNC_DONE)
-				acceptResult(result);
-			else if (status == ASYNC_ERROR)
-				processError(httpCode, statusString);
+	// Show the oldest game still downloading medias, or the oldest one being searched
+	ScrapeJob* job = mJobs.front().get();
+	for (auto& it : mJobs)
+	{
+		if (it->resolve)
+		{
+			job = it.get();
+			break;
 		}
+	}
+
+	std::string gameName = formatGameName(job->params.game);
 
-		if (mMDResolveHandle && mMDResolveHandle->status() == ASYNC_IN_PROGRESS)
+	if (job->resolve)
+	{
+		std::string action = job->resolve->getCurrentItem();
+		if (action != mCurrentAction || gameName != mCurrentGame)
 		{
-			std::string action = mMDResolveHandle->getCurrentItem();
-			if (action != mCurrentAction)
+			mCurrentAction = action;
+			mCurrentGame = gameName;
+			mWndNotification->updateText(gameName, _("Downloading") + " " + mCurrentAction);
+		}
+
+		mWndNotification->updatePercent(job->resolve->getPercent());
+	}
+	else if (mCurrentAction != "" || gameName != mCurrentGame)
+	{
+		mCurrentAction = "";
+		mCurrentGame = gameName;
+		mWndNotification->updateText(gameName, _("Searching") + "...");
+		mWndNotification->updatePercent(-1);
+	}
+}
+
+void ThreadedScraper::run()
+{
+	auto limiter = ScraperRateLimiter::getInstance();
+
+	while (!mExit && (!mSearchQueue.empty() || !mJobs.empty()))
+	{
+		if (mPaused)
+		{
+			while (!mExit && mPaused)
 			{
-				mCurrentAction = action;
-				mWndNotification->updateText(formatGameName(mLastSearch.game), _("Downloading") + " " + mCurrentAction);
+				std::this_thread::yield();
+				std::this_thread::sleep_for(std::chrono::milliseconds(500));
 			}
-
-			mWndNotification->updatePercent(mMDResolveHandle->getPercent());
 		}
 
-		if (mSearchHandle == nullptr && mMDResolveHandle == nullptr)
+		while (!mSearchQueue.empty() && limiter->canStartGame((int) mJobs.size(), mMaxGames))
 		{
+			search(mSearchQueue.front());
 			mSearchQueue.pop();
+		}
 
-			if (mSearchQueue.empty())
-			{
-				LOG(LogDebug) << "ThreadedScraper::finished";
-				break;
-			}
-			
-			search(mSearchQueue.front());
+		bool progress = false;
+
+		for (auto it = mJobs.begin(); it != mJobs.end() && !mExit; )
+		{
+			ScrapeJob* job = it->get();
+			if (updateJob(job))
+				progress = true;
+
+			if (job->search == nullptr && job->resolve == nullptr)
+				it = mJobs.erase(it);
+			else
+				it++;
 		}
-		else
+
+		updateNotification();
+
+		if (!progress)
 		{
 			std::this_thread::yield();
 			std::this_thread::sleep_for(std::chrono::milliseconds(10));
 		}
 	}
-	
+
+	LOG(LogDebug) << "ThreadedScraper::finished";
+
+	mJobs.clear();
+
+	GamelistJournal::sync();
+
 	if (!mExit)
 		mWindow->displayNotificationMessage(GUIICON + _("SCRAPING FINISHED. REFRESH UPDATE GAMES LISTS TO APPLY CHANGES."));
 
@@ -166,21 +231,17 @@ void ThreadedScraper::run()
 	ThreadedScraper::mInstance = nullptr;
 }
 
-void ThreadedScraper::processMedias(ScraperSearchResult result)
+void ThreadedScraper::processMedias(ScrapeJob* job, ScraperSearchResult result)
 {
 	LOG(LogDebug) << "ThreadedScraper::processMedias >>";
-	mMDResolveHandle = resolveMetaDataAssets(result, mLastSearch);
+	job->resolve = resolveMetaDataAssets(result, job->params);
 	LOG(LogDebug) << "ThreadedScraper::processMedias <<";
 }
 
-void ThreadedScraper::acceptResult(const ScraperSearchResult& result)
+void ThreadedScraper::acceptResult(FileData* game, const ScraperSearchResult& result)
 {
 	LOG(LogDebug) << "ThreadedScraper::acceptResult >>";
 
-	ScraperSearchParams& search = mSearchQueue.front();
-
-	auto game = search.game;
-
 	mWindow->postToUiThread([game, result](Window* w)
 	{
 		LOG(LogDebug) << "ThreadedScraper::importScrappedMetadata";
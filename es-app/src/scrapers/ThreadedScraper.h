@@ -1,6 +1,7 @@
 #pragma once
 
 #include <thread>
+#include <list>
 #include "Scraper.h"
 #include "components/AsyncNotificationComponent.h"
 
@@ -21,6 +22,7 @@ private:
 	Window* mWindow;
 	AsyncNotificationComponent* mWndNotification;
 	std::string		mCurrentAction;
+	std::string		mCurrentGame;
 
 	std::vector<std::string> mErrors;
 
@@ -29,18 +31,28 @@ private:
 	std::thread* mHandle;
 	std::queue<ScraperSearchParams> mSearchQueue;
 
-	ScraperSearchParams mLastSearch;
-	std::unique_ptr<ScraperSearchHandle> mSearchHandle;
-	std::unique_ptr<MDResolveHandle> mMDResolveHandle;
+	// A game going through the pipeline : searching, then downloading its medias
+	struct ScrapeJob
+	{
+		ScraperSearchParams params;
+		std::unique_ptr<ScraperSearchHandle> search;
+		std::unique_ptr<MDResolveHandle> resolve;
+	};
+
+	std::list<std::unique_ptr<ScrapeJob>> mJobs;
 
 	void search(const ScraperSearchParams& params);
-	void processMedias(ScraperSearchResult result);
-	void acceptResult(const ScraperSearchResult& result);
+	bool updateJob(ScrapeJob* job);
+	void updateNotification();
+	void processMedias(ScrapeJob* job, ScraperSearchResult result);
+	void acceptResult(FileData* game, const ScraperSearchResult& result);
 	void processError(int status, const std::string statusString);
 
 	std::string formatGameName(FileData* game);
 
 	int mTotal;
+	int mStarted;
+	int mMaxGames;
 	bool mExit;
 
 	static bool mPaused;
@@ -21,6 +21,7 @@
 #include "AudioManager.h"
 #include "FileSorts.h"
 #include "CollectionSystemManager.h"
+#include "resources/TextureResource.h"
 
 ViewController* ViewController::sInstance = NULL;
 
@@ -235,6 +236,9 @@ void ViewController::playViewTransition(bool forceImmediate)
 	if(target == -mCamera.translation() && !isAnimationPlaying(0))
 		return;
 
+	// The textures queued for the previous view are dropped, the ones of the new view are requested as they are drawn
+	TextureResource::cancelAllAsync();
+
 	std::string transition_style = Settings::getInstance()->getString("TransitionStyle");
 	if(transition_style == "fade")
 	{
@@ -285,6 +289,13 @@ void ViewController::playViewTransition(bool forceImmediate)
 
 void ViewController::onFileChanged(FileData* file, FileChangeType change)
 {
+	// Also when no view shows the system ( games of a grouped system are shown by the group )
+	if (change != FILE_SORTED)
+	{
+		file->getSystem()->invalidateDisplayCache();
+		file->getSystem()->getParentGroupSystem()->invalidateDisplayCache();
+	}
+
 	auto it = mGameListViews.find(file->getSystem());
 	if(it != mGameListViews.cend())
 		it->second->onFileChanged(file, change);
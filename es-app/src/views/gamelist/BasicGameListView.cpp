@@ -39,6 +39,9 @@ void BasicGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 
 void BasicGameListView::onFileChanged(FileData* file, FileChangeType change)
 {
+	if (change != FILE_SORTED)
+		invalidateDisplayCache(file);
+
 	if(change == FILE_METADATA_CHANGED)
 	{
 		// might switch to a detailed view
@@ -324,6 +324,9 @@ void GridGameListView::remove(FileData *game, bool deleteFile)
 
 void GridGameListView::onFileChanged(FileData* file, FileChangeType change)
 {
+	if (change != FILE_SORTED)
+		invalidateDisplayCache(file);
+
 	if (change == FILE_METADATA_CHANGED)
 	{
 		// might switch to a detailed view
@@ -71,8 +71,18 @@ void ISimpleGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme
 	}
 }
 
-void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType /*change*/)
+// The lists of the file's system, and of this view's system when it shows the file through a group or a collection
+void ISimpleGameListView::invalidateDisplayCache(FileData* file)
 {
+	file->getSystem()->invalidateDisplayCache();
+	mRoot->getSystem()->invalidateDisplayCache();
+}
+
+void ISimpleGameListView::onFileChanged(FileData* file, FileChangeType change)
+{
+	if (change != FILE_SORTED)
+		invalidateDisplayCache(file);
+
 	// we could be tricky here to be efficient;
 	// but this shouldn't happen very often so we'll just always repopulate
 	FileData* cursor = getCursor();
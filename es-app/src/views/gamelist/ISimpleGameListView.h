@@ -41,6 +41,7 @@ public:
 protected:
 	FileData* getRandomGame();
 	void	  updateFolderPath();
+	void	  invalidateDisplayCache(FileData* file);
 
 	virtual std::string getQuickSystemSelectRightButton() = 0;
 	virtual std::string getQuickSystemSelectLeftButton() = 0;
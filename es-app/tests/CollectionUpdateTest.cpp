@@ -0,0 +1,262 @@
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "MetaData.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include "views/ViewController.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <functional>
+#include <stdlib.h>
+#include <unistd.h>
+
+// What a favorite toggle or a game launch costs in the auto collections ( CollectionSystemManager::refreshCollectionSystems ),
+// and the children by path index they rely on.
+
+namespace
+{
+	class CollectionUpdateTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
+			Settings::getInstance()->setBool("IgnoreGamelist", true);
+			Settings::getInstance()->setBool("UseGamelistCache", false);
+
+			MetaDataList::initMetadata();
+
+			ViewController::init(nullptr);
+			CollectionSystemManager::init(nullptr);
+
+			CollectionSystemManager::get()->loadCollectionSystems(false);
+			SystemData::sSystemVector.clear();
+		}
+
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-collections-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mRoot = tmp;
+		}
+
+		void TearDown() override
+		{
+			for (auto name : { "favorites", "recent" })
+			{
+				CollectionSystemData& data = collection(name);
+				data.system->getRootFolder()->clear();
+				data.isPopulated = false;
+			}
+
+			SystemData::sSystemVector.clear();
+
+			for (auto system : mSystems)
+				delete system;
+
+			for (auto envData : mEnvData)
+				delete envData;
+
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		// A system of count games, which only exist in memory. One in 100 is a favorite, one in 200 was played
+		SystemData* createSystem(const std::string& name, int count)
+		{
+			std::string folder = mRoot + "/" + name;
+			Utils::FileSystem::createDirectory(folder);
+
+			SystemEnvironmentData* envData = new SystemEnvironmentData();
+			envData->mStartPath = folder;
+			envData->mSearchExtensions = { ".zip" };
+			envData->mPlatformIds = { PlatformIds::PLATFORM_UNKNOWN };
+			mEnvData.push_back(envData);
+
+			SystemData* system = new SystemData(name, name, envData, name, nullptr);
+			SystemData::sSystemVector.push_back(system);
+			mSystems.push_back(system);
+
+			for (int i = 0; i < count; i++)
+			{
+				char file[32];
+				snprintf(file, sizeof(file), "/game%06d.zip", i);
+
+				FileData* game = new FileData(GAME, folder + file, system);
+
+				auto& md = game->getMetadata();
+				md.set("name", "Game " + std::to_string(i));
+				if (i % 100 == 0)
+					md.set("favorite", "true");
+
+				if (i % 200 == 0)
+					play(game, i);
+
+				system->getRootFolder()->addChild(game);
+			}
+
+			return system;
+		}
+
+		static CollectionSystemData& collection(const std::string& name)
+		{
+			return CollectionSystemManager::get()->getAutoCollectionSystems()[name];
+		}
+
+		static void populate(const std::string& name)
+		{
+			CollectionSystemManager::get()->populateAutoCollection(&collection(name));
+		}
+
+		static const std::vector<FileData*>& children(const std::string& name)
+		{
+			return collection(name).system->getRootFolder()->getChildren();
+		}
+
+		// As FileData::launchGame records a game session, at a given time
+		static void play(FileData* game, int time)
+		{
+			char date[32];
+			snprintf(date, sizeof(date), "2020%04dT%06d", 101 + time / 1000000, time % 1000000);
+
+			game->getMetadata().set("playcount", std::to_string(game->getMetadata().getInt("playcount") + 1));
+			game->getMetadata().set("lastplayed", date);
+		}
+
+		static void setFavorite(FileData* game, bool favorite)
+		{
+			game->getMetadata().set("favorite", favorite ? "true" : "false");
+			CollectionSystemManager::get()->refreshCollectionSystems(game);
+		}
+
+		std::string mRoot;
+		std::vector<SystemEnvironmentData*> mEnvData;
+		std::vector<SystemData*> mSystems;
+	};
+}
+
+TEST_F(CollectionUpdateTest, RecentStaysSorted)
+{
+	SystemData* system = createSystem("a", 2000);
+	populate("recent");
+
+	auto& games = system->getRootFolder()->getChildren();
+
+	// Played before : moves to the front. Never played : added at the front
+	int time = 5000000;
+	for (auto game : { games[200], games[7], games[1000] })
+	{
+		play(game, time++);
+		CollectionSystemManager::get()->refreshCollectionSystems(game);
+
+		ASSERT_FALSE(children("recent").empty());
+		EXPECT_EQ(game, children("recent").front()->getSourceFileData());
+	}
+
+	auto& recent = children("recent");
+	for (size_t i = 1; i < recent.size(); i++)
+		EXPECT_GE(recent[i - 1]->getMetadata().get("lastplayed"), recent[i]->getMetadata().get("lastplayed"));
+}
+
+TEST_F(CollectionUpdateTest, FavoritesFollowTheMetadata)
+{
+	SystemData* system = createSystem("a", 1000);
+	populate("favorites");
+
+	EXPECT_EQ(10u, children("favorites").size());
+
+	FileData* game = system->getRootFolder()->getChildren()[5];
+
+	setFavorite(game, true);
+	EXPECT_EQ(11u, children("favorites").size());
+	EXPECT_NE(nullptr, collection("favorites").system->getRootFolder()->FindByPath(game->getFullPath()));
+
+	setFavorite(game, false);
+	EXPECT_EQ(10u, children("favorites").size());
+	EXPECT_EQ(nullptr, collection("favorites").system->getRootFolder()->FindByPath(game->getFullPath()));
+}
+
+TEST_F(CollectionUpdateTest, DuplicatePathsStayIndexed)
+{
+	SystemData* system = createSystem("a", 10);
+	FileData* game = system->getRootFolder()->getChildren()[3];
+
+	// A virtual folder holding the same game twice, as a custom collection can
+	FolderData folder(mRoot + "/virtual", system, false);
+
+	CollectionFileData first(game, system);
+	CollectionFileData second(game, system);
+	folder.addChild(&first, false);
+	folder.addChild(&second, false);
+
+	EXPECT_EQ(&first, folder.FindByPath(game->getPath()));
+
+	folder.removeChild(&first);
+	EXPECT_EQ(&second, folder.FindByPath(game->getPath()));
+
+	folder.removeChild(&second);
+	EXPECT_EQ(nullptr, folder.FindByPath(game->getPath()));
+}
+
+TEST_F(CollectionUpdateTest, LatencyBenchmark)
+{
+	const int count = 50000;
+
+	SystemData* system = createSystem("bench", count);
+	populate("favorites");
+	populate("recent");
+
+	auto& games = system->getRootFolder()->getChildren();
+
+	auto measure = [](const std::function<void()>& action)
+	{
+		auto start = std::chrono::steady_clock::now();
+		action();
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	const int rounds = 100;
+	long long favoriteOn = 0;
+	long long favoriteOff = 0;
+	long long played = 0;
+
+	for (int i = 0; i < rounds; i++)
+	{
+		FileData* game = games[i * 100 + 50]; // neither a favorite nor played
+
+		favoriteOn += measure([game]() { setFavorite(game, true); });
+		favoriteOff += measure([game]() { setFavorite(game, false); });
+
+		played += measure([game, i]()
+		{
+			play(game, 6000000 + i);
+			CollectionSystemManager::get()->refreshCollectionSystems(game);
+		});
+
+		EXPECT_EQ(game, children("recent").front()->getSourceFileData());
+	}
+
+	EXPECT_EQ((size_t)count / 100, children("favorites").size());
+
+	// Every collection entry goes, then the system with its 50k games
+	long long deleted = measure([this, system]()
+	{
+		for (auto name : { "favorites", "recent" })
+			collection(name).system->getRootFolder()->clear();
+
+		SystemData::sSystemVector.clear();
+		mSystems.clear();
+		delete system;
+	});
+
+	RecordProperty("favorite_on_us", std::to_string(favoriteOn / rounds));
+	RecordProperty("favorite_off_us", std::to_string(favoriteOff / rounds));
+	RecordProperty("played_us", std::to_string(played / rounds));
+	RecordProperty("delete_system_us", std::to_string(deleted));
+
+	std::cout << count << " games : favorite on " << (favoriteOn / rounds) << " us, off " << (favoriteOff / rounds) << " us, game played "
+		<< (played / rounds) << " us, system deleted in " << deleted << " us" << std::endl;
+
+	EXPECT_LT(played / rounds, 10000);
+	EXPECT_LT(deleted, 2000000);
+}
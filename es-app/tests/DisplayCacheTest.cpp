@@ -0,0 +1,205 @@
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "FileSorts.h"
+#include "MetaData.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include "views/ViewController.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+// The lists cached by FolderData::getChildrenListToDisplay : when they are dropped, and what switching sorts costs with & without them.
+
+namespace
+{
+	class DisplayCacheTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
+			Settings::getInstance()->setBool("IgnoreGamelist", true);
+			Settings::getInstance()->setBool("UseGamelistCache", false);
+
+			MetaDataList::initMetadata();
+
+			ViewController::init(nullptr);
+			CollectionSystemManager::init(nullptr);
+
+			// getChildrenListToDisplay looks for the system in the custom collections bundle
+			CollectionSystemManager::get()->loadCollectionSystems(false);
+			SystemData::sSystemVector.clear();
+		}
+
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-displaycache-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mRoot = tmp;
+		}
+
+		void TearDown() override
+		{
+			SystemData::sSystemVector.clear();
+
+			for (auto system : mSystems)
+				delete system;
+
+			for (auto envData : mEnvData)
+				delete envData;
+
+			Settings::getInstance()->setBool("ShowFilenames", false);
+
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		// A system of count games, named in the reverse order of their files
+		SystemData* createSystem(const std::string& name, int count)
+		{
+			std::string folder = mRoot + "/" + name;
+			Utils::FileSystem::createDirectory(folder);
+
+			for (int i = 0; i < count; i++)
+			{
+				char file[32];
+				snprintf(file, sizeof(file), "/game%06d.zip", i);
+				std::ofstream f((folder + file).c_str());
+			}
+
+			SystemEnvironmentData* envData = new SystemEnvironmentData();
+			envData->mStartPath = folder;
+			envData->mSearchExtensions = { ".zip" };
+			envData->mPlatformIds = { PlatformIds::PLATFORM_UNKNOWN };
+			mEnvData.push_back(envData);
+
+			SystemData* system = new SystemData(name, name, envData, name, nullptr);
+			SystemData::sSystemVector.push_back(system);
+			mSystems.push_back(system);
+
+			int i = 0;
+			for (auto file : system->getRootFolder()->getChildren())
+			{
+				// game000001.zip is "Game 000009"...
+				int number = atoi(file->getFileName().substr(4, 6).c_str());
+
+				char gameName[32];
+				snprintf(gameName, sizeof(gameName), "Game %06d", count - number);
+
+				auto& md = file->getMetadata();
+				md.set("name", gameName);
+				md.set("rating", std::to_string((i * 37 % 100) / 100.0f));
+				md.set("playcount", std::to_string(i * 13 % 50));
+				md.set("genre", "Genre " + std::to_string(i % 17));
+				md.set("developer", "Dev " + std::to_string(i % 101));
+				md.set("publisher", "Pub " + std::to_string(i % 53));
+				i++;
+			}
+
+			return system;
+		}
+
+		static std::vector<FileData*> display(SystemData* system)
+		{
+			return system->getRootFolder()->getChildrenListToDisplay();
+		}
+
+		std::string mRoot;
+		std::vector<SystemEnvironmentData*> mEnvData;
+		std::vector<SystemData*> mSystems;
+	};
+}
+
+TEST_F(DisplayCacheTest, FileEventsDropTheListsOfTheirSystem)
+{
+	SystemData* system = createSystem("a", 10);
+	EXPECT_EQ(10u, display(system).size());
+
+	FileData* game = system->getRootFolder()->getChildren()[0];
+	game->getMetadata().set("hidden", "true");
+
+	ViewController::get()->onFileChanged(game, FILE_METADATA_CHANGED);
+	EXPECT_EQ(9u, display(system).size());
+}
+
+TEST_F(DisplayCacheTest, OtherSystemsKeepTheirLists)
+{
+	SystemData* a = createSystem("a", 10);
+	SystemData* b = createSystem("b", 10);
+
+	EXPECT_EQ(10u, display(a).size());
+
+	// Changed without an event : the list of a is only recomputed if something drops it
+	a->getRootFolder()->getChildren()[0]->getMetadata().set("hidden", "true");
+
+	FileData* game = b->getRootFolder()->getChildren()[0];
+	game->getMetadata().set("favorite", "true");
+	ViewController::get()->onFileChanged(game, FILE_METADATA_CHANGED);
+
+	EXPECT_EQ(10u, display(a).size());
+
+	// Setting values don't drop the lists either, except the ones which change the names
+	Settings::getInstance()->setInt("a.sort", 2);
+	EXPECT_EQ(10u, display(a).size());
+}
+
+TEST_F(DisplayCacheTest, ShowFilenamesChangesTheOrder)
+{
+	SystemData* system = createSystem("a", 10);
+	system->setSortId(FileSorts::FILENAME_ASCENDING);
+
+	// Sorted by the names of the metadata, in the reverse order of the files
+	auto list = display(system);
+	ASSERT_EQ(10u, list.size());
+	EXPECT_EQ("game000009.zip", list.front()->getFileName());
+
+	Settings::getInstance()->setBool("ShowFilenames", true);
+
+	list = display(system);
+	ASSERT_EQ(10u, list.size());
+	EXPECT_EQ("game000000.zip", list.front()->getFileName());
+}
+
+TEST_F(DisplayCacheTest, SortSwitchBenchmark)
+{
+	const int count = 10000;
+	SystemData* system = createSystem("bench", count);
+
+	const std::vector<FileSorts::SortType>& sorts = FileSorts::getSortTypes();
+
+	// Each sort once : computed, then the same switches again from the cache
+	long long computed[2] = { 0, 0 };
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		for (auto& sort : sorts)
+		{
+			system->setSortId(sort.id);
+			EXPECT_EQ((size_t)count, display(system).size());
+		}
+
+		computed[pass] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// A file event : the next switch sorts again
+	FileData* game = system->getRootFolder()->getChildren()[0];
+	ViewController::get()->onFileChanged(game, FILE_METADATA_CHANGED);
+
+	auto start = std::chrono::steady_clock::now();
+	system->setSortId(sorts[0].id);
+	display(system);
+	long long afterEvent = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	RecordProperty("sort_switch_computed_us", std::to_string(computed[0] / sorts.size()));
+	RecordProperty("sort_switch_cached_us", std::to_string(computed[1] / sorts.size()));
+
+	std::cout << count << " games, " << sorts.size() << " sorts : " << (computed[0] / sorts.size()) << " us per switch computed, "
+		<< (computed[1] / sorts.size()) << " us cached, " << afterEvent << " us after a file event" << std::endl;
+
+	EXPECT_LT(computed[1], computed[0]);
+}
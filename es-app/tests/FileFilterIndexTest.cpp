@@ -0,0 +1,254 @@
+#include "FileData.h"
+#include "FileFilterIndex.h"
+#include "MetaData.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <stdlib.h>
+#include <unistd.h>
+
+// The filter index keeps the keys of its games, and indexes again the games whose metadata changed since.
+// Changes in the other systems must not cost anything.
+
+namespace
+{
+	class FileFilterIndexTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
+			Settings::getInstance()->setBool("IgnoreGamelist", true);
+			Settings::getInstance()->setBool("UseGamelistCache", false);
+
+			MetaDataList::initMetadata();
+		}
+
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-filterindex-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mRoot = tmp;
+		}
+
+		void TearDown() override
+		{
+			for (auto system : mSystems)
+				delete system;
+
+			for (auto envData : mEnvData)
+				delete envData;
+
+			Settings::getInstance()->setBool("ShowFilenames", false);
+
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		// A system of count games, which only exist in memory
+		SystemData* createSystem(const std::string& name, int count)
+		{
+			std::string folder = mRoot + "/" + name;
+			Utils::FileSystem::createDirectory(folder);
+
+			SystemEnvironmentData* envData = new SystemEnvironmentData();
+			envData->mStartPath = folder;
+			envData->mSearchExtensions = { ".zip" };
+			envData->mPlatformIds = { PlatformIds::PLATFORM_UNKNOWN };
+			mEnvData.push_back(envData);
+
+			SystemData* system = new SystemData(name, name, envData, name, nullptr);
+			mSystems.push_back(system);
+
+			for (int i = 0; i < count; i++)
+			{
+				char file[32];
+				snprintf(file, sizeof(file), "/game%06d.zip", i);
+
+				FileData* game = new FileData(GAME, folder + file, system);
+
+				auto& md = game->getMetadata();
+				md.set("name", "Name " + std::to_string(i));
+				md.set("genre", sGenres[i % 5]);
+				md.set("rating", i % 3 == 0 ? "0.8" : "0.4");
+				md.set("publisher", "Pub " + std::to_string(i % 53));
+				if (i % 4 == 0)
+					md.set("favorite", "true");
+
+				system->getRootFolder()->addChild(game);
+			}
+
+			return system;
+		}
+
+		static void setFilter(FileFilterIndex* idx, FilterIndexType type, const std::string& key)
+		{
+			std::vector<std::string> values = { key };
+			idx->setFilter(type, &values);
+		}
+
+		static int countShown(SystemData* system)
+		{
+			FileFilterIndex* idx = system->getIndex(false);
+
+			int count = 0;
+			for (auto game : system->getRootFolder()->getChildren())
+				if (idx->showFile(game))
+					count++;
+
+			return count;
+		}
+
+		std::string mRoot;
+		std::vector<SystemEnvironmentData*> mEnvData;
+		std::vector<SystemData*> mSystems;
+
+		static const char* sGenres[5];
+	};
+
+	const char* FileFilterIndexTest::sGenres[5] = { "Action", "RPG", "Puzzle", "Shooter", "Sports" };
+}
+
+TEST_F(FileFilterIndexTest, MetadataChangesAreSeen)
+{
+	SystemData* system = createSystem("a", 100);
+	FileFilterIndex* idx = system->getIndex(true);
+
+	setFilter(idx, GENRE_FILTER, "RPG");
+	EXPECT_EQ(20, countShown(system));
+
+	// Changed without addToIndex, as the scraper or a gamelist reload do
+	FileData* game = system->getRootFolder()->getChildren()[0];
+	game->getMetadata().set("genre", "RPG");
+
+	EXPECT_TRUE(idx->showFile(game));
+	EXPECT_EQ(21, countShown(system));
+
+	// Then indexed again, as the metadata editor does
+	system->removeFromIndex(game);
+	game->getMetadata().set("genre", "Action");
+	system->addToIndex(game);
+
+	EXPECT_FALSE(idx->showFile(game));
+	EXPECT_EQ(20, countShown(system));
+}
+
+TEST_F(FileFilterIndexTest, ManyChangesAreSeen)
+{
+	SystemData* system = createSystem("a", 100);
+	FileFilterIndex* idx = system->getIndex(true);
+
+	setFilter(idx, GENRE_FILTER, "RPG");
+	EXPECT_EQ(20, countShown(system));
+
+	// Enough changes for the keys to be rebuilt instead of updated
+	for (auto game : system->getRootFolder()->getChildren())
+		game->getMetadata().set("genre", "RPG");
+
+	EXPECT_EQ(100, countShown(system));
+}
+
+TEST_F(FileFilterIndexTest, RemovedGamesAreNotShown)
+{
+	SystemData* system = createSystem("a", 100);
+	FileFilterIndex* idx = system->getIndex(true);
+
+	setFilter(idx, FAVORITES_FILTER, "TRUE");
+	EXPECT_EQ(25, countShown(system));
+
+	FileData* game = system->getRootFolder()->getChildren()[0];
+	ASSERT_TRUE(idx->showFile(game));
+
+	delete game;
+	EXPECT_EQ(24, countShown(system));
+}
+
+TEST_F(FileFilterIndexTest, TextFilterFollowsShowFilenames)
+{
+	SystemData* system = createSystem("a", 100);
+	FileFilterIndex* idx = system->getIndex(true);
+
+	idx->setTextFilter("GAME00001");
+	EXPECT_EQ(0, countShown(system));
+
+	Settings::getInstance()->setBool("ShowFilenames", true);
+	EXPECT_EQ(10, countShown(system));
+
+	Settings::getInstance()->setBool("ShowFilenames", false);
+	idx->setTextFilter("NAME 1");
+	EXPECT_EQ(11, countShown(system));
+}
+
+TEST_F(FileFilterIndexTest, FilterBenchmark)
+{
+	const int count = 50000;
+
+	SystemData* system = createSystem("bench", count);
+	SystemData* other = createSystem("other", 1000);
+
+	auto start = std::chrono::steady_clock::now();
+	FileFilterIndex* idx = system->getIndex(true);
+	long long indexing = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	other->getIndex(true);
+
+	setFilter(idx, GENRE_FILTER, "RPG");
+	setFilter(idx, RATINGS_FILTER, "4 STARS");
+	setFilter(idx, FAVORITES_FILTER, "TRUE");
+	idx->setTextFilter("NAME 1");
+
+	// Same filters evaluated on the metadata
+	int expected = 0;
+	for (int i = 0; i < count; i++)
+		if (i % 5 == 1 && i % 3 == 0 && i % 4 == 0 && Utils::String::startsWith(std::to_string(i), "1"))
+			expected++;
+
+	auto measure = [system, expected]()
+	{
+		auto start = std::chrono::steady_clock::now();
+		EXPECT_EQ(expected, countShown(system));
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	long long first = measure();
+	long long cached = measure();
+
+	// A game of another system changes : the keys of this index stay valid
+	other->getRootFolder()->getChildren()[0]->getMetadata().set("genre", "RPG");
+	long long otherSystem = measure();
+
+	// A game of this system changes without being indexed again : only its keys are updated
+	system->getRootFolder()->getChildren()[0]->getMetadata().set("publisher", "Someone");
+	long long changed = measure();
+
+	// Indexed again after its change, as the metadata editor does
+	FileData* game = system->getRootFolder()->getChildren()[0];
+	system->removeFromIndex(game);
+	game->getMetadata().set("publisher", "Someone else");
+	system->addToIndex(game);
+	long long reindexed = measure();
+
+	// Most of the games change, as when scraping : the keys are rebuilt
+	for (auto file : system->getRootFolder()->getChildren())
+		file->getMetadata().set("developer", "Dev");
+
+	long long rebuilt = measure();
+
+	RecordProperty("filter_index_build_us", std::to_string(indexing));
+	RecordProperty("filter_first_us", std::to_string(first));
+	RecordProperty("filter_cached_us", std::to_string(cached));
+	RecordProperty("filter_other_system_us", std::to_string(otherSystem));
+	RecordProperty("filter_changed_us", std::to_string(changed));
+	RecordProperty("filter_reindexed_us", std::to_string(reindexed));
+	RecordProperty("filter_rebuilt_us", std::to_string(rebuilt));
+
+	std::cout << count << " games, 3 filters + text : index " << indexing << " us, first evaluation " << first << " us, cached " << cached
+		<< " us, after a change in another system " << otherSystem << " us, one game changed " << changed << " us, reindexed " << reindexed
+		<< " us, all changed " << rebuilt << " us" << std::endl;
+
+	EXPECT_LT(otherSystem, rebuilt);
+	EXPECT_LT(changed, rebuilt);
+	EXPECT_LT(reindexed, rebuilt);
+}
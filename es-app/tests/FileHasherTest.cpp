@@ -0,0 +1,144 @@
+#include "FileHasher.h"
+#include "utils/HashUtil.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+// The in-process hashes of the game files : known values, then the throughput of the CRC32 ( slice-by-8 against
+// the byte-wise table ) and of the whole FileHasher path, file reads included, on a file in the page cache.
+
+namespace
+{
+	class FileHasherTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-hasher-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mFolder = tmp;
+		}
+
+		void TearDown() override
+		{
+			system(("rm -rf \"" + mFolder + "\"").c_str());
+		}
+
+		std::string createFile(const std::string& name, const std::vector<unsigned char>& data)
+		{
+			std::string path = mFolder + "/" + name;
+
+			std::ofstream f(path.c_str(), std::ios::binary);
+			f.write((const char*)data.data(), data.size());
+
+			return path;
+		}
+
+		// The classic one byte per step CRC32, as the reference & the baseline
+		static unsigned int referenceCrc32(const unsigned char* data, size_t size)
+		{
+			static unsigned int table[256];
+			if (table[1] == 0)
+			{
+				for (unsigned int i = 0; i < 256; i++)
+				{
+					unsigned int c = i;
+					for (int k = 0; k < 8; k++)
+						c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+
+					table[i] = c;
+				}
+			}
+
+			unsigned int crc = 0xFFFFFFFF;
+			for (size_t i = 0; i < size; i++)
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+			return ~crc;
+		}
+
+		// MB per second of action over size bytes, best of 3
+		template<typename Action>
+		static double measure(size_t size, Action action)
+		{
+			double best = 0;
+
+			for (int pass = 0; pass < 3; pass++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				action();
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				best = std::max(best, size / 1048576.0 / seconds);
+			}
+
+			return best;
+		}
+
+		std::string mFolder;
+	};
+}
+
+TEST_F(FileHasherTest, KnownValues)
+{
+	std::string text = "123456789";
+	EXPECT_EQ(0xCBF43926, Utils::Hash::crc32(text.c_str(), text.size()));
+
+	// In parts
+	unsigned int crc = Utils::Hash::crc32(text.c_str(), 4);
+	EXPECT_EQ(0xCBF43926, Utils::Hash::crc32(text.c_str() + 4, text.size() - 4, crc));
+
+	std::string path = createFile("check.bin", std::vector<unsigned char>(text.cbegin(), text.cend()));
+	EXPECT_EQ("CBF43926", FileHasher::getCRC32(path, false));
+	EXPECT_EQ("25f9e794323b453885f5181f1b624d0b", FileHasher::getMD5(path));
+
+	// Every alignment & tail length of the 8 bytes steps
+	std::vector<unsigned char> data(1000);
+	for (auto& c : data)
+		c = (unsigned char)(rand() & 0xFF);
+
+	for (size_t offset = 0; offset < 8; offset++)
+		for (size_t size = 0; size < 40; size++)
+			EXPECT_EQ(referenceCrc32(data.data() + offset, size), Utils::Hash::crc32(data.data() + offset, size)) << offset << " " << size;
+}
+
+TEST_F(FileHasherTest, ThroughputBenchmark)
+{
+	const size_t size = 64 * 1024 * 1024;
+
+	std::vector<unsigned char> data(size);
+	for (size_t i = 0; i < size; i++)
+		data[i] = (unsigned char)(i * 2654435761u >> 24);
+
+	unsigned int expected = referenceCrc32(data.data(), size);
+
+	unsigned int crc = 0;
+	double sliceBy8 = measure(size, [&] { crc = Utils::Hash::crc32(data.data(), size); });
+	EXPECT_EQ(expected, crc);
+
+	double byteWise = measure(size, [&] { crc = referenceCrc32(data.data(), size); });
+
+	std::string path = createFile("rom.bin", data);
+
+	std::string fileCrc;
+	double fileCrc32 = measure(size, [&] { fileCrc = FileHasher::getCRC32(path, false); });
+
+	char hex[9];
+	snprintf(hex, sizeof(hex), "%08X", expected);
+	EXPECT_EQ(hex, fileCrc);
+
+	double fileMd5 = measure(size, [&] { EXPECT_EQ(32u, FileHasher::getMD5(path).size()); });
+
+	RecordProperty("crc32_slice_by_8_mbps", std::to_string((int)sliceBy8));
+	RecordProperty("crc32_byte_wise_mbps", std::to_string((int)byteWise));
+	RecordProperty("file_crc32_mbps", std::to_string((int)fileCrc32));
+	RecordProperty("file_md5_mbps", std::to_string((int)fileMd5));
+
+	std::cout << "CRC32 in memory : slice-by-8 " << (int)sliceBy8 << " MB/s, byte-wise " << (int)byteWise << " MB/s. 64 MB file in the page cache : CRC32 "
+		<< (int)fileCrc32 << " MB/s, MD5 " << (int)fileMd5 << " MB/s" << std::endl;
+
+	EXPECT_GT(sliceBy8, byteWise);
+}
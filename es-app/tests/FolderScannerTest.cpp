@@ -0,0 +1,138 @@
+#include "FolderScanner.h"
+#include "SystemData.h"
+#include "utils/FileSystemUtil.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+
+// The parallel enumeration of a ROM folder tree : the same listings whatever the number of threads,
+// and how the scan time scales with them.
+
+namespace
+{
+	class FolderScannerTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-scan-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mRoot = tmp;
+
+			mEnvData.mStartPath = mRoot;
+			mEnvData.mSearchExtensions = { ".zip" };
+		}
+
+		void TearDown() override
+		{
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		// folders sub folders of folders sub folders each, with files ROMs in each of the last ones
+		void createTree(int folders, int files)
+		{
+			for (int i = 0; i < folders; i++)
+			{
+				for (int j = 0; j < folders; j++)
+				{
+					std::string folder = mRoot + "/set" + std::to_string(i) + "/part" + std::to_string(j);
+					Utils::FileSystem::createDirectory(mRoot + "/set" + std::to_string(i));
+					Utils::FileSystem::createDirectory(folder);
+
+					for (int f = 0; f < files; f++)
+						std::ofstream((folder + "/game" + std::to_string(f) + ".zip").c_str());
+				}
+			}
+		}
+
+		// Listed files of the whole tree
+		size_t countFiles(FolderScanner& scanner, const std::string& path)
+		{
+			FolderScanner::Listing* listing = scanner.getListing(path);
+			if (listing == nullptr)
+				return 0;
+
+			size_t count = 0;
+			for (auto& file : listing->files)
+				count += file.directory ? countFiles(scanner, file.path) : 1;
+
+			return count;
+		}
+
+		// Best of a few scans with threads workers, in us
+		long long measure(int threads, size_t& files)
+		{
+			Utils::ThreadPool pool(threads);
+			long long best = -1;
+
+			for (int pass = 0; pass < 5; pass++)
+			{
+				FolderScanner scanner(&mEnvData, false, &pool);
+
+				auto start = std::chrono::steady_clock::now();
+				scanner.scan(mRoot);
+				long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+				if (best < 0 || elapsed < best)
+					best = elapsed;
+
+				files = countFiles(scanner, mRoot);
+			}
+
+			return best;
+		}
+
+		std::string mRoot;
+		SystemEnvironmentData mEnvData;
+	};
+}
+
+TEST_F(FolderScannerTest, MediaFoldersAreSkipped)
+{
+	createTree(2, 3);
+
+	Utils::FileSystem::createDirectory(mRoot + "/images");
+	std::ofstream((mRoot + "/images/game0.png").c_str());
+
+	FolderScanner scanner(&mEnvData, false);
+	scanner.scan(mRoot);
+
+	EXPECT_EQ(12u, countFiles(scanner, mRoot));
+	EXPECT_EQ(nullptr, scanner.getListing(mRoot + "/images"));
+}
+
+TEST_F(FolderScannerTest, ScanBenchmark)
+{
+	// 400 folders of 50 ROMs
+	createTree(20, 50);
+
+	std::vector<int> threadCounts = { 1, 2, 4 };
+
+	int cores = std::max(1, (int)std::thread::hardware_concurrency());
+	if (std::find(threadCounts.cbegin(), threadCounts.cend(), cores) == threadCounts.cend())
+		threadCounts.push_back(cores);
+
+	std::cout << "20000 ROMs in 420 folders, " << cores << " cores :";
+
+	long long single = 0;
+
+	for (int threads : threadCounts)
+	{
+		size_t files = 0;
+		long long elapsed = measure(threads, files);
+
+		if (threads == 1)
+			single = elapsed;
+
+		EXPECT_EQ(20000u, files) << threads << " threads";
+
+		RecordProperty("scan_" + std::to_string(threads) + "_threads_us", std::to_string(elapsed));
+		std::cout << " " << threads << " threads " << elapsed << " us ( x" << ((double)single / std::max(1LL, elapsed)) << " )";
+	}
+
+	std::cout << std::endl;
+}
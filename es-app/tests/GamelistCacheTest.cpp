@@ -0,0 +1,150 @@
+#include "GamelistCache.h"
+#include "FileData.h"
+#include "MetaData.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+// What the snapshot of a system saves at boot, compared to the scan of its ROM folders,
+// and the folder changes which must make it outdated.
+
+namespace
+{
+	class GamelistCacheTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
+			Settings::getInstance()->setBool("IgnoreGamelist", true);
+			Settings::getInstance()->setBool("ParseGamelistOnly", false);
+
+			MetaDataList::initMetadata();
+		}
+
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-gamelistcache-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mRoot = tmp;
+
+			// Unique : the snapshots are stored in the ES config folder, by system name
+			mName = "gamelistcachetest" + std::to_string(getpid());
+
+			mEnvData = new SystemEnvironmentData();
+			mEnvData->mStartPath = mRoot;
+			mEnvData->mSearchExtensions = { ".zip" };
+			mEnvData->mPlatformIds = { PlatformIds::PLATFORM_UNKNOWN };
+		}
+
+		void TearDown() override
+		{
+			Settings::getInstance()->setBool("UseGamelistCache", false);
+
+			delete mEnvData;
+
+			Utils::FileSystem::removeFile(Utils::FileSystem::getEsConfigPath() + "/gamelistcache/" + mName + ".db");
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		// count ROMs, in sub folders of 100
+		void createRoms(int count)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				std::string folder = mRoot + "/folder" + std::to_string(i / 100);
+				if (i % 100 == 0)
+					Utils::FileSystem::createDirectory(folder);
+
+				std::ofstream f((folder + "/game" + std::to_string(i) + ".zip").c_str());
+			}
+		}
+
+		// Time to create the system, in us. It's deleted afterwards, with the number of games it had
+		long long loadSystem(size_t& games)
+		{
+			auto start = std::chrono::steady_clock::now();
+			SystemData* system = new SystemData(mName, mName, mEnvData, mName, nullptr);
+			long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+			games = system->getRootFolder()->getFilesRecursive(GAME).size();
+			delete system;
+
+			return elapsed;
+		}
+
+		std::string mRoot;
+		std::string mName;
+		SystemEnvironmentData* mEnvData;
+	};
+}
+
+TEST_F(GamelistCacheTest, ChangedFoldersAreScannedAgain)
+{
+	createRoms(250);
+	Settings::getInstance()->setBool("UseGamelistCache", true);
+
+	size_t games = 0;
+	loadSystem(games);
+	EXPECT_EQ(250u, games);
+
+	// A ROM added to a folder : its date changes, the snapshot is outdated
+	sleep(1);
+	std::ofstream((mRoot + "/folder1/added.zip").c_str());
+
+	loadSystem(games);
+	EXPECT_EQ(251u, games);
+
+	// And a new folder
+	sleep(1);
+	Utils::FileSystem::createDirectory(mRoot + "/new");
+	std::ofstream((mRoot + "/new/game.zip").c_str());
+
+	loadSystem(games);
+	EXPECT_EQ(252u, games);
+
+	loadSystem(games);
+	EXPECT_EQ(252u, games);
+}
+
+TEST_F(GamelistCacheTest, StartupBenchmark)
+{
+	const int count = 20000;
+	createRoms(count);
+
+	size_t scannedGames = 0;
+	size_t savedGames = 0;
+	size_t loadedGames = 0;
+
+	// Without snapshot, as before, then the boot which writes it, and the next ones
+	Settings::getInstance()->setBool("UseGamelistCache", false);
+	long long scan = loadSystem(scannedGames);
+
+	Settings::getInstance()->setBool("UseGamelistCache", true);
+	long long save = loadSystem(savedGames);
+
+	long long load = 0;
+	const int boots = 5;
+
+	for (int i = 0; i < boots; i++)
+		load += loadSystem(loadedGames);
+
+	load /= boots;
+
+	RecordProperty("startup_scan_us", std::to_string(scan));
+	RecordProperty("startup_scan_and_save_us", std::to_string(save));
+	RecordProperty("startup_snapshot_us", std::to_string(load));
+
+	std::cout << count << " ROMs in " << (count / 100) << " folders : scanned in " << scan << " us, scanned & saved in " << save
+		<< " us, loaded from the snapshot in " << load << " us" << std::endl;
+
+	EXPECT_EQ((size_t)count, scannedGames);
+	EXPECT_EQ(scannedGames, savedGames);
+	EXPECT_EQ(scannedGames, loadedGames);
+	EXPECT_LT(load, scan);
+}
@@ -0,0 +1,182 @@
+#include "GamelistJournal.h"
+#include "utils/FileSystemUtil.h"
+#include <gtest/gtest.h>
+#include <pugixml/src/pugixml.hpp>
+#include <fstream>
+#include <iterator>
+#include <stdlib.h>
+#include <unistd.h>
+
+// What a crash can leave in a journal : a record cut in the middle, or bytes that don't match their checksum.
+// The replay must keep the records written before the damage, and the journal must stay usable afterwards.
+
+namespace
+{
+	class GamelistJournalTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-journal-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+
+			mFolder = tmp;
+			mPath = mFolder + "/test.journal";
+		}
+
+		void TearDown() override
+		{
+			GamelistJournal::close();
+			system(("rm -rf \"" + mFolder + "\"").c_str());
+		}
+
+		static std::string node(const std::string& name)
+		{
+			return "<game><path>./" + name + ".zip</path><name>" + name + "</name></game>";
+		}
+
+		void append(const std::string& name, size_t gamelistHash = 1000)
+		{
+			ASSERT_TRUE(GamelistJournal::append(mPath, gamelistHash, node(name)));
+		}
+
+		// The names of the replayed records, in order
+		std::vector<std::string> replay(size_t gamelistHash = 1000)
+		{
+			std::vector<std::string> names;
+			GamelistJournal::replay(mPath, gamelistHash, [&names](pugi::xml_node& node) { names.push_back(node.child("name").text().get()); });
+			return names;
+		}
+
+		std::vector<char> read()
+		{
+			GamelistJournal::close();
+
+			std::ifstream file(mPath, std::ios::in | std::ios::binary);
+			return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		void write(const std::vector<char>& data)
+		{
+			std::ofstream file(mPath, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(data.data(), data.size());
+		}
+
+		std::string mFolder;
+		std::string mPath;
+	};
+}
+
+TEST_F(GamelistJournalTest, RecordsAreReplayedInOrder)
+{
+	append("a");
+	append("b");
+	append("a");
+
+	EXPECT_EQ(std::vector<std::string>({ "a", "b", "a" }), replay());
+
+	// Replaying doesn't consume the journal : it goes away when gamelist.xml is saved
+	EXPECT_EQ(std::vector<std::string>({ "a", "b", "a" }), replay());
+}
+
+TEST_F(GamelistJournalTest, TruncatedLastRecord)
+{
+	append("a");
+	append("b");
+	append("c");
+
+	// Crash while writing the last record
+	std::vector<char> data = read();
+	size_t complete = data.size();
+	data.resize(data.size() - 10);
+	write(data);
+
+	EXPECT_EQ(std::vector<std::string>({ "a", "b" }), replay());
+
+	// The broken record is cut off, so that the next one doesn't follow it
+	EXPECT_EQ(complete - 8 - node("c").size(), read().size());
+
+	append("d");
+	EXPECT_EQ(std::vector<std::string>({ "a", "b", "d" }), replay());
+}
+
+TEST_F(GamelistJournalTest, TruncatedRecordHeader)
+{
+	append("a");
+
+	std::vector<char> data = read();
+	size_t complete = data.size();
+
+	// Only half of the next length & checksum made it to disk
+	data.push_back(0x10);
+	data.push_back(0x00);
+	data.push_back(0x00);
+	write(data);
+
+	EXPECT_EQ(std::vector<std::string>({ "a" }), replay());
+	EXPECT_EQ(complete, read().size());
+}
+
+TEST_F(GamelistJournalTest, CorruptChecksumMidFile)
+{
+	append("a");
+	append("b");
+	append("c");
+
+	// Flip a byte inside the second record : its length is intact, its checksum no longer matches
+	std::vector<char> data = read();
+	size_t second = data.size() - 2 * (8 + node("b").size());
+	data[second + 8 + 10] ^= 0x20;
+	write(data);
+
+	// The replay stops at the first bad record : what follows it can't be trusted to be a record boundary
+	EXPECT_EQ(std::vector<std::string>({ "a" }), replay());
+	EXPECT_EQ(second, read().size());
+
+	append("d");
+	EXPECT_EQ(std::vector<std::string>({ "a", "d" }), replay());
+}
+
+TEST_F(GamelistJournalTest, CorruptHeader)
+{
+	append("a");
+
+	std::vector<char> data = read();
+	data[0] ^= 0xFF;
+	write(data);
+
+	EXPECT_TRUE(replay().empty());
+	EXPECT_FALSE(Utils::FileSystem::exists(mPath));
+}
+
+TEST_F(GamelistJournalTest, ReplayAfterCompaction)
+{
+	append("a");
+	append("b");
+
+	EXPECT_EQ(std::vector<std::string>({ "a", "b" }), replay());
+
+	// The changes are written to gamelist.xml, which gets a new hash, and the journal is removed
+	GamelistJournal::clear(mPath);
+	EXPECT_FALSE(Utils::FileSystem::exists(mPath));
+	EXPECT_TRUE(replay(2000).empty());
+
+	// New changes start a new journal for the new gamelist.xml
+	append("c", 2000);
+	append("d", 2000);
+	EXPECT_EQ(std::vector<std::string>({ "c", "d" }), replay(2000));
+}
+
+TEST_F(GamelistJournalTest, JournalOfAnotherGamelistIsDiscarded)
+{
+	append("a");
+
+	// gamelist.xml was replaced behind our back ( saved without the journal being cleared, or edited by hand )
+	EXPECT_TRUE(replay(2000).empty());
+	EXPECT_FALSE(Utils::FileSystem::exists(mPath));
+
+	// Appending for another gamelist.xml restarts the journal instead of mixing the records
+	append("b");
+	append("c", 2000);
+	EXPECT_EQ(std::vector<std::string>({ "c" }), replay(2000));
+}
@@ -0,0 +1,159 @@
+#include "MetaData.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include <gtest/gtest.h>
+#include <pugixml/src/pugixml.hpp>
+#include <chrono>
+#include <malloc.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// The metadata slots : paths relative to the ROM folder are resolved when they are set, not on each read,
+// and what the games of a large gamelist take in memory.
+
+namespace
+{
+	class MetaDataTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
+			Settings::getInstance()->setBool("IgnoreGamelist", true);
+			Settings::getInstance()->setBool("UseGamelistCache", false);
+
+			MetaDataList::initMetadata();
+		}
+
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-metadata-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mRoot = tmp;
+
+			mEnvData = new SystemEnvironmentData();
+			mEnvData->mStartPath = mRoot;
+			mEnvData->mSearchExtensions = { ".zip" };
+			mEnvData->mPlatformIds = { PlatformIds::PLATFORM_UNKNOWN };
+
+			mSystem = new SystemData("a", "a", mEnvData, "a", nullptr);
+		}
+
+		void TearDown() override
+		{
+			delete mSystem;
+			delete mEnvData;
+
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		// The metadata of a game of the gamelist, with its media in mediaFolder
+		MetaDataList load(int i, const std::string& mediaFolder)
+		{
+			std::string name = "game" + std::to_string(i);
+
+			std::string xml = "<game><name>Game " + std::to_string(i) + "</name><desc>A game</desc><genre>Action</genre>"
+				"<image>" + mediaFolder + "/images/" + name + ".png</image>"
+				"<thumbnail>" + mediaFolder + "/thumbnails/" + name + ".png</thumbnail>"
+				"<marquee>" + mediaFolder + "/marquees/" + name + ".png</marquee>"
+				"<video>" + mediaFolder + "/videos/" + name + ".mp4</video></game>";
+
+			pugi::xml_document doc;
+			doc.load_buffer(xml.c_str(), xml.size());
+
+			pugi::xml_node game = doc.child("game");
+			return MetaDataList::createFromXML(GAME_METADATA, game, mSystem);
+		}
+
+		static size_t heapUsed()
+		{
+			return mallinfo2().uordblks;
+		}
+
+		std::string mRoot;
+		SystemEnvironmentData* mEnvData;
+		SystemData* mSystem;
+	};
+}
+
+TEST_F(MetaDataTest, RelativePathsAreResolved)
+{
+	MetaDataList md = load(1, ".");
+
+	EXPECT_EQ(mRoot + "/images/game1.png", md.get("image"));
+	EXPECT_EQ("./images/game1.png", md.get("image", false));
+	EXPECT_EQ("Game 1", md.get("name"));
+
+	// Set as an absolute path, stored relative to the ROM folder
+	md.set("image", mRoot + "/images/other.png");
+	EXPECT_EQ("./images/other.png", md.get("image", false));
+	EXPECT_EQ(mRoot + "/images/other.png", md.get("image"));
+
+	// Outside of the ROM folder : nothing to resolve
+	md.set("video", "/media/videos/game1.mp4");
+	EXPECT_EQ("/media/videos/game1.mp4", md.get("video"));
+
+	// Copies keep the resolved paths
+	MetaDataList copy(md);
+	EXPECT_EQ(mRoot + "/images/other.png", copy.get("image"));
+	EXPECT_EQ("./thumbnails/game1.png", copy.get("thumbnail", false));
+
+	MetaDataList assigned(GAME_METADATA);
+	assigned = copy;
+	EXPECT_EQ(mRoot + "/thumbnails/game1.png", assigned.get("thumbnail"));
+}
+
+TEST_F(MetaDataTest, MemoryReport)
+{
+	const int count = 50000;
+
+	// Media next to the ROMs ( relative paths, resolved once ) & in another folder ( stored as is )
+	auto measure = [this](const std::string& mediaFolder, long long& readNs)
+	{
+		std::vector<MetaDataList> games;
+		games.reserve(count);
+
+		size_t before = heapUsed();
+
+		for (int i = 0; i < count; i++)
+			games.push_back(load(i, mediaFolder));
+
+		size_t used = heapUsed() - before;
+
+		// What a gamelist view reads for each game it draws
+		size_t length = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for (auto& md : games)
+		{
+			length += md.get(MetaDataId::Image).size();
+			length += md.get(MetaDataId::Thumbnail).size();
+			length += md.get(MetaDataId::Marquee).size();
+			length += md.get(MetaDataId::Video).size();
+		}
+
+		readNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / (count * 4);
+		EXPECT_GT(length, 0u);
+
+		return (long long)used / count;
+	};
+
+	long long relativeRead = 0;
+	long long absoluteRead = 0;
+
+	long long relative = measure(".", relativeRead);
+	long long absolute = measure("/media", absoluteRead);
+
+	RecordProperty("bytes_per_game_relative_media", std::to_string(relative));
+	RecordProperty("bytes_per_game_absolute_media", std::to_string(absolute));
+	RecordProperty("path_read_relative_ns", std::to_string(relativeRead));
+	RecordProperty("path_read_absolute_ns", std::to_string(absoluteRead));
+	RecordProperty("shared_values", std::to_string(MetaDataList::getSharedValuesCount()));
+
+	std::cout << count << " games, 4 media paths each : " << relative << " bytes per game with relative paths ( resolved ), " << absolute
+		<< " bytes with absolute paths. A path read takes " << relativeRead << " ns ( relative ), " << absoluteRead << " ns ( absolute ). "
+		<< MetaDataList::getSharedValuesCount() << " shared values" << std::endl;
+
+	EXPECT_LT(relative, 4096);
+}
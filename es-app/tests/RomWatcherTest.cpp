@@ -0,0 +1,181 @@
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "MetaData.h"
+#include "RomWatcher.h"
+#include "SystemData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include "views/ViewController.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+// RomWatcher::applyChanges is what the inotify thread posts to the UI thread : the tests create & delete files
+// in a temporary ROM folder, then check that the loaded tree follows without reloading the system.
+
+namespace
+{
+	void writeFile(const std::string& path)
+	{
+		std::ofstream f(path.c_str());
+		f << "rom";
+	}
+
+	class RomWatcherTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			Settings::getInstance()->setBool("ThreadedLoading", false);
+			Settings::getInstance()->setBool("IgnoreGamelist", true);
+			Settings::getInstance()->setBool("UseGamelistCache", false);
+
+			MetaDataList::initMetadata();
+
+			// No view & no collection is loaded : they are only looked up
+			ViewController::init(nullptr);
+			CollectionSystemManager::init(nullptr);
+		}
+
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-romwatcher-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+
+			mRoot = tmp;
+			Utils::FileSystem::createDirectory(mRoot + "/sub");
+			writeFile(mRoot + "/a.zip");
+			writeFile(mRoot + "/sub/b.zip");
+			writeFile(mRoot + "/readme.txt");
+
+			mEnvData.mStartPath = mRoot;
+			mEnvData.mSearchExtensions = { ".zip" };
+			mEnvData.mPlatformIds = { PlatformIds::PLATFORM_UNKNOWN };
+
+			mSystem = new SystemData("test", "Test", &mEnvData, "test", nullptr);
+			SystemData::sSystemVector.push_back(mSystem);
+		}
+
+		void TearDown() override
+		{
+			SystemData::sSystemVector.clear();
+			delete mSystem;
+
+			system(("rm -rf \"" + mRoot + "\"").c_str());
+		}
+
+		FileData* find(const std::string& relative)
+		{
+			return mSystem->getRootFolder()->FindByPath(mRoot + "/" + relative);
+		}
+
+		size_t gameCount()
+		{
+			return mSystem->getRootFolder()->getFilesRecursive(GAME).size();
+		}
+
+		std::string				mRoot;
+		SystemEnvironmentData	mEnvData;
+		SystemData*				mSystem;
+	};
+}
+
+TEST_F(RomWatcherTest, InitialTree)
+{
+	EXPECT_EQ(2u, gameCount());
+	EXPECT_NE(nullptr, find("a.zip"));
+	EXPECT_NE(nullptr, find("sub/b.zip"));
+	EXPECT_EQ(nullptr, find("readme.txt"));
+}
+
+TEST_F(RomWatcherTest, AddedFileIsInsertedInPlace)
+{
+	FolderData* root = mSystem->getRootFolder();
+	FileData* existing = find("a.zip");
+
+	writeFile(mRoot + "/c.zip");
+	RomWatcher::applyChanges({ mRoot + "/c.zip" });
+
+	FileData* added = find("c.zip");
+	ASSERT_NE(nullptr, added);
+	EXPECT_EQ(GAME, added->getType());
+	EXPECT_EQ(root, added->getParent());
+	EXPECT_EQ(3u, gameCount());
+
+	// Not reloaded : the tree & the existing games are the same objects
+	EXPECT_EQ(root, mSystem->getRootFolder());
+	EXPECT_EQ(existing, find("a.zip"));
+}
+
+TEST_F(RomWatcherTest, AddedFileInNewFolder)
+{
+	Utils::FileSystem::createDirectory(mRoot + "/new");
+	writeFile(mRoot + "/new/d.zip");
+	writeFile(mRoot + "/new/notes.txt");
+
+	RomWatcher::applyChanges({ mRoot + "/new" });
+
+	FileData* folder = find("new");
+	ASSERT_NE(nullptr, folder);
+	EXPECT_EQ(FOLDER, folder->getType());
+
+	FileData* game = find("new/d.zip");
+	ASSERT_NE(nullptr, game);
+	EXPECT_EQ(folder, game->getParent());
+	EXPECT_EQ(nullptr, find("new/notes.txt"));
+	EXPECT_EQ(3u, gameCount());
+}
+
+TEST_F(RomWatcherTest, IgnoredFilesAreNotAdded)
+{
+	writeFile(mRoot + "/e.txt");
+	Utils::FileSystem::createDirectory(mRoot + "/images");
+	writeFile(mRoot + "/images/a.zip");
+
+	RomWatcher::applyChanges({ mRoot + "/e.txt", mRoot + "/images/a.zip" });
+
+	EXPECT_EQ(nullptr, find("e.txt"));
+	EXPECT_EQ(nullptr, find("images"));
+	EXPECT_EQ(2u, gameCount());
+}
+
+TEST_F(RomWatcherTest, RemovedFile)
+{
+	FileData* kept = find("sub/b.zip");
+
+	Utils::FileSystem::removeFile(mRoot + "/a.zip");
+	RomWatcher::applyChanges({ mRoot + "/a.zip" });
+
+	EXPECT_EQ(nullptr, find("a.zip"));
+	EXPECT_EQ(kept, find("sub/b.zip"));
+	EXPECT_EQ(1u, gameCount());
+}
+
+TEST_F(RomWatcherTest, EmptiedFolderIsPruned)
+{
+	Utils::FileSystem::removeFile(mRoot + "/sub/b.zip");
+	RomWatcher::applyChanges({ mRoot + "/sub/b.zip" });
+
+	EXPECT_EQ(nullptr, find("sub/b.zip"));
+	EXPECT_EQ(nullptr, find("sub"));
+	EXPECT_EQ(1u, gameCount());
+}
+
+TEST_F(RomWatcherTest, RemovedFolder)
+{
+	Utils::FileSystem::removeFile(mRoot + "/sub/b.zip");
+	rmdir((mRoot + "/sub").c_str());
+
+	RomWatcher::applyChanges({ mRoot + "/sub" });
+
+	EXPECT_EQ(nullptr, find("sub"));
+	EXPECT_EQ(nullptr, find("sub/b.zip"));
+	EXPECT_EQ(1u, gameCount());
+}
+
+TEST_F(RomWatcherTest, PathsOutsideTheSystemAreIgnored)
+{
+	RomWatcher::applyChanges({ "/nonexistent/a.zip", mRoot + "-other/a.zip" });
+	EXPECT_EQ(2u, gameCount());
+}
@@ -0,0 +1,351 @@
+#include "scrapers/Scraper.h"
+#include "Settings.h"
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+// The scraper requests run against a local HTTP server : the tests check what the server sees ( connections in flight,
+// retries after a 429 ) while the requests are driven the way ThreadedScraper::run drives them.
+
+namespace
+{
+	// Answers on 127.0.0.1, one thread per connection, "Connection: close" so that each request is one connection.
+	//   /ok?<ms>   waits <ms> then answers 200
+	//   /busy      answers 429 while busy() is set, then 200
+	//   /hold      never answers, until the client closes the connection
+	class StubServer
+	{
+	public:
+		StubServer() : mExit(false), mActive(0), mMaxActive(0), mRequests(0), mBusy(false)
+		{
+			mSocket = socket(AF_INET, SOCK_STREAM, 0);
+
+			int yes = 1;
+			setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+			sockaddr_in addr = {};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = 0;
+
+			bind(mSocket, (sockaddr*)&addr, sizeof(addr));
+			listen(mSocket, 64);
+
+			socklen_t len = sizeof(addr);
+			getsockname(mSocket, (sockaddr*)&addr, &len);
+			mPort = ntohs(addr.sin_port);
+
+			mThread = std::thread(&StubServer::run, this);
+		}
+
+		~StubServer()
+		{
+			mExit = true;
+			shutdown(mSocket, SHUT_RDWR);
+			close(mSocket);
+			mThread.join();
+
+			for (auto& t : mClients)
+				t.join();
+		}
+
+		std::string url(const std::string& path) { return "http://127.0.0.1:" + std::to_string(mPort) + path; }
+
+		int active() { return mActive; }
+		int maxActive() { return mMaxActive; }
+		int requests() { return mRequests; }
+
+		void setBusy(bool busy) { mBusy = busy; }
+
+	private:
+		void run()
+		{
+			while (!mExit)
+			{
+				pollfd pfd = { mSocket, POLLIN, 0 };
+				if (poll(&pfd, 1, 50) <= 0)
+					continue;
+
+				int client = accept(mSocket, nullptr, nullptr);
+				if (client < 0)
+					continue;
+
+				mClients.push_back(std::thread(&StubServer::serve, this, client));
+			}
+		}
+
+		void serve(int client)
+		{
+			std::string request;
+			char buf[1024];
+
+			while (request.find("\r\n\r\n") == std::string::npos)
+			{
+				int n = recv(client, buf, sizeof(buf), 0);
+				if (n <= 0)
+				{
+					close(client);
+					return;
+				}
+
+				request.append(buf, n);
+			}
+
+			mRequests++;
+
+			int active = ++mActive;
+			int max = mMaxActive;
+			while (active > max && !mMaxActive.compare_exchange_weak(max, active));
+
+			std::string path = request.substr(4, request.find(' ', 4) - 4);
+
+			int code = 200;
+			if (path.find("/ok?") == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(atoi(path.substr(4).c_str())));
+			else if (path == "/busy" && mBusy)
+				code = 429;
+			else if (path == "/hold")
+			{
+				// Until the client goes away
+				while (!mExit)
+				{
+					pollfd pfd = { client, POLLIN, 0 };
+					if (poll(&pfd, 1, 20) > 0 && recv(client, buf, sizeof(buf), 0) <= 0)
+						break;
+				}
+
+				mActive--;
+				close(client);
+				return;
+			}
+
+			std::string body = (code == 200 ? "ok" : "slow down");
+			std::string response = "HTTP/1.1 " + std::to_string(code) + (code == 200 ? " OK" : " Too Many Requests") + "\r\n"
+				"Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+			send(client, response.c_str(), response.size(), MSG_NOSIGNAL);
+
+			mActive--;
+			close(client);
+		}
+
+		int mPort;
+		int mSocket;
+		std::thread mThread;
+		std::list<std::thread> mClients;
+
+		std::atomic<bool> mExit;
+		std::atomic<int> mActive;
+		std::atomic<int> mMaxActive;
+		std::atomic<int> mRequests;
+		std::atomic<bool> mBusy;
+	};
+
+	class StubRequest : public ScraperHttpRequest
+	{
+	public:
+		StubRequest(std::vector<ScraperSearchResult>& results, const std::string& url) : ScraperHttpRequest(results, url) { }
+
+	protected:
+		bool process(HttpReq* request, std::vector<ScraperSearchResult>& results) override
+		{
+			ScraperSearchResult result;
+			result.mdl.set("desc", request->getContent());
+			results.push_back(result);
+			return true;
+		}
+	};
+
+	// A game for ThreadedScraper : one search made of one request
+	class StubSearch : public ScraperSearchHandle
+	{
+	public:
+		StubSearch(const std::string& url) { mRequestQueue.push(std::unique_ptr<ScraperRequest>(new StubRequest(mResults, url))); }
+	};
+
+	class ScraperRateLimiterTest : public ::testing::Test
+	{
+	protected:
+		static void SetUpTestCase()
+		{
+			MetaDataList::initMetadata();
+		}
+
+		void SetUp() override
+		{
+			// The limiter is shared by scraper name : each test starts with its own
+			Settings::getInstance()->setString("Scraper", ::testing::UnitTest::GetInstance()->current_test_info()->name());
+			mLimiter = ScraperRateLimiter::getInstance();
+		}
+
+		void TearDown() override
+		{
+			Settings::getInstance()->setString("Scraper", "ScreenScraper");
+		}
+
+		// Same loop as ThreadedScraper::run, without the UI. Returns the number of games which got a result
+		int scrape(const std::vector<std::string>& urls, int maxGames)
+		{
+			size_t next = 0;
+			int scraped = 0;
+
+			std::list<std::unique_ptr<StubSearch>> jobs;
+
+			while (next < urls.size() || !jobs.empty())
+			{
+				while (next < urls.size() && mLimiter->canStartGame((int)jobs.size(), maxGames))
+					jobs.push_back(std::unique_ptr<StubSearch>(new StubSearch(urls[next++])));
+
+				for (auto it = jobs.begin(); it != jobs.end(); )
+				{
+					if ((*it)->status() == ASYNC_IN_PROGRESS)
+					{
+						it++;
+						continue;
+					}
+
+					if ((*it)->status() == ASYNC_DONE && (*it)->getResults().size() == 1)
+						scraped++;
+
+					it = jobs.erase(it);
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+
+			return scraped;
+		}
+
+		StubServer mServer;
+		ScraperRateLimiter* mLimiter;
+	};
+}
+
+TEST_F(ScraperRateLimiterTest, GamesInFlightAreCapped)
+{
+	std::vector<std::string> urls;
+	for (int i = 0; i < 16; i++)
+		urls.push_back(mServer.url("/ok?100"));
+
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_EQ(16, scrape(urls, 4));
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+	EXPECT_EQ(16, mServer.requests());
+	EXPECT_EQ(4, mServer.maxActive());
+
+	// 4 rounds of 100 ms, not 16
+	EXPECT_LT(elapsed, 1200);
+}
+
+TEST_F(ScraperRateLimiterTest, TooManyRequestsPausesThenRetries)
+{
+	mServer.setBusy(true);
+
+	StubSearch search(mServer.url("/busy"));
+	while (search.status() == ASYNC_IN_PROGRESS && !mLimiter->isPaused())
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	auto pausedAt = std::chrono::steady_clock::now();
+
+	// The request waits for the limiter instead of sleeping, nothing is sent meanwhile
+	EXPECT_TRUE(mLimiter->isPaused());
+	EXPECT_FALSE(mLimiter->canStartGame(0, 4));
+	EXPECT_EQ(2, mLimiter->getMaxGames(4));
+
+	mServer.setBusy(false);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	EXPECT_EQ(ASYNC_IN_PROGRESS, search.status());
+	EXPECT_EQ(1, mServer.requests());
+
+	while (search.status() == ASYNC_IN_PROGRESS)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - pausedAt).count();
+
+	EXPECT_EQ(ASYNC_DONE, search.status());
+	ASSERT_EQ(1u, search.getResults().size());
+	EXPECT_EQ("ok", search.getResults()[0].mdl.get(MetaDataId::Desc));
+	EXPECT_EQ(2, mServer.requests());
+	EXPECT_GE(waited, 4900);
+}
+
+TEST_F(ScraperRateLimiterTest, CapComesBackAfterSuccesses)
+{
+	mLimiter->onTooManyRequests(0);
+	mLimiter->onTooManyRequests(0);
+	EXPECT_EQ(1, mLimiter->getMaxGames(4));
+
+	// Wait for the pause to end
+	while (mLimiter->isPaused())
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	// The cap is still lowered : 10 successful requests raise it one step at a time
+	std::vector<std::string> urls;
+	for (int i = 0; i < 10; i++)
+		urls.push_back(mServer.url("/ok?20"));
+
+	EXPECT_EQ(10, scrape(urls, 4));
+	EXPECT_EQ(1, mServer.maxActive());
+	EXPECT_EQ(2, mLimiter->getMaxGames(4));
+
+	EXPECT_EQ(10, scrape(urls, 4));
+	EXPECT_EQ(4, mLimiter->getMaxGames(4));
+}
+
+TEST_F(ScraperRateLimiterTest, CancelClosesConnections)
+{
+	std::vector<std::unique_ptr<StubSearch>> searches;
+	for (int i = 0; i < 3; i++)
+		searches.push_back(std::unique_ptr<StubSearch>(new StubSearch(mServer.url("/hold"))));
+
+	auto start = std::chrono::steady_clock::now();
+	while (mServer.active() < 3 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+	{
+		for (auto& search : searches)
+			search->status();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	ASSERT_EQ(3, mServer.active());
+
+	// ThreadedScraper::stop : the jobs are dropped with their requests in flight
+	searches.clear();
+
+	start = std::chrono::steady_clock::now();
+	while (mServer.active() > 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(5))
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	EXPECT_EQ(0, mServer.active());
+
+	// The shared curl handle still works
+	std::vector<std::string> urls = { mServer.url("/ok?0") };
+	EXPECT_EQ(1, scrape(urls, 4));
+}
+
+TEST_F(ScraperRateLimiterTest, CancelWhilePaused)
+{
+	mServer.setBusy(true);
+
+	std::unique_ptr<StubSearch> search(new StubSearch(mServer.url("/busy")));
+	while (!mLimiter->isPaused())
+	{
+		search->status();
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	// The request is waiting for the limiter, it has no HttpReq to release
+	search.reset();
+
+	mServer.setBusy(false);
+	EXPECT_EQ(1, mServer.requests());
+}
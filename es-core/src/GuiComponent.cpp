@@ -4,6 +4,7 @@
 #include "animations/AnimationController.h"
 #include "renderers/Renderer.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "ThemeData.h"
 #include "Window.h"
 #include <algorithm>
@@ -72,6 +73,8 @@ void GuiComponent::render(const Transform4x4f& parentTrans)
 
 void GuiComponent::renderChildren(const Transform4x4f& transform) const
 {
+	PROFILE_ZONE("GuiComponent::renderChildren");
+
 	for(unsigned int i = 0; i < getChildCount(); i++)
 		TRYCATCH("GuiComponent::renderChildren", getChild(i)->render(transform))		
 }
@@ -83,6 +86,9 @@ Vector3f GuiComponent::getPosition() const
 
 void GuiComponent::setPosition(float x, float y, float z)
 {
+	if (mPosition.x() != x || mPosition.y() != y || mPosition.z() != z)
+		Window::invalidate();
+
 	mPosition = Vector3f(x, y, z);
 	onPositionChanged();
 }
@@ -94,6 +100,9 @@ Vector2f GuiComponent::getOrigin() const
 
 void GuiComponent::setOrigin(float x, float y)
 {
+	if (mOrigin.x() != x || mOrigin.y() != y)
+		Window::invalidate();
+
 	mOrigin = Vector2f(x, y);
 	onOriginChanged();
 }
@@ -105,6 +114,9 @@ Vector2f GuiComponent::getRotationOrigin() const
 
 void GuiComponent::setRotationOrigin(float x, float y)
 {
+	if (mRotationOrigin.x() != x || mRotationOrigin.y() != y)
+		Window::invalidate();
+
 	mRotationOrigin = Vector2f(x, y);
 }
 
@@ -115,6 +127,9 @@ Vector2f GuiComponent::getSize() const
 
 void GuiComponent::setSize(float w, float h)
 {
+	if (mSize.x() != w || mSize.y() != h)
+		Window::invalidate();
+
 	mSize = Vector2f(w, h);
     onSizeChanged();
 }
@@ -126,6 +141,9 @@ float GuiComponent::getRotation() const
 
 void GuiComponent::setRotation(float rotation)
 {
+	if (mRotation != rotation)
+		Window::invalidate();
+
 	mRotation = rotation;
 }
 
@@ -136,6 +154,9 @@ float GuiComponent::getScale() const
 
 void GuiComponent::setScale(float scale)
 {
+	if (mScale != scale)
+		Window::invalidate();
+
 	mScale = scale;
 }
 
@@ -165,6 +186,9 @@ bool GuiComponent::isVisible() const
 }
 void GuiComponent::setVisible(bool visible)
 {
+	if (mVisible != visible)
+		Window::invalidate();
+
 	mVisible = visible;
 }
 
@@ -249,6 +273,8 @@ void GuiComponent::setOpacity(unsigned char opacity)
 	if (mOpacity == opacity)
 		return;
 
+	Window::invalidate();
+
 	mOpacity = opacity;
 	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
 	{
@@ -364,6 +390,8 @@ bool GuiComponent::advanceAnimation(unsigned char slot, unsigned int time)
 	AnimationController* anim = mAnimationMap[slot];
 	if(anim)
 	{
+		Window::invalidate();
+
 		bool done = anim->update(time);
 		if(done)
 		{
@@ -413,34 +441,43 @@ void GuiComponent::applyTheme(const std::shared_ptr<ThemeData>& theme, const std
 	if(!elem)
 		return;
 
+	// Every component goes through here : the property ids are resolved once
+	static const int pos = ThemeData::ThemeElement::getPropertyId("pos");
+	static const int size = ThemeData::ThemeElement::getPropertyId("size");
+	static const int origin = ThemeData::ThemeElement::getPropertyId("origin");
+	static const int rotation = ThemeData::ThemeElement::getPropertyId("rotation");
+	static const int rotationOrigin = ThemeData::ThemeElement::getPropertyId("rotationOrigin");
+	static const int zIndex = ThemeData::ThemeElement::getPropertyId("zIndex");
+	static const int visible = ThemeData::ThemeElement::getPropertyId("visible");
+
 	using namespace ThemeFlags;
-	if(properties & POSITION && elem->has("pos"))
+	if(properties & POSITION && elem->has(pos))
 	{
-		Vector2f denormalized = elem->get<Vector2f>("pos") * scale;
+		Vector2f denormalized = elem->get<Vector2f>(pos) * scale;
 		setPosition(Vector3f(denormalized.x(), denormalized.y(), 0));
 	}
 
-	if(properties & ThemeFlags::SIZE && elem->has("size"))
-		setSize(elem->get<Vector2f>("size") * scale);
+	if(properties & ThemeFlags::SIZE && elem->has(size))
+		setSize(elem->get<Vector2f>(size) * scale);
 
 	// position + size also implies origin
-	if((properties & ORIGIN || (properties & POSITION && properties & ThemeFlags::SIZE)) && elem->has("origin"))
-		setOrigin(elem->get<Vector2f>("origin"));
+	if((properties & ORIGIN || (properties & POSITION && properties & ThemeFlags::SIZE)) && elem->has(origin))
+		setOrigin(elem->get<Vector2f>(origin));
 
 	if(properties & ThemeFlags::ROTATION) {
-		if(elem->has("rotation"))
-			setRotationDegrees(elem->get<float>("rotation"));
-		if(elem->has("rotationOrigin"))
-			setRotationOrigin(elem->get<Vector2f>("rotationOrigin"));
+		if(elem->has(rotation))
+			setRotationDegrees(elem->get<float>(rotation));
+		if(elem->has(rotationOrigin))
+			setRotationOrigin(elem->get<Vector2f>(rotationOrigin));
 	}
 
-	if(properties & ThemeFlags::Z_INDEX && elem->has("zIndex"))
-		setZIndex(elem->get<float>("zIndex"));
+	if(properties & ThemeFlags::Z_INDEX && elem->has(zIndex))
+		setZIndex(elem->get<float>(zIndex));
 	else
 		setZIndex(getDefaultZIndex());
 
-	if(properties & ThemeFlags::VISIBLE && elem->has("visible"))
-		setVisible(elem->get<bool>("visible"));
+	if(properties & ThemeFlags::VISIBLE && elem->has(visible))
+		setVisible(elem->get<bool>(visible));
 	else
 		setVisible(true);
 }
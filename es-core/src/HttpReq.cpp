@@ -316,7 +316,7 @@ HttpReq::Status HttpReq::status()
 
 						if (http_status_code >= 400 && http_status_code < 499)
 						{
-							if (mFilePath.empty())
+							if (req->mFilePath.empty())
 								err = req->getContent();
 
 							req->mStatus = (Status)http_status_code;
@@ -331,9 +331,10 @@ HttpReq::Status HttpReq::status()
 					}
 					else
 					{
-						if (!mFilePath.empty())
+						// The message may be about another request than this one : use its own paths
+						if (!req->mFilePath.empty())
 						{
-							if (std::rename(mTempStreamPath.c_str(), mFilePath.c_str()) == 0)
+							if (std::rename(req->mTempStreamPath.c_str(), req->mFilePath.c_str()) == 0)
 								req->mStatus = REQ_SUCCESS;
 							else
 							{
@@ -5,10 +5,131 @@
 #include <string.h>
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "Settings.h"
+#include <algorithm>
+#include <stdio.h>
 #include <sstream>
 #include <fstream>
 #include <map>
 #include <mutex>
+#include <thread>
+#include "utils/ThreadPool.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// pshufb is SSSE3, which x86-64 builds don't enable by default : that kernel is built for it, and picked at runtime
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define IMAGEIO_SSSE3
+#include <tmmintrin.h>
+#endif
+
+// FreeImage stores pixels as BGR(A) in memory on little endian CPUs, textures are RGBA
+void ImageIO::convertBGRAToRGBA(const unsigned char* src, unsigned int* dst, int width)
+{
+	int x = 0;
+
+#if defined(__SSE2__)
+	const __m128i maskGA = _mm_set1_epi32(0xFF00FF00);
+	const __m128i maskB = _mm_set1_epi32(0x000000FF);
+
+	for (; x + 4 <= width; x += 4)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i*)(src + x * 4));
+		__m128i ga = _mm_and_si128(c, maskGA);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(c, maskB), 16);
+		__m128i r = _mm_and_si128(_mm_srli_epi32(c, 16), maskB);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(ga, _mm_or_si128(b, r)));
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for (; x + 16 <= width; x += 16)
+	{
+		uint8x16x4_t c = vld4q_u8(src + x * 4);
+		uint8x16_t b = c.val[0];
+		c.val[0] = c.val[2];
+		c.val[2] = b;
+		vst4q_u8((uint8_t*)(dst + x), c);
+	}
+#endif
+
+	const unsigned int* argb = (const unsigned int*)src;
+	for (; x < width; x++)
+	{
+		unsigned int c = argb[x];
+		dst[x] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+	}
+}
+
+#if defined(IMAGEIO_SSSE3)
+// 4 pixels per shuffle. Each load reads 16 bytes for the 12 it uses, hence the 2 extra pixels required
+__attribute__((target("ssse3"))) static int convertBGRToRGBA_SSSE3(const unsigned char* src, unsigned int* dst, int width)
+{
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+	int x = 0;
+	for (; x + 6 <= width; x += 4)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i*)(src + x * 3));
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_shuffle_epi8(c, shuffle), alpha));
+	}
+
+	return x;
+}
+
+static bool hasSSSE3()
+{
+	static bool supported = __builtin_cpu_supports("ssse3");
+	return supported;
+}
+#endif
+
+// 24 bits images are converted while being swizzled, instead of a FreeImage_ConvertTo32Bits pass
+void ImageIO::convertBGRToRGBA(const unsigned char* src, unsigned int* dst, int width)
+{
+	int x = 0;
+
+#if defined(IMAGEIO_SSSE3)
+	if (hasSSSE3())
+		x = convertBGRToRGBA_SSSE3(src, dst, width);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for (; x + 16 <= width; x += 16)
+	{
+		uint8x16x3_t c = vld3q_u8(src + x * 3);
+		uint8x16x4_t rgba;
+		rgba.val[0] = c.val[2];
+		rgba.val[1] = c.val[1];
+		rgba.val[2] = c.val[0];
+		rgba.val[3] = vdupq_n_u8(0xFF);
+		vst4q_u8((uint8_t*)(dst + x), rgba);
+	}
+#endif
+
+	for (src += x * 3; x < width; x++, src += 3)
+		dst[x] = 0xFF000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+}
+
+static void convertRowsToRGBA(FIBITMAP* bitmap, unsigned char* dest, int width, int start, int end)
+{
+	bool hasAlpha = FreeImage_GetBPP(bitmap) == 32;
+
+	for (int y = start; y < end; y++)
+	{
+		const unsigned char* src = FreeImage_GetScanLine(bitmap, y);
+		unsigned int* dst = (unsigned int*)(dest + (size_t)y * width * 4);
+
+		if (hasAlpha)
+			ImageIO::convertBGRAToRGBA(src, dst, width);
+		else
+			ImageIO::convertBGRToRGBA(src, dst, width);
+	}
+}
+
+#define PARALLEL_CONVERT_MIN_PIXELS (1024 * 1024)
+#define PARALLEL_CONVERT_MAX_STRIPS 4
 
 unsigned char* ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height, MaxSizeInfo* maxSize, Vector2i* baseSize, Vector2i* packedSize)
 {
@@ -17,10 +138,9 @@ unsigned char* ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const s
 	if (baseSize != nullptr)
 		*baseSize = Vector2i(0, 0);
 
-	if (baseSize != nullptr)
+	if (packedSize != nullptr)
 		*packedSize = Vector2i(0, 0);
 
-	std::vector<unsigned char> rawData;
 	width = 0;
 	height = 0;
 	FIMEMORY * fiMemory = FreeImage_OpenMemory((BYTE *)data, (DWORD)size);
@@ -30,12 +150,40 @@ unsigned char* ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const s
 		FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(fiMemory);
 		if (format != FIF_UNKNOWN && FreeImage_FIFSupportsReading(format))
 		{
+			bool hasMaxSize = maxSize != nullptr && maxSize->x() > 0 && maxSize->y() > 0;
+
+			// The size of the file, even if it is decoded at a lower scale
+			Vector2i imageSize(0, 0);
+
+			// JPEG can be decoded directly at 1/2, 1/4 or 1/8 of its size ( DCT scaling ) : ask for the nearest size above the target one
+			int flags = 0;
+			if (format == FIF_JPEG && hasMaxSize)
+			{
+				FIBITMAP* header = FreeImage_LoadFromMemory(format, fiMemory, FIF_LOAD_NOPIXELS);
+				if (header != nullptr)
+				{
+					imageSize = Vector2i(FreeImage_GetWidth(header), FreeImage_GetHeight(header));
+					FreeImage_Unload(header);
+
+					if (imageSize.x() > maxSize->x() || imageSize.y() > maxSize->y())
+					{
+						Vector2i sz = adjustPictureSize(imageSize, Vector2i(maxSize->x(), maxSize->y()), maxSize->externalZoom());
+						int requested = imageSize.x() >= imageSize.y() ? sz.x() : sz.y();
+						if (requested > 0 && requested < 0xFFFF)
+							flags = requested << 16;
+					}
+				}
+
+				FreeImage_SeekMemory(fiMemory, 0, SEEK_SET);
+			}
+
 			//file type is supported. load image
-			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory);
+			FIBITMAP * fiBitmap = FreeImage_LoadFromMemory(format, fiMemory, flags);
 			if (fiBitmap != nullptr)
 			{
-				//loaded. convert to 32bit if necessary
-				if (FreeImage_GetBPP(fiBitmap) != 32)
+				//loaded. convert to 32bit if necessary ( 24 bits images are converted with the swizzle )
+				unsigned int bpp = FreeImage_GetBPP(fiBitmap);
+				if (FreeImage_GetImageType(fiBitmap) != FIT_BITMAP || (bpp != 32 && bpp != 24))
 				{
 					FIBITMAP * fiConverted = FreeImage_ConvertTo32Bits(fiBitmap);
 					if (fiConverted != nullptr)
@@ -50,42 +198,55 @@ unsigned char* ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const s
 					width = FreeImage_GetWidth(fiBitmap);
 					height = FreeImage_GetHeight(fiBitmap);
 
+					if (flags == 0)
+						imageSize = Vector2i(width, height);
+
 					if (baseSize != nullptr)
-						*baseSize = Vector2i(width, height);
+						*baseSize = imageSize;
 
-					if (maxSize != nullptr && maxSize->x() > 0 && maxSize->y() > 0 && (width > maxSize->x() || height > maxSize->y()))
+					if (hasMaxSize && (imageSize.x() > maxSize->x() || imageSize.y() > maxSize->y()))
 					{
-						Vector2i sz = adjustPictureSize(Vector2i(width, height), Vector2i(maxSize->x(), maxSize->y()), maxSize->externalZoom());
+						Vector2i sz = adjustPictureSize(imageSize, Vector2i(maxSize->x(), maxSize->y()), maxSize->externalZoom());
 						if (sz.x() != width || sz.y() != height)
 						{
 							LOG(LogDebug) << "ImageIO : rescaling image from " << std::string(std::to_string(width) + "x" + std::to_string(height)).c_str() << " to " << std::string(std::to_string(sz.x()) + "x" + std::to_string(sz.y())).c_str();
 
 							FIBITMAP* imageRescaled = FreeImage_Rescale(fiBitmap, sz.x(), sz.y(), FILTER_BOX);
-							FreeImage_Unload(fiBitmap);
-							fiBitmap = imageRescaled;
+							if (imageRescaled != nullptr)
+							{
+								FreeImage_Unload(fiBitmap);
+								fiBitmap = imageRescaled;
+							}
 
 							width = FreeImage_GetWidth(fiBitmap);
 							height = FreeImage_GetHeight(fiBitmap);
-
-							if (packedSize != nullptr)
-								*packedSize = Vector2i(width, height);
 						}
+
+						if (packedSize != nullptr && (width != imageSize.x() || height != imageSize.y()))
+							*packedSize = Vector2i(width, height);
 					}
 
 					unsigned char* tempData = new unsigned char[width * height * 4];
 
-					int w = (int)width;
-
-					for (int y = (int)height; --y >= 0; )
+					// Large images are converted by strips on the shared ThreadPool
+					int h = (int)height;
+					Utils::ThreadPool* pool = (width * height >= PARALLEL_CONVERT_MIN_PIXELS) ? Utils::ThreadPool::getInstance() : nullptr;
+					int strips = pool != nullptr ? std::min(PARALLEL_CONVERT_MAX_STRIPS, pool->getThreadCount()) : 1;
+					if (strips > 1)
 					{
-						unsigned int* argb = (unsigned int*)FreeImage_GetScanLine(fiBitmap, y);
-						unsigned int* abgr = (unsigned int*)(tempData + (y * width * 4));
-						for (int x = w; --x >= 0;)
+						Utils::TaskGroup tasks;
+
+						int rows = (h + strips - 1) / strips;
+						for (int start = 0; start < h; start += rows)
 						{
-							unsigned int c = argb[x];
-							abgr[x] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+							int end = std::min(h, start + rows);
+							tasks.run([fiBitmap, tempData, width, start, end] { convertRowsToRGBA(fiBitmap, tempData, (int)width, start, end); });
 						}
+
+						tasks.wait();
 					}
+					else
+						convertRowsToRGBA(fiBitmap, tempData, (int)width, 0, h);
 
 					FreeImage_Unload(fiBitmap);
 					FreeImage_CloseMemory(fiMemory);
@@ -111,16 +272,18 @@ unsigned char* ImageIO::loadFromMemoryRGBA32(const unsigned char * data, const s
 
 void ImageIO::flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height)
 {
-	unsigned int temp;
-	unsigned int* arr = (unsigned int*)imagePx;
-	for(size_t y = 0; y < height / 2; y++)
+	// Swap whole rows
+	size_t pitch = width * 4;
+	std::vector<unsigned char> row(pitch);
+
+	unsigned char* top = imagePx;
+	unsigned char* bottom = imagePx + (height - 1) * pitch;
+
+	for (size_t y = 0; y < height / 2; y++, top += pitch, bottom -= pitch)
 	{
-		for(size_t x = 0; x < width; x++)
-		{
-			temp = arr[x + (y * width)];
-			arr[x + (y * width)] = arr[x + (height * width) - ((y + 1) * width)];
-			arr[x + (height * width) - ((y + 1) * width)] = temp;
-		}
+		memcpy(row.data(), top, pitch);
+		memcpy(top, bottom, pitch);
+		memcpy(bottom, row.data(), pitch);
 	}
 }
 
@@ -252,6 +415,8 @@ void ImageIO::loadImageCache()
 
 void ImageIO::saveImageCache()
 {
+	pruneDiskCache();
+
 	if (!sizeCacheDirty)
 		return;
 
@@ -342,7 +507,7 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 	LOG(LogDebug) << "ImageIO::loadImageSize " << fn;
 
 	auto ext = Utils::String::toLower(Utils::FileSystem::getExtension(fn));
-	if (ext != ".jpg" && ext != ".png" && ext != ".jpeg" && ext != ".gif")
+	if (ext != ".jpg" && ext != ".png" && ext != ".jpeg" && ext != ".gif" && ext != ".webp" && ext != ".svg")
 	{
 		LOG(LogWarning) << "ImageIO::loadImageSize\tUnknown file type";
 		return false;
@@ -350,6 +515,19 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 
 	auto size = Utils::FileSystem::getFileSize(fn);
 
+	if (ext == ".svg")
+	{
+		if (loadSvgSize(fn, x, y))
+		{
+			LOG(LogDebug) << "ImageIO::loadImageSize\tSVG size " << std::string(std::to_string(*x) + "x" + std::to_string(*y)).c_str();
+			updateImageCache(fn, size, *x, *y);
+			return true;
+		}
+
+		// Sizes in physical units or percentages are left to nanosvg : not cached, the texture will be loaded to know it
+		return false;
+	}
+
 	FILE *f = fopen(fn, "rb");
 	if (f == 0)
 	{
@@ -362,28 +540,33 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 	// reading GIF dimensions requires the first 10 bytes of the file
 	// reading PNG dimensions requires the first 24 bytes of the file
 	// reading JPEG dimensions requires scanning through jpeg chunks
+	// reading WEBP dimensions requires the first 30 bytes of the file
 	// In all formats, the file is at least 24 bytes big, so we'll read that always
-	unsigned char buf[24]; 
-	if (fread(buf, 1, 24, f) != 24)
+	unsigned char buf[30]; 
+	size_t bufSize = fread(buf, 1, 30, f);
+	if (bufSize < 24)
 	{
+		fclose(f);
 		updateImageCache(fn, -1, -1, -1);
 		return false;
 	}
 
 	// For JPEGs, we need to read the first 12 bytes of each chunk.
 	// We'll read those 12 bytes at buf+2...buf+14, i.e. overwriting the existing buf.
+	// Not only JFIF & Exif : any marker can follow SOI ( ICC profiles, quantization tables... )
 	bool jfif = false;
 
-	if ((buf[0] == 0xFF && buf[1] == 0xD8 && buf[2] == 0xFF && buf[3] == 0xE0 && buf[6] == 'J' && buf[7] == 'F' && buf[8] == 'I' && buf[9] == 'F') ||
-		(buf[0] == 0xFF && buf[1] == 0xD8 && buf[2] == 0xFF && buf[3] == 0xE1 && buf[6] == 'E' && buf[7] == 'x' && buf[8] == 'i' && buf[9] == 'f'))
+	if (buf[0] == 0xFF && buf[1] == 0xD8 && buf[2] == 0xFF)
 	{
-		jfif = true;
-
 		long pos = 2;
 		while (buf[2] == 0xFF)
 		{
-			if (buf[3] == 0xC0 || buf[3] == 0xC1 || buf[3] == 0xC2 || buf[3] == 0xC3 || buf[3] == 0xC9 || buf[3] == 0xCA || buf[3] == 0xCB)
+			// SOF markers, except DHT (C4), JPG (C8) and DAC (CC)
+			if (buf[3] >= 0xC0 && buf[3] <= 0xCF && buf[3] != 0xC4 && buf[3] != 0xC8 && buf[3] != 0xCC)
+			{
+				jfif = true;
 				break;
+			}
 
 			pos += 2 + (buf[4] << 8) + buf[5];
 		
@@ -439,7 +622,336 @@ bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 		return true;
 	}
 
+	// WEBP: RIFF container, the size is in the first chunk ( lossy, lossless or extended )
+	if (bufSize >= 30 && buf[0] == 'R' && buf[1] == 'I' && buf[2] == 'F' && buf[3] == 'F' && buf[8] == 'W' && buf[9] == 'E' && buf[10] == 'B' && buf[11] == 'P' &&
+		buf[12] == 'V' && buf[13] == 'P' && buf[14] == '8')
+	{
+		bool known = true;
+
+		if (buf[15] == ' ' && buf[23] == 0x9D && buf[24] == 0x01 && buf[25] == 0x2A)
+		{
+			*x = (buf[26] | (buf[27] << 8)) & 0x3FFF;
+			*y = (buf[28] | (buf[29] << 8)) & 0x3FFF;
+		}
+		else if (buf[15] == 'L' && buf[20] == 0x2F)
+		{
+			unsigned int bits = buf[21] | (buf[22] << 8) | (buf[23] << 16) | (buf[24] << 24);
+			*x = (bits & 0x3FFF) + 1;
+			*y = ((bits >> 14) & 0x3FFF) + 1;
+		}
+		else if (buf[15] == 'X')
+		{
+			*x = (buf[24] | (buf[25] << 8) | (buf[26] << 16)) + 1;
+			*y = (buf[27] | (buf[28] << 8) | (buf[29] << 16)) + 1;
+		}
+		else
+			known = false;
+
+		if (known)
+		{
+			LOG(LogDebug) << "ImageIO::loadImageSize\tWEBP size " << std::string(std::to_string(*x) + "x" + std::to_string(*y)).c_str();
+
+			updateImageCache(fn, size, *x, *y);
+			return true;
+		}
+	}
+
 	updateImageCache(fn, -1, -1, -1);
 	LOG(LogWarning) << "ImageIO::loadImageSize\tUnable to extract size";
 	return false;
 }
+
+// Reads the size of the <svg> root element the way nanosvg computes it in pixels, when it's not expressed in physical units or percents
+static bool parseSvgLength(const std::string& tag, const std::string& name, float& value)
+{
+	std::string attribute = " " + name + "=";
+
+	size_t pos = tag.find(attribute);
+	if (pos == std::string::npos)
+	{
+		attribute = "\n" + name + "=";
+		pos = tag.find(attribute);
+		if (pos == std::string::npos)
+			return false;
+	}
+
+	pos += attribute.size();
+	if (pos >= tag.size() || (tag[pos] != '"' && tag[pos] != '\''))
+		return false;
+
+	size_t end = tag.find(tag[pos], pos + 1);
+	if (end == std::string::npos)
+		return false;
+
+	std::string text = Utils::String::trim(tag.substr(pos + 1, end - pos - 1));
+	if (Utils::String::endsWith(text, "px"))
+		text = text.substr(0, text.size() - 2);
+
+	if (text.empty() || text.find_first_not_of("0123456789.") != std::string::npos)
+		return false;
+
+	value = (float)atof(text.c_str());
+	return value > 0;
+}
+
+bool ImageIO::loadSvgSize(const char *fn, unsigned int *x, unsigned int *y)
+{
+	FILE *f = fopen(fn, "rb");
+	if (f == 0)
+		return false;
+
+	char buf[4096];
+	size_t length = fread(buf, 1, sizeof(buf), f);
+	fclose(f);
+
+	std::string header(buf, length);
+
+	size_t start = header.find("<svg");
+	if (start == std::string::npos)
+		return false;
+
+	size_t end = header.find('>', start);
+	if (end == std::string::npos)
+		return false;
+
+	std::string tag = header.substr(start, end - start);
+	for (auto& c : tag)
+		if (c == '\t' || c == '\r')
+			c = ' ';
+
+	float width = 0;
+	float height = 0;
+
+	bool hasWidth = tag.find(" width=") != std::string::npos || tag.find("\nwidth=") != std::string::npos;
+	bool hasHeight = tag.find(" height=") != std::string::npos || tag.find("\nheight=") != std::string::npos;
+
+	if (hasWidth || hasHeight)
+	{
+		if (!parseSvgLength(tag, "width", width) || !parseSvgLength(tag, "height", height))
+			return false;
+	}
+	else
+	{
+		size_t pos = tag.find("viewBox=");
+		if (pos == std::string::npos || pos + 9 >= tag.size())
+			return false;
+
+		size_t close = tag.find(tag[pos + 8], pos + 9);
+		if (close == std::string::npos)
+			return false;
+
+		std::string viewBox = tag.substr(pos + 9, close - pos - 9);
+		for (auto& c : viewBox)
+			if (c == ',')
+				c = ' ';
+
+		float minX, minY;
+		if (sscanf(viewBox.c_str(), "%f %f %f %f", &minX, &minY, &width, &height) != 4 || width <= 0 || height <= 0)
+			return false;
+	}
+
+	*x = (unsigned int)(width + 0.5f);
+	*y = (unsigned int)(height + 0.5f);
+	return *x > 0 && *y > 0;
+}
+
+
+// Decoded images disk cache
+//   header, then the key ( path|target size ), then width * height RGBA pixels as returned by loadFromMemoryRGBA32.
+//   The size & date of the source file are in the header : a file replaced by the scraper finds its old entry, and removes it
+#define DISKCACHE_MAGIC		0x43545345 // "ESTC"
+#define DISKCACHE_VERSION	2
+#define DISKCACHE_MAXSIZE	8192
+
+struct DiskCacheHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int keyLength;
+	unsigned int width;
+	unsigned int height;
+	unsigned int baseWidth;
+	unsigned int baseHeight;
+	unsigned int fileSize;
+	long long fileDate;
+};
+
+static std::string getDiskCachePath()
+{
+	return Utils::FileSystem::getEsConfigPath() + "/cache/images";
+}
+
+static bool getDiskCacheKey(const std::string& path, MaxSizeInfo* maxSize, std::string& key, std::string& cacheFile, size_t& fileSize, long long& fileDate)
+{
+	if (path.empty() || path[0] == ':' || !Settings::getInstance()->getBool("ImageDiskCache"))
+		return false;
+
+	fileSize = Utils::FileSystem::getFileSize(path);
+	if (fileSize == 0)
+		return false;
+
+	fileDate = (long long)Utils::FileSystem::getFileModificationDate(path).getTime();
+
+	key = path + "|" + std::to_string((int)maxSize->x()) + "x" + std::to_string((int)maxSize->y()) + (maxSize->externalZoom() ? "z" : "");
+
+	char hash[32];
+	snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) std::hash<std::string>()(key));
+	cacheFile = getDiskCachePath() + "/" + hash + ".rgba";
+	return true;
+}
+
+unsigned char* ImageIO::loadFromDiskCache(const std::string& path, MaxSizeInfo* maxSize, size_t& width, size_t& height, Vector2i* baseSize, size_t* fileSize)
+{
+	std::string key;
+	std::string cacheFile;
+	size_t size;
+	long long date;
+
+	if (maxSize == nullptr || !getDiskCacheKey(path, maxSize, key, cacheFile, size, date))
+		return nullptr;
+
+	FILE* file = fopen(cacheFile.c_str(), "rb");
+	if (file == nullptr)
+		return nullptr;
+
+	DiskCacheHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != DISKCACHE_MAGIC || header.version != DISKCACHE_VERSION ||
+		header.keyLength != key.size() || header.width == 0 || header.height == 0 || header.width > DISKCACHE_MAXSIZE || header.height > DISKCACHE_MAXSIZE)
+	{
+		fclose(file);
+		return nullptr;
+	}
+
+	// Another file with the same hash
+	std::string fileKey(header.keyLength, '\0');
+	if (fread(&fileKey[0], 1, header.keyLength, file) != header.keyLength || fileKey != key)
+	{
+		fclose(file);
+		return nullptr;
+	}
+
+	// The source file has changed since : the entry is of no use anymore
+	if (header.fileSize != (unsigned int)size || header.fileDate != date)
+	{
+		LOG(LogDebug) << "ImageIO::loadFromDiskCache " << path << " has changed";
+
+		fclose(file);
+		Utils::FileSystem::removeFile(cacheFile);
+		return nullptr;
+	}
+
+	size_t length = (size_t)header.width * (size_t)header.height * 4;
+
+	unsigned char* data = new unsigned char[length];
+	if (fread(data, 1, length, file) != length)
+	{
+		delete[] data;
+		fclose(file);
+		return nullptr;
+	}
+
+	fclose(file);
+
+	LOG(LogDebug) << "ImageIO::loadFromDiskCache " << path;
+
+	width = header.width;
+	height = header.height;
+
+	if (baseSize != nullptr)
+		*baseSize = Vector2i(header.baseWidth, header.baseHeight);
+
+	if (fileSize != nullptr)
+		*fileSize = size;
+
+	return data;
+}
+
+void ImageIO::saveToDiskCache(const std::string& path, MaxSizeInfo* maxSize, const unsigned char* data, size_t width, size_t height, Vector2i baseSize)
+{
+	std::string key;
+	std::string cacheFile;
+	size_t size;
+	long long date;
+
+	if (data == nullptr || maxSize == nullptr || width == 0 || height == 0 || !getDiskCacheKey(path, maxSize, key, cacheFile, size, date))
+		return;
+
+	std::string folder = getDiskCachePath();
+	if (!Utils::FileSystem::exists(folder))
+		Utils::FileSystem::createDirectory(folder);
+
+	DiskCacheHeader header;
+	header.magic = DISKCACHE_MAGIC;
+	header.version = DISKCACHE_VERSION;
+	header.keyLength = (unsigned int)key.size();
+	header.width = (unsigned int)width;
+	header.height = (unsigned int)height;
+	header.baseWidth = (unsigned int)baseSize.x();
+	header.baseHeight = (unsigned int)baseSize.y();
+	header.fileSize = (unsigned int)size;
+	header.fileDate = date;
+
+	// Textures are loaded from several threads : write a temporary file so a reader never sees a partial one
+	std::string tmpFile = cacheFile + "." + std::to_string((unsigned long long) std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	FILE* file = fopen(tmpFile.c_str(), "wb");
+	if (file == nullptr)
+		return;
+
+	size_t length = width * height * 4;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(key.c_str(), 1, key.size(), file) == key.size() &&
+		fwrite(data, 1, length, file) == length;
+
+	fclose(file);
+
+	if (!ok || std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0)
+		Utils::FileSystem::removeFile(tmpFile);
+}
+
+// Removes the oldest files when the cache is bigger than "ImageDiskCacheSize" megabytes
+void ImageIO::pruneDiskCache()
+{
+	std::string folder = getDiskCachePath();
+	if (!Utils::FileSystem::exists(folder))
+		return;
+
+	size_t maxSize = (size_t)std::max(0, Settings::getInstance()->getInt("ImageDiskCacheSize")) * 1024 * 1024;
+
+	struct CacheFile
+	{
+		std::string path;
+		size_t size;
+		time_t date;
+	};
+
+	std::vector<CacheFile> files;
+	size_t total = 0;
+
+	for (auto file : Utils::FileSystem::getDirContent(folder))
+	{
+		CacheFile cf;
+		cf.path = file;
+		cf.size = Utils::FileSystem::getFileSize(file);
+		cf.date = Utils::FileSystem::getFileModificationDate(file).getTime();
+		total += cf.size;
+		files.push_back(cf);
+	}
+
+	if (total <= maxSize)
+		return;
+
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.date < b.date; });
+
+	for (auto& file : files)
+	{
+		if (total <= maxSize)
+			break;
+
+		if (Utils::FileSystem::removeFile(file.path))
+			total -= file.size;
+	}
+
+	LOG(LogInfo) << "ImageIO::pruneDiskCache : cache reduced to " << total / 1024 << " KB";
+}
@@ -3,6 +3,7 @@
 #define ES_CORE_IMAGE_IO
 
 #include <stdlib.h>
+#include <string>
 #include <vector>
 #include "math/Vector2f.h"
 #include "math/Vector2i.h"
@@ -46,14 +47,25 @@ public:
 	static unsigned char*  loadFromMemoryRGBA32(const unsigned char * data, const size_t size, size_t & width, size_t & height, MaxSizeInfo* maxSize = nullptr, Vector2i* baseSize = nullptr, Vector2i* packedSize = nullptr);
 	static void flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height);
 
+	// One FreeImage scanline ( BGRA or BGR, as stored on little endian CPUs ) to RGBA pixels
+	static void convertBGRAToRGBA(const unsigned char* src, unsigned int* dst, int width);
+	static void convertBGRToRGBA(const unsigned char* src, unsigned int* dst, int width);
+
 	// batocera
 	static Vector2f getPictureMinSize(Vector2f imageSize, Vector2f maxSize);
 	static Vector2i adjustPictureSize(Vector2i imageSize, Vector2i maxSize, bool externSize = false);
 	static bool		loadImageSize(const char *fn, unsigned int *x, unsigned int *y);
+	static bool		loadSvgSize(const char *fn, unsigned int *x, unsigned int *y);
 
 	static void		updateImageCache(const std::string fn, int sz, int x, int y);
 	static void		loadImageCache();
 	static void		saveImageCache();	
+
+	// Downscaled images are kept decoded on disk, keyed by file path, size, date and target size.
+	// Returns nullptr when the file is not cached or has changed since.
+	static unsigned char*	loadFromDiskCache(const std::string& path, MaxSizeInfo* maxSize, size_t& width, size_t& height, Vector2i* baseSize, size_t* fileSize = nullptr);
+	static void				saveToDiskCache(const std::string& path, MaxSizeInfo* maxSize, const unsigned char* data, size_t width, size_t height, Vector2i baseSize);
+	static void				pruneDiskCache();
 };
 
 #endif // ES_CORE_IMAGE_IO
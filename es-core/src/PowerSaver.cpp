@@ -15,6 +15,7 @@ PowerSaver::mode PowerSaver::mMode = PowerSaver::DISABLED;
 bool PowerSaver::mHasPushedEvent = false;
 int PowerSaver::mPushEventID = -1;
 int PowerSaver::mPauseCounter = 0;
+bool PowerSaver::mLocked = false;
 
 void PowerSaver::pushRefreshEvent()
 {
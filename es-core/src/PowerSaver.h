@@ -48,6 +48,8 @@ public:
 
 	static void lock(bool state)
 	{
+		mLocked = !state;
+
 		if (state)
 		{
 			if (mPauseCounter == 0)
@@ -58,6 +60,9 @@ public:
 	}
 
 
+	// Something is animating ( paused or locked ), whether the power saver is enabled or not
+	static bool isActive() { return mPauseCounter > 0 || mLocked; }
+
 	// This is used by ScreenSaver to let PS know when to switch to SS timeouts
 	static void runningScreenSaver(bool state);
 	static bool isScreenSaverActive();
@@ -79,6 +84,7 @@ private:
 
 
 	static int mPauseCounter;
+	static bool mLocked;
 };
 
 #endif // ES_CORE_POWER_SAVER_H
@@ -0,0 +1,211 @@
+#include "Profiler.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#define PROFILER_EVENTS 16384 // per thread
+#define PROFILER_FRAMES 512
+
+std::atomic<bool> Profiler::sEnabled(false);
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		long long	start;
+		long long	end;
+	};
+
+	// Only the owning thread writes. Readers may see an entry being overwritten, which is fine for diagnostics
+	struct ThreadBuffer
+	{
+		ThreadBuffer(int id) : threadId(id), count(0), readCount(0), inUse(true) { events.resize(PROFILER_EVENTS); }
+
+		int							threadId;
+		std::vector<Event>			events;
+		std::atomic<unsigned int>	count;
+		unsigned int				readCount; // getTopZones, UI thread only
+		std::atomic<bool>			inUse;
+	};
+
+	std::mutex									sBuffersLock;
+	std::vector<std::unique_ptr<ThreadBuffer>>	sBuffers;
+
+	// Gives the buffer back when the thread exits, its events stay available for the dumps
+	struct ThreadBufferOwner
+	{
+		ThreadBufferOwner() : buffer(nullptr) { }
+		~ThreadBufferOwner() { if (buffer != nullptr) buffer->inUse = false; }
+
+		ThreadBuffer* get()
+		{
+			if (buffer != nullptr)
+				return buffer;
+
+			std::unique_lock<std::mutex> lock(sBuffersLock);
+
+			for (auto& it : sBuffers)
+			{
+				if (!it->inUse)
+				{
+					it->inUse = true;
+					buffer = it.get();
+					return buffer;
+				}
+			}
+
+			sBuffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer((int)sBuffers.size() + 1)));
+			buffer = sBuffers.back().get();
+			return buffer;
+		}
+
+		ThreadBuffer* buffer;
+	};
+
+	thread_local ThreadBufferOwner sThreadBuffer;
+
+	float		sFrames[PROFILER_FRAMES];
+	unsigned int sFrameCount = 0;
+	long long	sLastFrame = 0;
+}
+
+long long Profiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::record(const char* name, long long start, long long end)
+{
+	ThreadBuffer* buffer = sThreadBuffer.get();
+
+	unsigned int index = buffer->count.load(std::memory_order_relaxed);
+
+	Event& evt = buffer->events[index % PROFILER_EVENTS];
+	evt.name = name;
+	evt.start = start;
+	evt.end = end;
+
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::frame()
+{
+	long long time = now();
+
+	if (sLastFrame != 0)
+	{
+		sFrames[sFrameCount % PROFILER_FRAMES] = (time - sLastFrame) / 1000.0f;
+		sFrameCount++;
+	}
+
+	sLastFrame = time;
+}
+
+void Profiler::skipFrame()
+{
+	sLastFrame = 0;
+}
+
+void Profiler::getFramePercentiles(float& p50, float& p95, float& p99)
+{
+	p50 = p95 = p99 = 0;
+
+	int count = (int)std::min(sFrameCount, (unsigned int)PROFILER_FRAMES);
+	if (count == 0)
+		return;
+
+	std::vector<float> frames(sFrames, sFrames + count);
+	std::sort(frames.begin(), frames.end());
+
+	p50 = frames[(count - 1) * 50 / 100];
+	p95 = frames[(count - 1) * 95 / 100];
+	p99 = frames[(count - 1) * 99 / 100];
+}
+
+std::vector<Profiler::ZoneTotal> Profiler::getTopZones(int count)
+{
+	std::map<const char*, ZoneTotal> totals;
+
+	{
+		std::unique_lock<std::mutex> lock(sBuffersLock);
+
+		for (auto& buffer : sBuffers)
+		{
+			unsigned int end = buffer->count.load(std::memory_order_acquire);
+			unsigned int start = std::max(buffer->readCount, end > PROFILER_EVENTS ? end - PROFILER_EVENTS : 0);
+
+			for (unsigned int i = start; i < end; i++)
+			{
+				const Event& evt = buffer->events[i % PROFILER_EVENTS];
+
+				auto it = totals.find(evt.name);
+				if (it == totals.cend())
+					totals[evt.name] = { evt.name, evt.end - evt.start, 1 };
+				else
+				{
+					it->second.duration += evt.end - evt.start;
+					it->second.count++;
+				}
+			}
+
+			buffer->readCount = end;
+		}
+	}
+
+	std::vector<ZoneTotal> ret;
+	for (auto& it : totals)
+		ret.push_back(it.second);
+
+	std::sort(ret.begin(), ret.end(), [](const ZoneTotal& a, const ZoneTotal& b) { return a.duration > b.duration; });
+
+	if ((int)ret.size() > count)
+		ret.resize(count);
+
+	return ret;
+}
+
+bool Profiler::dump(const std::string& path)
+{
+	std::ofstream f(path.c_str(), std::ios::binary);
+	if (f.fail())
+	{
+		LOG(LogError) << "Profiler::dump : unable to write " << path;
+		return false;
+	}
+
+	f << "{\"traceEvents\":[";
+
+	bool first = true;
+
+	std::unique_lock<std::mutex> lock(sBuffersLock);
+
+	for (auto& buffer : sBuffers)
+	{
+		unsigned int end = buffer->count.load(std::memory_order_acquire);
+		unsigned int start = end > PROFILER_EVENTS ? end - PROFILER_EVENTS : 0;
+
+		for (unsigned int i = start; i < end; i++)
+		{
+			const Event& evt = buffer->events[i % PROFILER_EVENTS];
+			if (evt.name == nullptr)
+				continue;
+
+			f << (first ? "\n" : ",\n");
+			f << "{\"name\":\"" << evt.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":" << evt.start << ",\"dur\":" << (evt.end - evt.start) << "}";
+
+			first = false;
+		}
+	}
+
+	f << "\n]}\n";
+	f.close();
+
+	LOG(LogInfo) << "Profiler::dump : trace saved to " << path;
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef ES_CORE_PROFILER_H
+#define ES_CORE_PROFILER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Scoped timing zones, written to a ring buffer owned by each thread ( no lock once the thread is registered ).
+// Zone names must be string literals : only the pointer is stored.
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_ZONE_CONCAT(profilerZone, __LINE__)(name)
+
+class Profiler
+{
+public:
+	class Zone
+	{
+	public:
+		Zone(const char* name) : mName(sEnabled ? name : nullptr), mStart(mName != nullptr ? now() : 0) { }
+		~Zone() { if (mName != nullptr) record(mName, mStart, now()); }
+
+	private:
+		const char* mName;
+		long long	mStart;
+	};
+
+	struct ZoneTotal
+	{
+		const char* name;
+		long long	duration; // us
+		int			count;
+	};
+
+	static void setEnabled(bool enabled) { sEnabled = enabled; }
+	static bool isEnabled() { return sEnabled; }
+
+	// UI thread, once per rendered frame
+	static void frame();
+	static void skipFrame(); // the next frame time would include the idle time
+	static void getFramePercentiles(float& p50, float& p95, float& p99); // ms
+
+	// Zones that took the most time since the previous call ( inclusive of nested zones )
+	static std::vector<ZoneTotal> getTopZones(int count);
+
+	// Chrome trace / Perfetto JSON
+	static bool dump(const std::string& path);
+
+	static long long now(); // us
+
+private:
+	static void record(const char* name, long long start, long long end);
+
+	static std::atomic<bool> sEnabled;
+};
+
+#endif // ES_CORE_PROFILER_H
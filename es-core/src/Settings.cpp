@@ -9,7 +9,8 @@
 #include <vector>
 
 Settings* Settings::sInstance = NULL;
-static std::string mEmptyString = "";
+std::mutex Settings::sKeysLock;
+std::unordered_map<std::string, int> Settings::sKeyIds;
 
 // these values are NOT saved to es_settings.xml
 // since they're set through command-line arguments, and not the in-program settings menu
@@ -36,12 +37,17 @@ std::vector<const char*> settings_dont_save {
 	{ "ScreenOffsetY" },
 	{ "ScreenRotate" },
 	{ "MonitorID" },
+	{ "HeadlessDumpPath" },
+	{ "Profiler" },
 };
 
-Settings::Settings()
+Settings::Settings() : mBatchUpdate(true), mUpdateDepth(0), mPendingUpdate(false), mGeneration(0)
 {
 	setDefaults();
 	loadFile();
+
+	mBatchUpdate = false;
+	updateSnapshot();
 }
 
 Settings* Settings::getInstance()
@@ -61,14 +67,19 @@ void Settings::setDefaults()
 	mBoolMap["BackgroundJoystickInput"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
 	mBoolMap["ShowHiddenFiles"] = false;
+	mBoolMap["WatchRomFolders"] = false;
 	mBoolMap["ShowParentFolder"] = true;
 	mBoolMap["DrawFramerate"] = false;
+	mBoolMap["Profiler"] = false;
+	mBoolMap["IdleFrameSkip"] = false;
 	mBoolMap["ShowExit"] = true;	
 	mBoolMap["Windowed"] = false;
 	mBoolMap["SplashScreen"] = true;
 	mBoolMap["SplashScreenProgress"] = true;
 	mBoolMap["StartupOnGameList"] = false;
 	mStringMap["StartupSystem"] = "";
+	mStringMap["HeadlessDumpPath"] = "";
+	mIntMap["HeadlessDumpInterval"] = 60;
 
 #if WIN32
 	mBoolMap["ShowOnlyExit"] = true;
@@ -102,6 +113,7 @@ void Settings::setDefaults()
 	mBoolMap["ShowHelpPrompts"] = true;
 	mBoolMap["ScrapeRatings"] = true;
 	mBoolMap["IgnoreGamelist"] = false;
+	mBoolMap["UseGamelistCache"] = true;
 	mBoolMap["HideConsole"] = true;
 	mBoolMap["QuickSystemSelect"] = true;
 	mBoolMap["MoveCarousel"] = true;
@@ -116,6 +128,7 @@ void Settings::setDefaults()
 	mIntMap["ScreenSaverTime"] = 5*60*1000; // 5 minutes
 	mIntMap["ScraperResizeWidth"] = 400;
 	mIntMap["ScraperResizeHeight"] = 0;
+	mIntMap["ScraperThreads"] = 2; // Games scraped at the same time by ThreadedScraper
 
 #if defined(_WIN32)
 	mIntMap["MaxVRAM"] = 256;
@@ -207,9 +220,13 @@ void Settings::setDefaults()
 	mStringMap["DefaultGridSize"] = "";
 
 	mBoolMap["ThreadedLoading"] = true;
+	mIntMap["ThreadPoolSize"] = 0;
 	mBoolMap["AsyncImages"] = true;	
 	mBoolMap["PreloadUI"] = false;
 	mBoolMap["OptimizeVRAM"] = true;
+	mBoolMap["ImageDiskCache"] = true;
+	mIntMap["ImageDiskCacheSize"] = 256; // MB
+	mIntMap["ResumeCacheSize"] = 0; // MB, RAM copy of the decoded textures, filled at upload & kept while games run. Opt-in
 	mBoolMap["OptimizeVideo"] = true;
 
 	mBoolMap["ShowFilenames"] = false;
@@ -286,6 +303,8 @@ void saveMap(pugi::xml_node &node, std::map<K, V>& map, const char* type, std::m
 // batocera
 bool Settings::saveFile()
 {
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+
 	if (!mWasChanged)
 		return false;
 
@@ -346,6 +365,12 @@ void Settings::loadFile()
 		return;
 	}
 
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+
+	// One snapshot for the whole file
+	bool batchUpdate = mBatchUpdate;
+	mBatchUpdate = true;
+
 	pugi::xml_node root = doc;
 
 	// Batocera use a <config> root element
@@ -363,46 +388,158 @@ void Settings::loadFile()
 		setString(node.attribute("name").as_string(), node.attribute("value").as_string());    
 
 	mWasChanged = false;
+
+	mBatchUpdate = batchUpdate;
+	updateSnapshot();
+}
+
+int Settings::getKeyId(const std::string& name)
+{
+	std::unique_lock<std::mutex> lock(sKeysLock);
+
+	auto it = sKeyIds.find(name);
+	if (it != sKeyIds.cend())
+		return it->second;
+
+	int id = (int)sKeyIds.size();
+	sKeyIds[name] = id;
+	return id;
+}
+
+const Settings::Snapshot* Settings::getSnapshot()
+{
+	// Each thread keeps the last snapshot it read, and only loads the shared pointer again when the generation has changed
+	thread_local std::shared_ptr<const Snapshot> current;
+
+	if (mPendingUpdate.load(std::memory_order_acquire))
+		publishPendingUpdate();
+
+	if (current == nullptr || current->generation != mGeneration.load(std::memory_order_acquire))
+		current = std::atomic_load(&mSnapshot);
+
+	return current.get();
 }
 
-//Print a warning message if the setting we're trying to get doesn't already exist in the map, then return the value in the map.
-#define SETTINGS_GETSET(type, mapName, getMethodName, setMethodName, defaultValue) type Settings::getMethodName(const std::string& name) \
+void Settings::updateSnapshot()
+{
+	if (mBatchUpdate)
+		return;
+
+	if (mUpdateDepth > 0)
+	{
+		mPendingUpdate.store(true, std::memory_order_release);
+		return;
+	}
+
+	publishSnapshot();
+}
+
+void Settings::publishSnapshot()
+{
+	mPendingUpdate.store(false, std::memory_order_release);
+
+	std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+	snapshot->generation = mGeneration + 1;
+
+	for (auto& it : mBoolMap) getKeyId(it.first);
+	for (auto& it : mIntMap) getKeyId(it.first);
+	for (auto& it : mFloatMap) getKeyId(it.first);
+	for (auto& it : mStringMap) getKeyId(it.first);
+
+	{
+		std::unique_lock<std::mutex> lock(sKeysLock);
+		snapshot->ids = sKeyIds;
+	}
+
+	snapshot->values.resize(snapshot->ids.size());
+
+	for (auto& it : mBoolMap) snapshot->values[snapshot->ids[it.first]].boolValue = it.second;
+	for (auto& it : mIntMap) snapshot->values[snapshot->ids[it.first]].intValue = it.second;
+	for (auto& it : mFloatMap) snapshot->values[snapshot->ids[it.first]].floatValue = it.second;
+	for (auto& it : mStringMap) snapshot->values[snapshot->ids[it.first]].stringValue = it.second;
+
+	std::atomic_store(&mSnapshot, std::shared_ptr<const Snapshot>(snapshot));
+	mGeneration.store(snapshot->generation, std::memory_order_release);
+}
+
+void Settings::publishPendingUpdate()
+{
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+
+	if (mPendingUpdate.load(std::memory_order_acquire))
+		publishSnapshot();
+}
+
+void Settings::beginUpdate()
+{
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+	mUpdateDepth++;
+}
+
+void Settings::endUpdate()
+{
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+
+	if (mUpdateDepth > 0)
+		mUpdateDepth--;
+
+	if (mUpdateDepth == 0 && mPendingUpdate.load(std::memory_order_acquire))
+		publishSnapshot();
+}
+
+std::map<std::string, std::string> Settings::getStringMap()
+{
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+	return mStringMap;
+}
+
+// Settings never set ( or keys registered after the snapshot was taken ) read as the default value
+#define SETTINGS_GET(type, field, getMethodName) type Settings::getMethodName(const std::string& name) \
 { \
-	if(mapName.find(name) == mapName.cend()) \
-	{ \
-		/* LOG(LogError) << "Tried to use unset setting " << name << "!"; */ \
-		return defaultValue; \
-	} \
-	return mapName[name]; \
+	const Snapshot* snapshot = getSnapshot(); \
+	if (snapshot == nullptr) \
+		return Value().field; \
+	auto it = snapshot->ids.find(name); \
+	if (it == snapshot->ids.cend()) \
+		return Value().field; \
+	return snapshot->values[it->second].field; \
 } \
-bool Settings::setMethodName(const std::string& name, type value) \
+type Settings::getMethodName(const Key& key) \
+{ \
+	const Snapshot* snapshot = getSnapshot(); \
+	if (snapshot == nullptr || key.id() < 0 || key.id() >= (int)snapshot->values.size()) \
+		return Value().field; \
+	return snapshot->values[key.id()].field; \
+}
+
+SETTINGS_GET(bool, boolValue, getBool);
+SETTINGS_GET(int, intValue, getInt);
+SETTINGS_GET(float, floatValue, getFloat);
+SETTINGS_GET(std::string, stringValue, getString);
+
+#define SETTINGS_SET(type, mapName, setMethodName) bool Settings::setMethodName(const std::string& name, type value) \
 { \
+	std::unique_lock<std::recursive_mutex> lock(mLock); \
 	if (mapName.count(name) == 0 || mapName[name] != value) { \
 		mapName[name] = value; \
 \
 		if (std::find(settings_dont_save.cbegin(), settings_dont_save.cend(), name) == settings_dont_save.cend()) \
 			mWasChanged = true; \
 \
+		updateSnapshot(); \
 		return true; \
 	} \
 	return false; \
 }
 
-SETTINGS_GETSET(bool, mBoolMap, getBool, setBool, false);
-SETTINGS_GETSET(int, mIntMap, getInt, setInt, 0);
-SETTINGS_GETSET(float, mFloatMap, getFloat, setFloat, 0.0f);
-//SETTINGS_GETSET(const std::string&, mStringMap, getString, setString, mEmptyString);
-
-std::string Settings::getString(const std::string& name)
-{ 
-	if (mStringMap.find(name) == mStringMap.cend())
-		return mEmptyString;
-
-	return mStringMap[name];
-}
+SETTINGS_SET(bool, mBoolMap, setBool);
+SETTINGS_SET(int, mIntMap, setInt);
+SETTINGS_SET(float, mFloatMap, setFloat);
 
 bool Settings::setString(const std::string& name, const std::string& value)
 { 
+	std::unique_lock<std::recursive_mutex> lock(mLock);
+
 	if (mStringMap.count(name) == 0 || mStringMap[name] != value)
 	{
 		if (value == "" && mStringMap.count(name) == 0)
@@ -412,9 +549,10 @@ bool Settings::setString(const std::string& name, const std::string& value)
 		
 		if (std::find(settings_dont_save.cbegin(), settings_dont_save.cend(), name) == settings_dont_save.cend()) 
 			mWasChanged = true; 
-			
+
+		updateSnapshot();
 		return true; 
 	} 
 
 	return false; 
-}
\ No newline at end of file
+}
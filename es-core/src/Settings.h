@@ -2,12 +2,33 @@
 #ifndef ES_CORE_SETTINGS_H
 #define ES_CORE_SETTINGS_H
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 //This is a singleton for storing settings.
+//Reads go to an immutable snapshot of every value, replaced when a setting changes : they are safe from any thread
+//and don't lock. Writes are serialized.
 class Settings
 {
 public:
+	// Setting name resolved once, for the settings read in loops. Can be declared static
+	class Key
+	{
+	public:
+		Key() : mId(-1) { }
+		explicit Key(const std::string& name) : mId(Settings::getKeyId(name)) { }
+
+		int id() const { return mId; }
+
+	private:
+		int mId;
+	};
+
 	static Settings* getInstance();
 
 	void loadFile();
@@ -19,14 +40,44 @@ public:
 	float getFloat(const std::string& name);
 	std::string getString(const std::string& name);
 
+	bool getBool(const Key& key);
+	int getInt(const Key& key);
+	float getFloat(const Key& key);
+	std::string getString(const Key& key);
+
 	bool setBool(const std::string& name, bool value);
 	bool setInt(const std::string& name, int value);
 	bool setFloat(const std::string& name, float value);
 	bool setString(const std::string& name, const std::string& value);
 
-	std::map<std::string, std::string>& getStringMap() { return mStringMap; }
+	std::map<std::string, std::string> getStringMap();
+
+	// Incremented each time a setting changes, for the caches built from settings
+	unsigned int getGeneration() { return mGeneration; }
+
+	// The settings changed between beginUpdate & endUpdate are published as one snapshot, with one generation.
+	// A read in between still sees them : the pending changes are published first
+	void beginUpdate();
+	void endUpdate();
 
 private:
+	struct Value
+	{
+		Value() : boolValue(false), intValue(0), floatValue(0.0f) { }
+
+		bool		boolValue;
+		int			intValue;
+		float		floatValue;
+		std::string	stringValue;
+	};
+
+	struct Snapshot
+	{
+		unsigned int generation;
+		std::unordered_map<std::string, int> ids;
+		std::vector<Value> values; // by key id
+	};
+
 	static Settings* sInstance;
 
 	Settings();
@@ -34,6 +85,25 @@ private:
 	//Clear everything and load default values.
 	void setDefaults();
 
+	static int getKeyId(const std::string& name);
+
+	// Valid until the next call on the same thread
+	const Snapshot* getSnapshot();
+	void updateSnapshot(); // mLock must be locked
+	void publishSnapshot(); // mLock must be locked
+	void publishPendingUpdate();
+
+	std::recursive_mutex mLock;
+	bool mBatchUpdate;
+	int mUpdateDepth;
+	std::atomic<bool> mPendingUpdate;
+
+	std::shared_ptr<const Snapshot> mSnapshot; // std::atomic_load / atomic_store
+	std::atomic<unsigned int> mGeneration;
+
+	static std::mutex sKeysLock;
+	static std::unordered_map<std::string, int> sKeyIds;
+
 	std::map<std::string, bool> mBoolMap;
 	std::map<std::string, int> mIntMap;
 	std::map<std::string, float> mFloatMap;
@@ -11,6 +11,8 @@
 #include "Settings.h"
 #include "SystemConf.h"
 #include <algorithm>
+#include <mutex>
+#include <set>
 #include "LocaleES.h"
 
 std::vector<std::string> ThemeData::sSupportedViews { { "system" }, { "basic" }, { "detailed" }, { "grid" }, { "video" }, { "menu" }, { "screen" }, { "splash" } };
@@ -310,6 +312,66 @@ ThemeData* ThemeData::mDefaultTheme = nullptr;
 #define MINIMUM_THEME_FORMAT_VERSION 3
 #define CURRENT_THEME_FORMAT_VERSION 6
 
+// Parsed theme files, shared by the ThemeData of every system : most systems load the same main file & includes.
+// The documents are read concurrently by the systems loading their theme, they must never be modified ( no renamed
+// node, no added attribute ). Variables, subsets & filters are applied by each ThemeData.
+namespace
+{
+	struct CachedDocument
+	{
+		std::shared_ptr<pugi::xml_document> doc;
+		time_t time;
+	};
+
+	std::mutex sDocumentCacheLock;
+	std::map<std::string, CachedDocument> sDocumentCache;
+	std::string sDocumentCacheThemeSet;
+
+	// Systems load their themes on the ThreadPool : the parse is done outside of the lock
+	std::shared_ptr<pugi::xml_document> loadDocument(const std::string& path, pugi::xml_parse_result& result)
+	{
+		time_t time = Utils::FileSystem::getFileModificationDate(path).getTime();
+		std::string themeSet = Settings::getInstance()->getString("ThemeSet");
+
+		{
+			std::unique_lock<std::mutex> lock(sDocumentCacheLock);
+
+			// Only the files of the theme set in use are kept : the ones of the previous set are not read anymore
+			if (sDocumentCacheThemeSet != themeSet)
+			{
+				sDocumentCache.clear();
+				sDocumentCacheThemeSet = themeSet;
+			}
+
+			auto it = sDocumentCache.find(path);
+			if (it != sDocumentCache.cend() && it->second.time == time)
+			{
+				result.status = pugi::status_ok;
+				return it->second.doc;
+			}
+		}
+
+		std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+		result = doc->load_file(path.c_str());
+		if (!result)
+			return nullptr;
+
+		std::unique_lock<std::mutex> lock(sDocumentCacheLock);
+
+		CachedDocument& cached = sDocumentCache[path];
+		cached.doc = doc;
+		cached.time = time;
+
+		return doc;
+	}
+}
+
+void ThemeData::clearDocumentCache()
+{
+	std::unique_lock<std::mutex> lock(sDocumentCacheLock);
+	sDocumentCache.clear();
+}
+
 // helper
 unsigned int getHexColor(const char* str)
 {
@@ -340,6 +402,71 @@ unsigned int getHexColor(const char* str)
 	return val;
 }
 
+// Every property name of sElementMap, sorted : the index is the property id.
+// Built once, then only read : no lock needed when themes are loaded on the ThreadPool
+const ThemeData::ThemeElement::PropertyNames& ThemeData::ThemeElement::getPropertyNames()
+{
+	static const PropertyNames names = []()
+	{
+		std::set<std::string> sorted;
+		for (auto& elementType : sElementMap)
+			for (auto& property : elementType.second)
+				sorted.insert(property.first);
+
+		PropertyNames ret;
+		for (auto& name : sorted)
+		{
+			ret.ids[name] = (int)ret.names.size();
+			ret.names.push_back(name);
+		}
+
+		return ret;
+	}();
+
+	return names;
+}
+
+int ThemeData::ThemeElement::getPropertyId(const std::string& name)
+{
+	const PropertyNames& table = getPropertyNames();
+
+	auto it = table.ids.find(name);
+	return it == table.ids.cend() ? -1 : it->second;
+}
+
+void ThemeData::ThemeElement::throwMissingProperty(int id)
+{
+	const PropertyNames& table = getPropertyNames();
+	throw std::out_of_range("Theme element has no property \"" + (id >= 0 && id < (int)table.names.size() ? table.names[id] : std::to_string(id)) + "\"");
+}
+
+std::map<std::string, ThemeData::ThemeElement::Property> ThemeData::ThemeElement::getProperties() const
+{
+	const PropertyNames& table = getPropertyNames();
+
+	std::map<std::string, Property> ret(mNamedProperties.cbegin(), mNamedProperties.cend());
+	for (auto& it : mProperties)
+		ret[table.names[it.first]] = it.second;
+
+	return ret;
+}
+
+ThemeData::ThemeElement::Property& ThemeData::ThemeElement::set(const std::string& prop)
+{
+	int id = getPropertyId(prop);
+	if (id < 0)
+		return mNamedProperties[prop];
+
+	auto it = mProperties.begin();
+	while (it != mProperties.end() && it->first < id)
+		it++;
+
+	if (it != mProperties.end() && it->first == id)
+		return it->second;
+
+	return mProperties.insert(it, std::make_pair(id, Property()))->second;
+}
+
 std::string ThemeData::resolvePlaceholders(const char* in)
 {
 	if (in == nullptr || in[0] == 0)
@@ -409,12 +536,12 @@ void ThemeData::loadFile(const std::string system, std::map<std::string, std::st
 	mVariables.insert(sysDataMap.cbegin(), sysDataMap.cend());
 	mVariables["lang"] = mLanguage;
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result res = doc.load_file(path.c_str());
+	pugi::xml_parse_result res;
+	std::shared_ptr<pugi::xml_document> doc = loadDocument(path, res);
 	if(!res)
 		throw error << "XML parsing error: \n    " << res.description();
 
-	pugi::xml_node root = doc.child("theme");
+	pugi::xml_node root = doc->child("theme");
 	if(!root)
 		throw error << "Missing <theme> tag!";
 
@@ -463,25 +590,23 @@ std::string ThemeData::resolveSystemVariable(const std::string& systemThemeFolde
 	return result;
 }
 
-bool ThemeData::isFirstSubset(const pugi::xml_node& node)
+bool ThemeData::isFirstSubset(const std::string& subset, const std::string& name)
 {
-	const std::string subsetToFind = resolvePlaceholders(node.attribute("subset").as_string());
-	const std::string name = node.attribute("name").as_string();
-
 	for (const auto& it : mSubsets)
-		if (it.subset == subsetToFind)
+		if (it.subset == subset)
 			return it.name == name;
 
 	return false;
 }
 
-bool ThemeData::parseSubset(const pugi::xml_node& node)
+bool ThemeData::parseSubset(const pugi::xml_node& node, const std::string& subset, const std::string& appliesTo, const std::string& subSetDisplayName)
 {
-	if (!node.attribute("subset"))
+	if (subset.empty() && !node.attribute("subset"))
 		return true;
 
-	const std::string subsetAttr = resolvePlaceholders(node.attribute("subset").as_string());
+	const std::string subsetAttr = resolvePlaceholders(subset.empty() ? node.attribute("subset").as_string() : subset.c_str());
 	const std::string nameAttr = resolvePlaceholders(node.attribute("name").as_string());
+	const std::string rawNameAttr = node.attribute("name").as_string();
 
 	if (!subsetAttr.empty())
 	{
@@ -489,7 +614,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 		if (displayNameAttr.empty())
 			displayNameAttr = nameAttr;
 
-		std::string subSetDisplayNameAttr = resolvePlaceholders(node.attribute("subSetDisplayName").as_string());
+		std::string subSetDisplayNameAttr = resolvePlaceholders(subSetDisplayName.empty() ? node.attribute("subSetDisplayName").as_string() : subSetDisplayName.c_str());
 		if (subSetDisplayNameAttr.empty())
 		{
 			std::string byVarName = getVariable("subset." + subsetAttr);
@@ -509,7 +634,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 		{
 			Subset subSet(subsetAttr, nameAttr, displayNameAttr, subSetDisplayNameAttr);
 
-			std::string appliesToAttr = resolvePlaceholders(node.attribute("appliesTo").as_string());
+			std::string appliesToAttr = resolvePlaceholders(appliesTo.empty() ? node.attribute("appliesTo").as_string() : appliesTo.c_str());
 			if (!appliesToAttr.empty())
 				subSet.appliesTo = Utils::String::splitAny(appliesToAttr, ",");
 
@@ -526,7 +651,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 			if (nameAttr == perSystemSetName)
 				return true;
 		}
-		else if (nameAttr == mColorset || (mColorset.empty() && isFirstSubset(node)))
+		else if (nameAttr == mColorset || (mColorset.empty() && isFirstSubset(subsetAttr, rawNameAttr)))
 			return true;
 	}
 	else if (subsetAttr == "iconset")
@@ -537,17 +662,17 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 			if (nameAttr == perSystemSetName)
 				return true;
 		}
-		else if (nameAttr == mIconset || (mIconset.empty() && isFirstSubset(node)))
+		else if (nameAttr == mIconset || (mIconset.empty() && isFirstSubset(subsetAttr, rawNameAttr)))
 			return true;
 	}
 	else if (subsetAttr == "menu")
 	{
-		if (nameAttr == mMenu || (mMenu.empty() && isFirstSubset(node)))
+		if (nameAttr == mMenu || (mMenu.empty() && isFirstSubset(subsetAttr, rawNameAttr)))
 			return true;
 	}
 	else if (subsetAttr == "systemview")
 	{
-		if (nameAttr == mSystemview || (mSystemview.empty() && isFirstSubset(node)))
+		if (nameAttr == mSystemview || (mSystemview.empty() && isFirstSubset(subsetAttr, rawNameAttr)))
 			return true;
 	}
 	else if (subsetAttr == "gamelistview")
@@ -558,7 +683,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 			if (nameAttr == perSystemSetName)
 				return true;
 		}
-		else if (nameAttr == mGamelistview || (mGamelistview.empty() && isFirstSubset(node)))
+		else if (nameAttr == mGamelistview || (mGamelistview.empty() && isFirstSubset(subsetAttr, rawNameAttr)))
 			return true;
 	}
 	else
@@ -572,7 +697,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 		else
 		{
 			std::string setID = Settings::getInstance()->getString("subset." + subsetAttr);
-			if (nameAttr == setID || (setID.empty() && isFirstSubset(node)))
+			if (nameAttr == setID || (setID.empty() && isFirstSubset(subsetAttr, rawNameAttr)))
 				return true;
 		}
 	}
@@ -582,12 +707,12 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 
 
 
-void ThemeData::parseInclude(const pugi::xml_node& node)
+void ThemeData::parseInclude(const pugi::xml_node& node, const std::string& subset, const std::string& appliesTo, const std::string& subSetDisplayName)
 {
 	if (!parseFilterAttributes(node))
 		return;
 
-	if (!parseSubset(node))
+	if (!parseSubset(node, subset, appliesTo, subSetDisplayName))
 		return;
 
 	std::string relPath = resolvePlaceholders(node.text().as_string());
@@ -602,15 +727,15 @@ void ThemeData::parseInclude(const pugi::xml_node& node)
 
 	mPaths.push_back(path);
 
-	pugi::xml_document includeDoc;
-	pugi::xml_parse_result result = includeDoc.load_file(path.c_str());
+	pugi::xml_parse_result result;
+	std::shared_ptr<pugi::xml_document> includeDoc = loadDocument(path, result);
 	if (!result)
 	{
 		LOG(LogWarning) << "Error parsing file: \n    " << result.description() << "    from included file \"" << relPath << "\":\n    ";
 		return;
 	}
 
-	pugi::xml_node theme = includeDoc.child("theme");
+	pugi::xml_node theme = includeDoc->child("theme");
 	if (!theme)
 	{
 		LOG(LogWarning) << "Missing <theme> tag!" << "    from included file \"" << relPath << "\":\n    ";
@@ -792,24 +917,7 @@ void ThemeData::parseSubsetElement(const pugi::xml_node& root)
 	const std::string appliesTo = root.attribute("appliesTo").as_string();
 
 	for (pugi::xml_node node = root.child("include"); node; node = node.next_sibling("include"))
-	{
-		node.remove_attribute("subset");
-		node.append_attribute("subset") = name.c_str();
-
-		if (!appliesTo.empty())
-		{
-			node.remove_attribute("appliesTo");
-			node.append_attribute("appliesTo") = appliesTo.c_str();
-		}
-
-		if (!displayName.empty())
-		{
-			node.remove_attribute("subSetDisplayName");
-			node.append_attribute("subSetDisplayName") = displayName.c_str();
-		}
-
-		parseInclude(node);
-	}
+		parseInclude(node, name, appliesTo, displayName);
 }
 
 void ThemeData::parseViews(const pugi::xml_node& root)
@@ -1024,24 +1132,27 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 
 		ElementPropertyType type = STRING;
 
-		auto typeIt = typeMap.find(node.name());
+		// Parsed documents are shared between systems : aliases are resolved here, the node is never renamed
+		std::string name = node.name();
+
+		auto typeIt = typeMap.find(name);
 		if(typeIt == typeMap.cend())
 		{
 			// Exception for menuIcons that can be extended
 			if (element.type == "menuIcons")
 				type = PATH;
-			else if (std::string(node.name()) == "animate" && std::string(root.name()) == "imagegrid")
-				node.set_name("animateSelection");
+			else if (name == "animate" && std::string(root.name()) == "imagegrid")
+				name = "animateSelection";
 			else
 			{
-				LOG(LogWarning) << "Unknown property type \"" << node.name() << "\" (for element of type " << root.name() << ").";
+				LOG(LogWarning) << "Unknown property type \"" << name << "\" (for element of type " << root.name() << ").";
 				continue;
 			}
 		}
 		else
 			type = typeIt->second;
 		
-		if (!overwrite && element.properties.find(node.name()) != element.properties.cend())
+		if (!overwrite && element.has(name))
 			continue;
 
 		std::string str = resolveSystemVariable(mSystemThemeFolder, resolvePlaceholders(node.text().as_string()));
@@ -1064,7 +1175,7 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 					(float)atof(splits.at(2).c_str()), (float)atof(splits.at(3).c_str()));
 			}
 
-			element.properties[node.name()] = val;
+			element.set(name) = val;
 			break;
 		}
 		case NORMALIZED_PAIR:
@@ -1074,22 +1185,22 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 			{			
 				if (str.empty())
 				{
-					LOG(LogWarning) << "invalid normalized pair (property \"" << node.name() << "\", value \"" << str.c_str() << "\")";
+					LOG(LogWarning) << "invalid normalized pair (property \"" << name << "\", value \"" << str.c_str() << "\")";
 					break;
 				}
 
 				Vector2f val((float)atof(str.c_str()), (float)atof(str.c_str()));
-				element.properties[node.name()] = val;
+				element.set(name) = val;
 				break;
 			}			
 
 			float first = atof(str.substr(0, divider).c_str());
 			float second = atof(str.substr(divider, std::string::npos).c_str());
-			element.properties[node.name()] = Vector2f(first, second);
+			element.set(name) = Vector2f(first, second);
 			break;
 		}
 		case STRING:
-			element.properties[node.name()] = str;
+			element.set(name) = str;
 			break;
 		case PATH:
 		{
@@ -1110,7 +1221,7 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 				else if (element.type == "image" && path != "{random}" && path != "{random:thumbnail}" && path != "{random:marquee}" && path != "{random:image}")
 					LOG(LogWarning) << "unknow random element " << path;
 				else
-					element.properties[node.name()] = path;
+					element.set(name) = path;
 
 				break;
 			}
@@ -1144,16 +1255,16 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 				LOG(LogWarning) << ss.str();
 			}
 			else
-				element.properties[node.name()] = path;
+				element.set(name) = path;
 
 			break;
 		}
 		case COLOR:
-			element.properties[node.name()] = getHexColor(str.c_str());
+			element.set(name) = getHexColor(str.c_str());
 			break;
 		case FLOAT:
 		{
-			element.properties[node.name()] = (float) atof(str.c_str());
+			element.set(name) = (float) atof(str.c_str());
 			break;
 		}
 
@@ -1164,11 +1275,11 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 			// 1*, t* (true), T* (True), y* (yes), Y* (YES)
 			bool boolVal = (first == '1' || first == 't' || first == 'T' || first == 'y' || first == 'Y');
 
-			element.properties[node.name()] = boolVal;
+			element.set(name) = boolVal;
 			break;
 		}
 		default:
-			LOG(LogWarning) << "Unknown ElementPropertyType for \"" << root.attribute("name").as_string() << "\", property " << node.name();
+			LOG(LogWarning) << "Unknown ElementPropertyType for \"" << root.attribute("name").as_string() << "\", property " << name;
 			break;
 		}
 	}
@@ -1517,9 +1628,11 @@ ThemeData::ThemeMenu::ThemeMenu(ThemeData* theme)
 	elem = theme->getElement("menu", "menuicons", "menuIcons");
 	if (elem)
 	{
-		for (auto prop : elem->properties)
+		for (auto prop : elem->getProperties())
 		{
-			std::string path = prop.second.s;
+			std::string path;
+			prop.second.read(path);
+
 			if (!path.empty() && ResourceManager::getInstance()->fileExists(path))
 				mMenuIcons[prop.first] = path;
 		}
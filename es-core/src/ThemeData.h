@@ -10,6 +10,7 @@
 #include <unordered_map>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 #include <pugixml/src/pugixml.hpp>
 
@@ -191,38 +192,108 @@ public:
 
 		std::string type;
 
+		// Tagged value : reading a property with another type than the one it was parsed with returns a default value
 		struct Property
 		{
-			void operator= (const Vector2f& value)     { v = value; }
-			void operator= (const std::string& value)  { s = value; }
-			void operator= (const unsigned int& value) { i = value; }
-			void operator= (const float& value)        { f = value; }
-			void operator= (const bool& value)         { b = value; }
-			void operator= (const Vector4f& value)     { r = value; v = Vector2f(value.x(), value.y()); }
-
-			Vector2f     v;
-			std::string  s;
-			unsigned int i;
-			float        f;
-			bool         b;
+			enum Type : unsigned char { PAIR, RECT, STRING, COLOR, FLOAT, BOOLEAN };
+
+			Property() : type(STRING), i(0) { }
+
+			void operator= (const Vector2f& value)     { type = PAIR; r = Vector4f(value.x(), value.y(), 0, 0); }
+			void operator= (const std::string& value)  { type = STRING; s = value; }
+			void operator= (const unsigned int& value) { type = COLOR; i = value; }
+			void operator= (const float& value)        { type = FLOAT; f = value; }
+			void operator= (const bool& value)         { type = BOOLEAN; b = value; }
+			void operator= (const Vector4f& value)     { type = RECT; r = value; }
+
+			void read(Vector2f& value) const     { if (type == PAIR || type == RECT) value = Vector2f(r.x(), r.y()); }
+			void read(std::string& value) const  { if (type == STRING) value = s; }
+			void read(unsigned int& value) const { if (type == COLOR) value = i; }
+			void read(float& value) const        { if (type == FLOAT) value = f; }
+			void read(bool& value) const         { if (type == BOOLEAN) value = b; }
+			void read(Vector4f& value) const     { if (type == RECT) value = r; }
+
+			Type type;
+			union
+			{
+				unsigned int i;
+				float        f;
+				bool         b;
+			};
 			Vector4f     r;
+			std::string  s;
 		};
 
-		std::map< std::string, Property > properties;
+		// Property names of sElementMap have a fixed id ( sorted by name ), resolve them once with getPropertyId in hot paths.
+		// Other names ( menuIcons ) return -1 and are stored by name.
+		static int getPropertyId(const std::string& name);
+
+		// Name & value of every property : only for elements having free property names
+		std::map<std::string, Property> getProperties() const;
+
+		// Throw std::out_of_range when the element doesn't have the property : check has() first.
+		// A property read with another type than the one it was parsed with returns a default value
+		template<typename T>
+		const T get(int id) const
+		{
+			const Property* prop = find(id);
+			if (prop == nullptr)
+				throwMissingProperty(id);
+
+			T value = T();
+			prop->read(value);
+			return value;
+		}
 
 		template<typename T>
 		const T get(const std::string& prop) const
 		{
-			if(     std::is_same<T, Vector2f>::value)     return *(const T*)&properties.at(prop).v;
-			else if(std::is_same<T, std::string>::value)  return *(const T*)&properties.at(prop).s;
-			else if(std::is_same<T, unsigned int>::value) return *(const T*)&properties.at(prop).i;
-			else if(std::is_same<T, float>::value)        return *(const T*)&properties.at(prop).f;
-			else if(std::is_same<T, bool>::value)         return *(const T*)&properties.at(prop).b;
-			else if (std::is_same<T, Vector4f>::value)         return *(const T*)&properties.at(prop).r;
-			return T();
+			int id = getPropertyId(prop);
+			if (id >= 0)
+				return get<T>(id);
+
+			T value = T();
+			mNamedProperties.at(prop).read(value);
+			return value;
+		}
+
+		inline bool has(int id) const { return find(id) != nullptr; }
+
+		inline bool has(const std::string& prop) const
+		{
+			int id = getPropertyId(prop);
+			return id >= 0 ? has(id) : mNamedProperties.find(prop) != mNamedProperties.cend();
 		}
 
-		inline bool has(const std::string& prop) const { return (properties.find(prop) != properties.cend()); }
+		Property& set(const std::string& prop);
+
+	private:
+		struct PropertyNames
+		{
+			std::vector<std::string> names;
+			std::unordered_map<std::string, int> ids;
+		};
+
+		static const PropertyNames& getPropertyNames();
+		[[noreturn]] static void throwMissingProperty(int id);
+
+		const Property* find(int id) const
+		{
+			for (auto& it : mProperties)
+			{
+				if (it.first == id)
+					return &it.second;
+
+				if (it.first > id)
+					break;
+			}
+
+			return nullptr;
+		}
+
+		// Sorted by id, an element has a few properties : a linear search is the fastest
+		std::vector<std::pair<int, Property>> mProperties;
+		std::map<std::string, Property> mNamedProperties;
 	};
 
 private:
@@ -275,6 +346,9 @@ public:
 	static const std::shared_ptr<ThemeData>& getDefault();
 
 	static std::map<std::string, ThemeSet> getThemeSets();
+
+	// Frees the parsed theme files shared by the systems. They're also dropped when the "ThemeSet" setting changes
+	static void clearDocumentCache();
 	static std::string getThemeFromCurrentSet(const std::string& system);
 	
 	bool hasSubsets() { return mSubsets.size() > 0; }
@@ -317,7 +391,8 @@ private:
 	void parseTheme(const pugi::xml_node& root);
 
 	void parseFeature(const pugi::xml_node& node);	
-	void parseInclude(const pugi::xml_node& node);	
+	// subset, appliesTo & subSetDisplayName come from a parent <subset> element. Parsed documents are shared, never modify them
+	void parseInclude(const pugi::xml_node& node, const std::string& subset = "", const std::string& appliesTo = "", const std::string& subSetDisplayName = "");
 	void parseVariable(const pugi::xml_node& node);
 	void parseVariables(const pugi::xml_node& root);
 	void parseViews(const pugi::xml_node& themeRoot);
@@ -326,8 +401,8 @@ private:
 	void parseView(const pugi::xml_node& viewNode, ThemeView& view, bool overwriteElements = true);
 	void parseElement(const pugi::xml_node& elementNode, const std::map<std::string, ElementPropertyType>& typeMap, ThemeElement& element, bool overwrite = true);
 	bool parseRegion(const pugi::xml_node& node);
-	bool parseSubset(const pugi::xml_node& node);
-	bool isFirstSubset(const pugi::xml_node& node);
+	bool parseSubset(const pugi::xml_node& node, const std::string& subset, const std::string& appliesTo, const std::string& subSetDisplayName);
+	bool isFirstSubset(const std::string& subset, const std::string& name);
 	bool parseLanguage(const pugi::xml_node& node);
 	bool parseFilterAttributes(const pugi::xml_node& node);
 	void parseSubsetElement(const pugi::xml_node& root);
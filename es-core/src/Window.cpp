@@ -7,7 +7,10 @@
 #include "resources/TextureResource.h"
 #include "InputManager.h"
 #include "Log.h"
+#include "Profiler.h"
 #include "Scripting.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/TimeUtil.h"
 #include <algorithm>
 #include <iomanip>
 #include "guis/GuiInfoPopup.h"
@@ -23,13 +26,24 @@
 #include "guis/GuiMsgBox.h"
 #include "components/VolumeInfoComponent.h"
 #include "Splash.h"
+#include "PowerSaver.h"
 
-Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
+#define IDLE_REFRESH_MS 1000 // idle frames are still rendered once per second
+
+std::atomic<bool> Window::sInvalidated(true);
+
+Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10), mUiThreadLoads(0), mMaxFrameUiThreadLoads(0),
   mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL), mClockElapsed(0) // batocera
 {	
 	mTransiting = nullptr;
 	mTransitionOffset = 0;
 
+	mWasInvalidated = true;
+	mLastRenderTime = 0;
+	mSkippedFrames = 0;
+	mInitTime = 0;
+	mInitFrameRendered = false;
+
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);
 	mBackgroundOverlay->setImage(":/scroll_gradient.png"); // batocera
@@ -147,6 +161,12 @@ bool Window::init(bool initRenderer)
 {
 	LOG(LogInfo) << "Window::init";
 
+	mInitTime = SDL_GetTicks();
+	mInitFrameRendered = false;
+
+	TextureData::setUiThread();
+	Profiler::setEnabled(Settings::getInstance()->getBool("Profiler"));
+
 	if (initRenderer)
 	{
 		if (!Renderer::init())
@@ -296,6 +316,21 @@ void Window::input(InputConfig* config, Input input)
 		// toggle TextComponent debug view with Ctrl-I
 		Settings::getInstance()->setBool("DebugImage", !Settings::getInstance()->getBool("DebugImage"));
 	}
+	else if (config->getDeviceId() == DEVICE_KEYBOARD && input.value && input.id == SDLK_p && SDL_GetModState() & KMOD_LCTRL)
+	{
+		// start recording timing zones with Ctrl-P, save the trace on the next Ctrl-P
+		if (!Profiler::isEnabled())
+		{
+			Profiler::setEnabled(true);
+			displayNotificationMessage("Profiler started");
+		}
+		else
+		{
+			std::string path = Utils::FileSystem::getEsConfigPath() + "/profile-" + Utils::Time::timeToString(time(NULL), "%Y%m%d-%H%M%S") + ".json";
+			if (Profiler::dump(path))
+				displayNotificationMessage("Trace saved to " + path);
+		}
+	}
 	else
 	{
 		if (mControllerActivity != nullptr)
@@ -370,6 +405,8 @@ void Window::processSongTitleNotifications()
 
 void Window::update(int deltaTime)
 {
+	PROFILE_ZONE("Window::update");
+
 	processPostedFunctions();
 	processSongTitleNotifications();
 	processNotificationMessages();
@@ -384,6 +421,17 @@ void Window::update(int deltaTime)
 	if (mVolumeInfo)
 		mVolumeInfo->update(deltaTime);
 
+	// Textures decoded by the UI thread during the previous frame
+	int uiThreadLoads = TextureData::getUiThreadLoads(true);
+	if (uiThreadLoads > 0)
+	{
+		LOG(LogDebug) << "Window::update : " << uiThreadLoads << " texture(s) loaded synchronously by the UI thread";
+
+		mUiThreadLoads += uiThreadLoads;
+		if (uiThreadLoads > mMaxFrameUiThreadLoads)
+			mMaxFrameUiThreadLoads = uiThreadLoads;
+	}
+
 	mFrameTimeElapsed += deltaTime;
 	mFrameCountElapsed++;
 	if (mFrameTimeElapsed > 500)
@@ -405,11 +453,33 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				" Tex Max: " << textureTotalUsageMb;
+
+			// sync loads
+			ss << "\nUI thread loads: " << mUiThreadLoads << " (max " << mMaxFrameUiThreadLoads << "/frame)";
+
+			// idle frames, since the start
+			ss << "\nSkipped frames: " << mSkippedFrames;
+
+			// batching, from the last complete frame
+			const Renderer::Stats& stats = Renderer::getStats();
+			ss << "\nDraw calls: " << stats.drawCalls << " (" << stats.submits << " submitted) Vertices: " << stats.vertices << " Binds: " << stats.textureBinds;
+
+			// frame times over the last frames, and the heaviest zones since the last refresh
+			float p50, p95, p99;
+			Profiler::getFramePercentiles(p50, p95, p99);
+			ss << std::fixed << std::setprecision(1) << "\nFrame p50/p95/p99: " << p50 << " / " << p95 << " / " << p99 << " ms";
+
+			if (Profiler::isEnabled())
+				for (auto zone : Profiler::getTopZones(5))
+					ss << "\n  " << zone.name << " : " << std::setprecision(2) << (zone.duration / 1000.0f / mFrameCountElapsed) << " ms/frame (" << zone.count << ")";
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
+			invalidate();
 		}
 
 		mFrameTimeElapsed = 0;
 		mFrameCountElapsed = 0;
+		mUiThreadLoads = 0;
+		mMaxFrameUiThreadLoads = 0;
 	}
 
 	/* draw the clock */ // batocera
@@ -459,6 +529,12 @@ void Window::update(int deltaTime)
 
 void Window::render()
 {
+	// Frame times are taken between rendered frames only, skipped frames would show as very fast frames
+	Profiler::frame();
+	PROFILE_ZONE("Window::render");
+
+	mLastRenderTime = SDL_GetTicks();
+
 	Transform4x4f transform = Transform4x4f::Identity();
 
 	mRenderedHelpPrompts = false;
@@ -541,6 +617,21 @@ void Window::render()
 	if (mVolumeInfo && Settings::getInstance()->getBool("VolumePopup"))
 		mVolumeInfo->render(transform);
 
+	if (mInitTime != 0)
+	{
+		if (!mInitFrameRendered)
+		{
+			LOG(LogInfo) << "Window::render : first frame after " << (mLastRenderTime - mInitTime) << " ms (resume cache " << (TextureData::getResumeCacheSize() / 1024 / 1024) << " MB)";
+			mInitFrameRendered = true;
+		}
+
+		if (TextureResource::getQueueSize() == 0)
+		{
+			LOG(LogInfo) << "Window::render : textures loaded after " << (mLastRenderTime - mInitTime) << " ms";
+			mInitTime = 0;
+		}
+	}
+
 	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
 	{
 		if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
@@ -791,10 +882,32 @@ void Window::processPostedFunctions()
 {
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
 
+	if (mFunctions.empty())
+		return;
+
 	for (auto func : mFunctions)
 		func(this);	
 
 	mFunctions.clear();
+	invalidate();
+}
+
+void Window::skipFrame()
+{
+	mSkippedFrames++;
+	Profiler::skipFrame();
+}
+
+bool Window::needsRender(bool hadEvent)
+{
+	bool invalidated = sInvalidated.exchange(false) || hadEvent || PowerSaver::isActive() || mTransiting != nullptr ||
+		(mScreenSaver != nullptr && mScreenSaver->isScreenSaverActive()) ||
+		SDL_GetTicks() - mLastRenderTime >= IDLE_REFRESH_MS;
+
+	// Once things stop moving, one more frame shows where they ended
+	bool ret = invalidated || mWasInvalidated;
+	mWasInvalidated = invalidated;
+	return ret;
 }
 
 void Window::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
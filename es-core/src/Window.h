@@ -6,6 +6,7 @@
 #include "InputConfig.h"
 #include "Settings.h"
 #include "math/Vector2f.h"
+#include <atomic>
 #include <memory>
 #include <functional>
 
@@ -65,6 +66,12 @@ public:
 	void normalizeNextUpdate();
 
 	inline bool isSleeping() const { return mSleeping; }
+
+	// Idle frame skipping : anything changing the screen outside of input, animations and PowerSaver::pause calls invalidate()
+	static void invalidate() { sInvalidated = true; }
+	bool needsRender(bool hadEvent);
+	void skipFrame();
+	unsigned int getSkippedFrames() const { return mSkippedFrames; }
 	bool getAllowSleep();
 	void setAllowSleep(bool sleep);
 	
@@ -132,6 +139,8 @@ private:
 	int mFrameTimeElapsed;
 	int mFrameCountElapsed;
 	int mAverageDeltaTime;
+	int mUiThreadLoads;
+	int mMaxFrameUiThreadLoads;
 
 	std::unique_ptr<TextCache> mFrameDataText;
 
@@ -151,6 +160,15 @@ private:
 
 	GuiComponent* mTransiting;
 	int mTransitionOffset;
+
+	static std::atomic<bool> sInvalidated;
+	bool mWasInvalidated;
+	unsigned int mLastRenderTime;
+	unsigned int mSkippedFrames;
+
+	// Time to the first frame, then to the first frame with every queued texture loaded, after init
+	unsigned int mInitTime;
+	bool mInitFrameRendered;
 };
 
 #endif // ES_CORE_WINDOW_H
@@ -840,6 +840,15 @@ void GridTileComponent::setImage(const std::string& path, bool isDefaultImage)
 	resize();
 }
 
+void GridTileComponent::setLoadPriority(int priority)
+{
+	if (mImage != nullptr)
+		mImage->setLoadPriority(priority);
+
+	if (mMarquee != nullptr)
+		mMarquee->setLoadPriority(priority);
+}
+
 void GridTileComponent::setMarquee(const std::string& path)
 {
 	if (mMarquee == nullptr)
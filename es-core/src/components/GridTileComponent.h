@@ -210,6 +210,7 @@ public:
 
 	void setImage(const std::string& path, bool isDefaultImage = false);
 	void setMarquee(const std::string& path);
+	void setLoadPriority(int priority);
 	
 	void setFavorite(bool favorite);
 	bool hasFavoriteMedia() { return mFavorite != nullptr; }
@@ -7,6 +7,7 @@
 #include "resources/Font.h"
 #include "PowerSaver.h"
 #include "ThemeData.h"
+#include "Window.h"
 
 enum CursorState
 {
@@ -244,6 +245,7 @@ protected:
 		// update the title overlay opacity
 		const int dir = (mScrollTier >= mTierList.count - 1) ? 1 : -1; // fade in if scroll tier is >= 1, otherwise fade out
 		int op = mTitleOverlayOpacity + deltaTime*dir; // we just do a 1-to-1 time -> opacity, no scaling
+		unsigned char prevOpacity = mTitleOverlayOpacity;
 		if(op >= 255)
 			mTitleOverlayOpacity = 255;
 		else if(op <= 0)
@@ -251,6 +253,9 @@ protected:
 		else
 			mTitleOverlayOpacity = (unsigned char)op;
 
+		if(mTitleOverlayOpacity != prevOpacity)
+			Window::invalidate();
+
 		if(mScrollVelocity == 0 || size() < 2)
 			return;
 
@@ -4,6 +4,7 @@
 #include "Log.h"
 #include "Settings.h"
 #include "ThemeData.h"
+#include "Window.h"
 #include "LocaleES.h"
 #include "utils/FileSystemUtil.h"
 
@@ -153,6 +154,8 @@ void ImageComponent::setImage(std::string path, bool tile, MaxSizeInfo maxSize)
 	std::string canonicalPath = Utils::FileSystem::getCanonicalPath(path);
 	if (mPath == canonicalPath)
 		return;
+
+	Window::invalidate();
 	
 	mPath = canonicalPath;
 
@@ -184,6 +187,8 @@ void ImageComponent::setImage(std::string path, bool tile, MaxSizeInfo maxSize)
 
 void ImageComponent::setImage(const char* path, size_t length, bool tile)
 {
+	Window::invalidate();
+
 	mTexture.reset();
 
 	mTexture = TextureResource::get("", tile);
@@ -192,8 +197,15 @@ void ImageComponent::setImage(const char* path, size_t length, bool tile)
 	resize();
 }
 
+void ImageComponent::setLoadPriority(int priority)
+{
+	TextureResource::setLoadPriority(mLoadingTexture != nullptr ? mLoadingTexture : mTexture, priority);
+}
+
 void ImageComponent::setImage(const std::shared_ptr<TextureResource>& texture)
 {
+	Window::invalidate();
+
 	mTexture = texture;
 	resize();
 }
@@ -292,6 +304,9 @@ void ImageComponent::setFlipY(bool flip)
 
 void ImageComponent::setColorShift(unsigned int color)
 {
+	if (mColorShift != color || mColorShiftEnd != color)
+		Window::invalidate();
+
 	mColorShift = color;
 	mColorShiftEnd = color;
 	updateColors();
@@ -299,6 +314,9 @@ void ImageComponent::setColorShift(unsigned int color)
 
 void ImageComponent::setColorShiftEnd(unsigned int color)
 {
+	if (mColorShiftEnd != color)
+		Window::invalidate();
+
 	mColorShiftEnd = color;
 	updateColors();
 }
@@ -311,6 +329,9 @@ void ImageComponent::setColorGradientHorizontal(bool horizontal)
 
 void ImageComponent::setOpacity(unsigned char opacity)
 {
+	if (mOpacity != opacity)
+		Window::invalidate();
+
 	mOpacity = opacity;	
 	updateColors();
 }
@@ -393,6 +414,10 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 	if (mRotation == 0 && !Renderer::isVisibleOnScreen(trans.translation().x(), trans.translation().y(), mSize.x(), mSize.y()))
 		return;
 
+	// On screen : the image that replaces the current one loads first, even if the queue was cancelled
+	if (mLoadingTexture != nullptr)
+		mLoadingTexture->loadAsync();
+
 	Renderer::setMatrix(trans);
 
 	if(mTexture && mOpacity > 0)
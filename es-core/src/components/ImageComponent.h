@@ -36,6 +36,9 @@ public:
 	//Use an already existing texture.
 	void setImage(const std::shared_ptr<TextureResource>& texture);
 
+	// Where the image goes in the loading queue, if it's waiting there ( TEXTURE_PRIORITY_... )
+	void setLoadPriority(int priority);
+
 	void onSizeChanged() override;
 	void setOpacity(unsigned char opacity) override;
 
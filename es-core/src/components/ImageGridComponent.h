@@ -816,12 +816,17 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 	int i = 0;
 	int end = (int)mTiles.size();
 	int img = mStartPosition;
+	int dimOpposite = std::max(1, isVertical() ? mGridDimension.x() : mGridDimension.y());
 
-	img -= EXTRAITEMS * (isVertical() ? mGridDimension.x() : mGridDimension.y());
+	img -= EXTRAITEMS * dimOpposite;
 
 	while (i != end)
 	{
 		updateTileAtPos(i, img, allowAnimation, updateSelectedState);
+
+		// The images closest to the cursor load first, row by row
+		mTiles.at(i)->setLoadPriority(TEXTURE_PRIORITY_REQUESTED + abs(img - mCursor) / dimOpposite);
+
 		i++; img++;
 	}
 	
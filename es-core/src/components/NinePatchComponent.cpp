@@ -3,6 +3,7 @@
 #include "resources/TextureResource.h"
 #include "Log.h"
 #include "ThemeData.h"
+#include "Window.h"
 
 NinePatchComponent::NinePatchComponent(Window* window, const std::string& path, unsigned int edgeColor, unsigned int centerColor) : GuiComponent(window),
 	mCornerSize(16, 16),
@@ -22,6 +23,8 @@ void NinePatchComponent::setOpacity(unsigned char opacity)
 	if (mOpacity == opacity)
 		return;
 
+	Window::invalidate();
+
 	mOpacity = opacity;
 	updateColors();
 }
@@ -2,6 +2,7 @@
 
 #include "math/Vector2i.h"
 #include "renderers/Renderer.h"
+#include "Window.h"
 
 #define AUTO_SCROLL_RESET_DELAY 3000 // ms to reset to top after we reach the bottom
 #define AUTO_SCROLL_DELAY 3000 // ms to wait before we start to scroll
@@ -65,6 +66,8 @@ void ScrollableContainer::setScrollPos(const Vector2f& pos)
 
 void ScrollableContainer::update(int deltaTime)
 {
+	Vector2f prevScrollPos = mScrollPos;
+
 	if(mAutoScrollSpeed != 0)
 	{
 		mAutoScrollAccumulator += deltaTime;
@@ -107,6 +110,9 @@ void ScrollableContainer::update(int deltaTime)
 			reset();
 	}
 
+	if(mScrollPos != prevScrollPos)
+		Window::invalidate();
+
 	GuiComponent::update(deltaTime);
 }
 
@@ -3,6 +3,7 @@
 #include "utils/StringUtil.h"
 #include "Log.h"
 #include "Settings.h"
+#include "Window.h"
 
 TextComponent::TextComponent(Window* window) : GuiComponent(window), 
 	mFont(Font::get(FONT_SIZE_MEDIUM)), mUppercase(false), mColor(0x000000FF), mAutoCalcExtent(true, true),
@@ -71,6 +72,8 @@ void TextComponent::setColor(unsigned int color)
 	if (mColor == color)
 		return;
 
+	Window::invalidate();
+
 	mColor = color;
 	onColorChanged();
 }
@@ -92,6 +95,8 @@ void TextComponent::setOpacity(unsigned char opacity)
 	if (opacity == mOpacity)
 		return;
 
+	Window::invalidate();
+
 	mOpacity = opacity;
 	onColorChanged();
 }
@@ -101,6 +106,8 @@ void TextComponent::setText(const std::string& text)
 	if (mText == text)
 		return;
 
+	Window::invalidate();
+
 	mText = text;
 	mMarqueeOffset = 0;
 	mMarqueeOffset2 = 0;
@@ -359,6 +366,8 @@ void TextComponent::update(int deltaTime)
 	int sy = mSize.y() - mPadding.y() - mPadding.w();
 	const bool isMultiline = !mAutoScroll && (mSize.y() == 0 || sy > mFont->getHeight()*1.95f);
 
+	int prevMarqueeOffset = mMarqueeOffset;
+
 	if (mAutoScroll && !isMultiline && mSize.x() > 0)
 	{
 		// always reset the marquee offsets
@@ -399,6 +408,8 @@ void TextComponent::update(int deltaTime)
 		mMarqueeOffset = 0;
 		mMarqueeOffset2 = 0;
 	}
+	if (mMarqueeOffset != prevMarqueeOffset)
+		Window::invalidate();
 }
 
 void TextComponent::onColorChanged()
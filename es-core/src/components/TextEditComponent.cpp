@@ -203,10 +203,15 @@ bool TextEditComponent::input(InputConfig* config, Input input)
 
 void TextEditComponent::update(int deltaTime)
 {
+	bool cursorVisible = mBlinkTime < BLINKTIME / 2;
+
 	mBlinkTime += deltaTime;
 	if (mBlinkTime >= BLINKTIME)
 		mBlinkTime = 0;
 
+	if (mFocused && cursorVisible != (mBlinkTime < BLINKTIME / 2))
+		Window::invalidate();
+
 	updateCursorRepeat(deltaTime);
 	GuiComponent::update(deltaTime);
 }
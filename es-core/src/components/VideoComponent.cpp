@@ -388,6 +388,7 @@ void VideoComponent::update(int deltaTime)
 				if (diff < FADE_TIME_MS)
 				{
 					mFadeIn = (float)diff / (float)FADE_TIME_MS;
+					Window::invalidate();
 					return;
 				}
 			}
@@ -396,6 +397,8 @@ void VideoComponent::update(int deltaTime)
 		// If the fade in is less than 1 then increment it
 		if (mFadeIn < 1.0f)
 		{
+			Window::invalidate();
+
 			mFadeIn += deltaTime / (float)FADE_TIME_MS;
 			if (mFadeIn > 1.0f)
 				mFadeIn = 1.0f;
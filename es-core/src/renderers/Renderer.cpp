@@ -9,6 +9,7 @@
 
 #include <SDL.h>
 #include <stack>
+#include <vector>
 
 namespace Renderer
 {
@@ -27,6 +28,18 @@ namespace Renderer
 
 	static Vector2i			sdlWindowPosition = Vector2i(SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED);
 
+	static Transform4x4f       currentMatrix  = Transform4x4f::Identity();
+	static bool                matrixIs2D     = true;
+	static unsigned int        currentTexture = 0;
+
+	static std::vector<Vertex> batchVertices;
+	static unsigned int        batchTexture   = 0;
+	static Blend::Factor       batchSrcBlend  = Blend::SRC_ALPHA;
+	static Blend::Factor       batchDstBlend  = Blend::ONE_MINUS_SRC_ALPHA;
+
+	static Stats               frameStats;
+	static Stats               lastFrameStats;
+
 	static void setIcon()
 	{
 		size_t                     width   = 0;
@@ -67,6 +80,11 @@ namespace Renderer
 	{
 		LOG(LogInfo) << "Creating window...";
 
+#if defined(USE_NULL_RENDERER)
+		// No display needed, SDL still runs the events and timers
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+#endif
+
 		if(SDL_Init(SDL_INIT_VIDEO) != 0)
 		{
 			LOG(LogError) << "Error initializing SDL!\n	" << SDL_GetError();
@@ -276,6 +294,7 @@ namespace Renderer
 		clipStack.push(box);
 		nativeClipStack.push(Rect(_pos.x(), _pos.y(), _size.x(), _size.y()));
 
+		flush();
 		setScissor(box);
 
 	} // pushClipRect
@@ -291,11 +310,126 @@ namespace Renderer
 		clipStack.pop();
 		nativeClipStack.pop();
 
+		flush();
+
 		if(clipStack.empty()) setScissor(Rect(0, 0, 0, 0));
 		else                  setScissor(clipStack.top());
 
 	} // popClipRect
 
+	void bindTexture(const unsigned int _texture)
+	{
+		// Nothing is sent to the GPU here, the texture is only applied when its batch is flushed
+		currentTexture = _texture;
+
+	} // bindTexture
+
+	void setMatrix(const Transform4x4f& _matrix)
+	{
+		currentMatrix = _matrix;
+		currentMatrix.round();
+
+		// Only plain 2D transforms can be applied on the CPU, anything with depth or perspective is drawn as is
+		const float* tm = (float*)&currentMatrix;
+		matrixIs2D = tm[2] == 0 && tm[6] == 0 && tm[14] == 0 && tm[3] == 0 && tm[7] == 0 && tm[15] == 1;
+
+	} // setMatrix
+
+	const Transform4x4f& getMatrix()
+	{
+		return currentMatrix;
+
+	} // getMatrix
+
+	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(_numVertices == 0)
+			return;
+
+		frameStats.submits++;
+
+		if(!matrixIs2D)
+		{
+			flush();
+
+			applyMatrix(currentMatrix);
+			if(applyTexture(currentTexture))
+				frameStats.textureBinds++;
+
+			submitTriangleStrips(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
+
+			frameStats.drawCalls++;
+			frameStats.vertices += _numVertices;
+			return;
+		}
+
+		if(!batchVertices.empty() && (batchTexture != currentTexture || batchSrcBlend != _srcBlendFactor || batchDstBlend != _dstBlendFactor))
+			flush();
+
+		batchTexture  = currentTexture;
+		batchSrcBlend = _srcBlendFactor;
+		batchDstBlend = _dstBlendFactor;
+
+		const float* tm = (float*)&currentMatrix;
+
+		// Strips are joined with degenerate triangles : repeat the last vertex of the batch and the first of the new strip
+		size_t start = batchVertices.size();
+		if(start != 0)
+		{
+			batchVertices.push_back(batchVertices[start - 1]);
+			batchVertices.push_back(_vertices[0]);
+			batchVertices.back().pos = Vector2f(tm[0] * _vertices[0].pos.x() + tm[4] * _vertices[0].pos.y() + tm[12], tm[1] * _vertices[0].pos.x() + tm[5] * _vertices[0].pos.y() + tm[13]);
+			start += 2;
+		}
+
+		batchVertices.resize(start + _numVertices);
+
+		Vertex* dst = &batchVertices[start];
+		for(unsigned int i = 0; i < _numVertices; ++i)
+		{
+			const Vector2f& pos = _vertices[i].pos;
+
+			dst[i].pos = Vector2f(tm[0] * pos.x() + tm[4] * pos.y() + tm[12], tm[1] * pos.x() + tm[5] * pos.y() + tm[13]);
+			dst[i].tex = _vertices[i].tex;
+			dst[i].col = _vertices[i].col;
+		}
+
+	} // drawTriangleStrips
+
+	void flush()
+	{
+		if(batchVertices.empty())
+			return;
+
+		// Batched vertices are already transformed
+		applyMatrix(Transform4x4f::Identity());
+		if(applyTexture(batchTexture))
+			frameStats.textureBinds++;
+
+		submitTriangleStrips(&batchVertices[0], (unsigned int)batchVertices.size(), batchSrcBlend, batchDstBlend);
+
+		frameStats.drawCalls++;
+		frameStats.vertices += (unsigned int)batchVertices.size();
+
+		batchVertices.clear();
+
+	} // flush
+
+	void endFrame()
+	{
+		flush();
+
+		lastFrameStats = frameStats;
+		frameStats     = Stats();
+
+	} // endFrame
+
+	const Stats& getStats()
+	{
+		return lastFrameStats;
+
+	} // getStats
+
 	void drawRect(const float _x, const float _y, const float _w, const float _h, const unsigned int _color, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
 		drawRect(_x, _y, _w, _h, _color, _color, true, _srcBlendFactor, _dstBlendFactor);
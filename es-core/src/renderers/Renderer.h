@@ -4,6 +4,10 @@
 
 #include "math/Vector2f.h"
 
+#if defined(USE_NULL_RENDERER)
+#include <vector>
+#endif
+
 class  Transform4x4f;
 class  Vector2i;
 struct SDL_Window;
@@ -62,6 +66,17 @@ namespace Renderer
 
 	}; // Vertex
 
+	struct Stats
+	{
+		Stats() : drawCalls(0), vertices(0), textureBinds(0), submits(0) { }
+
+		unsigned int drawCalls;    // batches sent to the GPU
+		unsigned int vertices;
+		unsigned int textureBinds;
+		unsigned int submits;      // drawTriangleStrips calls, before batching
+
+	}; // Stats
+
  	bool        init            ();
  	void        deinit          ();
 	void        pushClipRect    (const Vector2i& _pos, const Vector2i& _size);
@@ -78,6 +93,15 @@ namespace Renderer
 	int         getScreenOffsetY();
 	int         getScreenRotate ();
 
+	// Batching : triangle strips are transformed on the CPU and merged while the texture, blend and clip don't change
+	void         bindTexture       (const unsigned int _texture);
+	void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void         setMatrix         (const Transform4x4f& _matrix);
+	const Transform4x4f& getMatrix ();
+	void         flush             ();
+	void         endFrame          ();
+	const Stats& getStats          (); // last complete frame
+
 	// API specific
 	unsigned int convertColor      (const unsigned int _color);
 	unsigned int getWindowFlags    ();
@@ -87,11 +111,11 @@ namespace Renderer
 	unsigned int createTexture     (const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data);
 	void         destroyTexture    (const unsigned int _texture);
 	void         updateTexture     (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data);
-	void         bindTexture       (const unsigned int _texture);
+	bool         applyTexture      (const unsigned int _texture);
 	void         drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
-	void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void         submitTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor);
 	void         setProjection     (const Transform4x4f& _projection);
-	void         setMatrix         (const Transform4x4f& _matrix);
+	void         applyMatrix       (const Transform4x4f& _matrix);
 	void         setViewport       (const Rect& _viewport);
 	void         setScissor        (const Rect& _scissor);
 	void         setSwapInterval   ();
@@ -109,6 +133,27 @@ namespace Renderer
 
 	void		activateWindow();
 
+#if defined(USE_NULL_RENDERER)
+	// Headless backend : keeps what reaches submitTriangleStrips, for the tests
+	struct RecordedDraw
+	{
+		RecordedDraw() : texture(0), srcBlendFactor(Blend::SRC_ALPHA), dstBlendFactor(Blend::ONE_MINUS_SRC_ALPHA), scissor(0, 0, 0, 0) { }
+
+		unsigned int        texture;
+		Blend::Factor       srcBlendFactor;
+		Blend::Factor       dstBlendFactor;
+		Rect                scissor;
+		float               matrix[16]; // model view
+		std::vector<Vertex> vertices;
+
+	}; // RecordedDraw
+
+	void                             setRecordDraws    (const bool _record);
+	const std::vector<RecordedDraw>& getRecordedDraws  ();
+	void                             clearRecordedDraws();
+	unsigned int                     getFrameCount     (); // frames presented by swapBuffers
+#endif
+
 } // Renderer::
 
 #endif // ES_CORE_RENDERER_RENDERER_H
@@ -13,6 +13,11 @@ namespace Renderer
 {
 	static SDL_GLContext sdlContext = nullptr;
 
+	// Last state sent to GL, so batches only change what differs
+	static unsigned int  boundTexture   = (unsigned int)-1;
+	static Blend::Factor boundSrcBlend  = Blend::ZERO;
+	static Blend::Factor boundDstBlend  = Blend::ZERO;
+
 	static GLenum convertBlendFactor(const Blend::Factor _blendFactor)
 	{
 		switch(_blendFactor)
@@ -43,6 +48,26 @@ namespace Renderer
 
 	} // convertTextureType
 
+	static void applyBlend(const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(_srcBlendFactor == boundSrcBlend && _dstBlendFactor == boundDstBlend)
+			return;
+
+		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
+
+		boundSrcBlend = _srcBlendFactor;
+		boundDstBlend = _dstBlendFactor;
+
+	} // applyBlend
+
+	static void applyVertices(const Vertex* _vertices)
+	{
+		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
+		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
+		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+
+	} // applyVertices
+
 	unsigned int convertColor(const unsigned int _color)
 	{
 		// convert from rgba to abgr
@@ -83,6 +108,16 @@ namespace Renderer
 
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+		// Every draw uses blending and the same vertex layout : enable them once
+		glEnable(GL_BLEND);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+
+		boundTexture  = (unsigned int)-1;
+		boundSrcBlend = Blend::ZERO;
+		boundDstBlend = Blend::ZERO;
+
 		std::string glExts = (const char*)glGetString(GL_EXTENSIONS);
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
 		LOG(LogInfo) << " ARB_texture_non_power_of_two: " << (glExts.find("ARB_texture_non_power_of_two") != std::string::npos ? "ok" : "MISSING");
@@ -101,8 +136,10 @@ namespace Renderer
 		const GLenum type = convertTextureType(_type);
 		unsigned int texture;
 
+		flush();
+
 		glGenTextures(1, &texture);
-		bindTexture(texture);
+		applyTexture(texture);
 
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
@@ -121,13 +158,20 @@ namespace Renderer
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		flush();
+
 		glDeleteTextures(1, &_texture);
 
+		// GL falls back to texture 0 but keeps GL_TEXTURE_2D enabled
+		if(boundTexture == _texture)
+			boundTexture = (unsigned int)-1;
+
 	} // destroyTexture
 
 	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		bindTexture(_texture);
+		flush();
+		applyTexture(_texture);
 
 		if (_x == -1 && _y == -1)
 		{
@@ -137,64 +181,44 @@ namespace Renderer
 		else
 			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
 
-		bindTexture(0);
-
 	} // updateTexture
 
-	void bindTexture(const unsigned int _texture)
+	bool applyTexture(const unsigned int _texture)
 	{
+		if(_texture == boundTexture)
+			return false;
+
 		glBindTexture(GL_TEXTURE_2D, _texture);
 
 		if(_texture == 0) glDisable(GL_TEXTURE_2D);
 		else              glEnable(GL_TEXTURE_2D);
 
-	} // bindTexture
+		boundTexture = _texture;
+		return true;
+
+	} // applyTexture
 
 	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
+		flush();
 
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+		applyMatrix(getMatrix());
+		applyTexture(0);
+		applyBlend(_srcBlendFactor, _dstBlendFactor);
+		applyVertices(_vertices);
 
 		glDrawArrays(GL_LINES, 0, _numVertices);
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-
-		glDisable(GL_BLEND);
-
 	} // drawLines
 
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void submitTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+		applyBlend(_srcBlendFactor, _dstBlendFactor);
+		applyVertices(_vertices);
 
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices);
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-
-		glDisable(GL_BLEND);
-
-	} // drawTriangleStrips
+	} // submitTriangleStrips
 
 	void setProjection(const Transform4x4f& _projection)
 	{
@@ -203,14 +227,12 @@ namespace Renderer
 
 	} // setProjection
 
-	void setMatrix(const Transform4x4f& _matrix)
+	void applyMatrix(const Transform4x4f& _matrix)
 	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
 		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf((GLfloat*)&matrix);
+		glLoadMatrixf((GLfloat*)&_matrix);
 
-	} // setMatrix
+	} // applyMatrix
 
 	void setViewport(const Rect& _viewport)
 	{
@@ -255,6 +277,8 @@ namespace Renderer
 
 	void swapBuffers()
 	{
+		endFrame();
+
 		SDL_GL_SwapWindow(getSDLWindow());
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -305,33 +329,22 @@ namespace Renderer
 		for (int i = 0; i < vertex.size(); i++)
 			vxs[i] = vertex[i];
 
-		bindTexture(0);
-
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
+		flush();
 
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
+		applyMatrix(getMatrix());
+		applyTexture(0);
 
-		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].tex);
-		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vxs[0].col);
+		applyBlend(_srcBlendFactor, _dstBlendFactor);
+		applyVertices(vxs);
 
 		glDrawArrays(GL_TRIANGLE_FAN, 0, vertex.size());
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisable(GL_BLEND);
-
-		delete[] vxs;	
+		delete[] vxs;
 	}
 
 	void enableRoundCornerStencil(float x, float y, float width, float height, float radius)
 	{
-		bool tx = glIsEnabled(GL_TEXTURE_2D);
-		glDisable(GL_TEXTURE_2D);
+		flush();
 
 		glClear(GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_STENCIL_TEST);
@@ -350,13 +363,11 @@ namespace Renderer
 		glStencilMask(0x00);
 		glStencilFunc(GL_EQUAL, 0, 0xFF);
 		glStencilFunc(GL_EQUAL, 1, 0xFF);
-
-		if (tx)
-			glEnable(GL_TEXTURE_2D);
 	}
 
 	void disableStencil()
 	{
+		flush();
 		glDisable(GL_STENCIL_TEST);
 	}
 } // Renderer::
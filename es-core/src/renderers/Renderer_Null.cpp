@@ -0,0 +1,535 @@
+#if defined(USE_NULL_RENDERER)
+
+#include "renderers/Renderer.h"
+#include "math/Transform4x4f.h"
+#include "math/Misc.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Settings.h"
+
+#include <FreeImage.h>
+#include <SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+// Headless backend : there is no GL context, textures and draws are only recorded.
+// When HeadlessDumpPath is set, draws are also rasterized on the CPU and one frame out of
+// HeadlessDumpInterval is saved there as png. Stencil ( rounded corners ) is not emulated.
+
+namespace Renderer
+{
+	struct NullTexture
+	{
+		Texture::Type              type;
+		bool                       repeat;
+		unsigned int               width;
+		unsigned int               height;
+		std::vector<unsigned char> pixels; // only kept when rasterizing
+
+	}; // NullTexture
+
+	struct RasterVertex
+	{
+		float x;
+		float y;
+		float u;
+		float v;
+		float col[4];
+
+	}; // RasterVertex
+
+	static std::map<unsigned int, NullTexture> textures;
+	static unsigned int              nextTexture      = 1;
+	static unsigned int              boundTexture     = 0;
+
+	static Transform4x4f             projectionMatrix = Transform4x4f::Identity();
+	static Transform4x4f             modelViewMatrix  = Transform4x4f::Identity();
+	static Rect                      viewportRect     = Rect(0, 0, 0, 0);
+	static Rect                      scissorRect      = Rect(0, 0, 0, 0);
+
+	static bool                      rasterize        = false;
+	static std::string               dumpPath;
+	static int                       dumpInterval     = 1;
+	static std::vector<unsigned int> frameBuffer;
+	static int                       frameWidth       = 0;
+	static int                       frameHeight      = 0;
+
+	static bool                      recordDraws      = false;
+	static std::vector<RecordedDraw> recordedDraws;
+
+	// Recorded for the whole run
+	static unsigned int              frameCount       = 0;
+	static unsigned int              texturesCreated  = 0;
+	static unsigned int              textureUploads   = 0;
+	static size_t                    textureMemory    = 0;
+	static size_t                    maxTextureMemory = 0;
+
+	static size_t getTextureSize(const Texture::Type _type, const unsigned int _width, const unsigned int _height)
+	{
+		return (size_t)_width * _height * (_type == Texture::ALPHA ? 1 : 4);
+
+	} // getTextureSize
+
+	static void getBlendFactor(const Blend::Factor _factor, const float* _src, const float* _dst, float* _out)
+	{
+		for(int i = 0; i < 4; ++i)
+		{
+			switch(_factor)
+			{
+				case Blend::ZERO:                { _out[i] = 0.0f;              } break;
+				case Blend::ONE:                 { _out[i] = 1.0f;              } break;
+				case Blend::SRC_COLOR:           { _out[i] = _src[i];           } break;
+				case Blend::ONE_MINUS_SRC_COLOR: { _out[i] = 1.0f - _src[i];    } break;
+				case Blend::SRC_ALPHA:           { _out[i] = _src[3];           } break;
+				case Blend::ONE_MINUS_SRC_ALPHA: { _out[i] = 1.0f - _src[3];    } break;
+				case Blend::DST_COLOR:           { _out[i] = _dst[i];           } break;
+				case Blend::ONE_MINUS_DST_COLOR: { _out[i] = 1.0f - _dst[i];    } break;
+				case Blend::DST_ALPHA:           { _out[i] = _dst[3];           } break;
+				case Blend::ONE_MINUS_DST_ALPHA: { _out[i] = 1.0f - _dst[3];    } break;
+				default:                         { _out[i] = 0.0f;              }
+			}
+		}
+
+	} // getBlendFactor
+
+	static RasterVertex toWindow(const Transform4x4f& _mvp, const Vertex& _vertex)
+	{
+		const Vector3f ndc = _mvp * Vector3f(_vertex.pos.x(), _vertex.pos.y(), 0);
+		const unsigned char* col = (const unsigned char*)&_vertex.col;
+
+		RasterVertex vertex;
+		vertex.x = viewportRect.x + (ndc.x() + 1.0f) * 0.5f * viewportRect.w;
+		vertex.y = viewportRect.y + (1.0f - ndc.y()) * 0.5f * viewportRect.h;
+		vertex.u = _vertex.tex.x();
+		vertex.v = _vertex.tex.y();
+
+		// converted colors are stored as r, g, b, a bytes
+		for(int i = 0; i < 4; ++i)
+			vertex.col[i] = col[i] / 255.0f;
+
+		return vertex;
+
+	} // toWindow
+
+	static void sampleTexture(const NullTexture* _texture, float _u, float _v, float* _out)
+	{
+		int x = (int)Math::floorf(_u * _texture->width);
+		int y = (int)Math::floorf(_v * _texture->height);
+
+		if(_texture->repeat)
+		{
+			x %= (int)_texture->width;  if(x < 0) x += _texture->width;
+			y %= (int)_texture->height; if(y < 0) y += _texture->height;
+		}
+		else
+		{
+			x = std::max(0, std::min(x, (int)_texture->width  - 1));
+			y = std::max(0, std::min(y, (int)_texture->height - 1));
+		}
+
+		if(_texture->type == Texture::ALPHA)
+		{
+			_out[0] = _out[1] = _out[2] = 1.0f;
+			_out[3] = _texture->pixels[y * _texture->width + x] / 255.0f;
+			return;
+		}
+
+		const unsigned char* px = &_texture->pixels[(y * _texture->width + x) * 4];
+		for(int i = 0; i < 4; ++i)
+			_out[i] = px[i] / 255.0f;
+
+	} // sampleTexture
+
+	static void rasterTriangle(const RasterVertex& _a, const RasterVertex& _b, const RasterVertex& _c, const NullTexture* _texture, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		const float area = (_b.x - _a.x) * (_c.y - _a.y) - (_b.y - _a.y) * (_c.x - _a.x);
+		if(fabs(area) < 0.0001f)
+			return;
+
+		int minX = (int)Math::floorf(std::min(_a.x, std::min(_b.x, _c.x)));
+		int minY = (int)Math::floorf(std::min(_a.y, std::min(_b.y, _c.y)));
+		int maxX = (int)Math::ceilf( std::max(_a.x, std::max(_b.x, _c.x)));
+		int maxY = (int)Math::ceilf( std::max(_a.y, std::max(_b.y, _c.y)));
+
+		int clipX = 0, clipY = 0, clipW = frameWidth, clipH = frameHeight;
+		if(scissorRect.w != 0 || scissorRect.h != 0 || scissorRect.x != 0 || scissorRect.y != 0)
+		{
+			clipX = scissorRect.x; clipY = scissorRect.y;
+			clipW = scissorRect.w; clipH = scissorRect.h;
+		}
+
+		minX = std::max(minX, std::max(0, clipX));
+		minY = std::max(minY, std::max(0, clipY));
+		maxX = std::min(maxX, std::min(frameWidth,  clipX + clipW));
+		maxY = std::min(maxY, std::min(frameHeight, clipY + clipH));
+
+		float src[4], dst[4], texel[4], srcFactor[4], dstFactor[4];
+
+		for(int y = minY; y < maxY; ++y)
+		{
+			const float py = y + 0.5f;
+
+			for(int x = minX; x < maxX; ++x)
+			{
+				const float px = x + 0.5f;
+
+				const float w0 = ((_c.x - _b.x) * (py - _b.y) - (_c.y - _b.y) * (px - _b.x)) / area;
+				const float w1 = ((_a.x - _c.x) * (py - _c.y) - (_a.y - _c.y) * (px - _c.x)) / area;
+				const float w2 = 1.0f - w0 - w1;
+
+				if(w0 < 0 || w1 < 0 || w2 < 0)
+					continue;
+
+				for(int i = 0; i < 4; ++i)
+					src[i] = _a.col[i] * w0 + _b.col[i] * w1 + _c.col[i] * w2;
+
+				if(_texture != nullptr && !_texture->pixels.empty())
+				{
+					sampleTexture(_texture, _a.u * w0 + _b.u * w1 + _c.u * w2, _a.v * w0 + _b.v * w1 + _c.v * w2, texel);
+					for(int i = 0; i < 4; ++i)
+						src[i] *= texel[i];
+				}
+
+				unsigned char* pixel = (unsigned char*)&frameBuffer[y * frameWidth + x];
+				for(int i = 0; i < 4; ++i)
+					dst[i] = pixel[i] / 255.0f;
+
+				getBlendFactor(_srcBlendFactor, src, dst, srcFactor);
+				getBlendFactor(_dstBlendFactor, src, dst, dstFactor);
+
+				for(int i = 0; i < 4; ++i)
+					pixel[i] = (unsigned char)(Math::clamp(src[i] * srcFactor[i] + dst[i] * dstFactor[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
+
+	} // rasterTriangle
+
+	static const NullTexture* getBoundTexture()
+	{
+		auto it = textures.find(boundTexture);
+		return it != textures.cend() ? &it->second : nullptr;
+
+	} // getBoundTexture
+
+	static void dumpFrame()
+	{
+		std::vector<unsigned char> bgra(frameBuffer.size() * 4);
+		const unsigned char* rgba = (const unsigned char*)&frameBuffer[0];
+
+		for(size_t i = 0; i < frameBuffer.size(); ++i)
+		{
+			bgra[i * 4 + 0] = rgba[i * 4 + 2];
+			bgra[i * 4 + 1] = rgba[i * 4 + 1];
+			bgra[i * 4 + 2] = rgba[i * 4 + 0];
+			bgra[i * 4 + 3] = 255;
+		}
+
+		FIBITMAP* bitmap = FreeImage_ConvertFromRawBits(&bgra[0], frameWidth, frameHeight, frameWidth * 4, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, true);
+		if(bitmap == nullptr)
+			return;
+
+		char name[32];
+		snprintf(name, sizeof(name), "/frame-%06u.png", frameCount);
+
+		if(!FreeImage_Save(FIF_PNG, bitmap, (dumpPath + name).c_str()))
+			LOG(LogWarning) << "Headless renderer : unable to save " << dumpPath << name;
+
+		FreeImage_Unload(bitmap);
+
+	} // dumpFrame
+
+	unsigned int convertColor(const unsigned int _color)
+	{
+		// convert from rgba to abgr
+		unsigned char r = ((_color & 0xff000000) >> 24) & 255;
+		unsigned char g = ((_color & 0x00ff0000) >> 16) & 255;
+		unsigned char b = ((_color & 0x0000ff00) >>  8) & 255;
+		unsigned char a = ((_color & 0x000000ff)      ) & 255;
+
+		return ((a << 24) | (b << 16) | (g << 8) | (r));
+
+	} // convertColor
+
+	unsigned int getWindowFlags()
+	{
+		return 0;
+
+	} // getWindowFlags
+
+	void setupWindow()
+	{
+	} // setupWindow
+
+	void createContext()
+	{
+		dumpPath     = Settings::getInstance()->getString("HeadlessDumpPath");
+		dumpInterval = std::max(1, Settings::getInstance()->getInt("HeadlessDumpInterval"));
+		rasterize    = !dumpPath.empty();
+
+		frameWidth  = getWindowWidth();
+		frameHeight = getWindowHeight();
+
+		if(rasterize)
+		{
+			Utils::FileSystem::createDirectory(dumpPath);
+			frameBuffer.assign((size_t)frameWidth * frameHeight, 0);
+		}
+
+		LOG(LogInfo) << "Headless renderer " << frameWidth << "x" << frameHeight << (rasterize ? ", saving frames to " + dumpPath : std::string());
+
+	} // createContext
+
+	void destroyContext()
+	{
+		LOG(LogInfo) << "Headless renderer : " << frameCount << " frames, " << texturesCreated << " textures created, " << textureUploads << " uploads, " << (maxTextureMemory / 1024 / 1024) << " MB max texture memory";
+
+		textures.clear();
+		frameBuffer.clear();
+		textureMemory = 0;
+
+	} // destroyContext
+
+	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		flush();
+
+		unsigned int texture = nextTexture++;
+
+		NullTexture& tex = textures[texture];
+		tex.type   = _type;
+		tex.repeat = _repeat;
+		tex.width  = _width;
+		tex.height = _height;
+
+		const size_t size = getTextureSize(_type, _width, _height);
+		if(rasterize)
+		{
+			if(_data != nullptr) tex.pixels.assign((unsigned char*)_data, (unsigned char*)_data + size);
+			else                 tex.pixels.assign(size, 0);
+		}
+
+		texturesCreated++;
+		textureMemory += size;
+		maxTextureMemory = std::max(maxTextureMemory, textureMemory);
+
+		boundTexture = texture;
+		return texture;
+
+	} // createTexture
+
+	void destroyTexture(const unsigned int _texture)
+	{
+		flush();
+
+		auto it = textures.find(_texture);
+		if(it == textures.cend())
+			return;
+
+		textureMemory -= getTextureSize(it->second.type, it->second.width, it->second.height);
+		textures.erase(it);
+
+		if(boundTexture == _texture)
+			boundTexture = 0;
+
+	} // destroyTexture
+
+	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		flush();
+
+		auto it = textures.find(_texture);
+		if(it == textures.cend())
+			return;
+
+		NullTexture& tex = it->second;
+		textureUploads++;
+
+		if(_x == -1 && _y == -1)
+		{
+			textureMemory -= getTextureSize(tex.type, tex.width, tex.height);
+
+			tex.type   = _type;
+			tex.width  = _width;
+			tex.height = _height;
+
+			const size_t size = getTextureSize(_type, _width, _height);
+			if(rasterize)
+			{
+				if(_data != nullptr) tex.pixels.assign((unsigned char*)_data, (unsigned char*)_data + size);
+				else                 tex.pixels.assign(size, 0);
+			}
+
+			textureMemory += size;
+			maxTextureMemory = std::max(maxTextureMemory, textureMemory);
+		}
+		else if(rasterize && _data != nullptr && _x + _width <= tex.width && _y + _height <= tex.height)
+		{
+			const size_t bpp = (tex.type == Texture::ALPHA ? 1 : 4);
+			for(unsigned int row = 0; row < _height; ++row)
+				memcpy(&tex.pixels[((_y + row) * tex.width + _x) * bpp], (unsigned char*)_data + row * _width * bpp, _width * bpp);
+		}
+
+		boundTexture = _texture;
+
+	} // updateTexture
+
+	bool applyTexture(const unsigned int _texture)
+	{
+		if(_texture == boundTexture)
+			return false;
+
+		boundTexture = _texture;
+		return true;
+
+	} // applyTexture
+
+	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		// Debug lines only, recorded but not rasterized
+		flush();
+
+	} // drawLines
+
+	void submitTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if(recordDraws)
+		{
+			RecordedDraw draw;
+			draw.texture        = boundTexture;
+			draw.srcBlendFactor = _srcBlendFactor;
+			draw.dstBlendFactor = _dstBlendFactor;
+			draw.scissor        = scissorRect;
+			draw.vertices.assign(_vertices, _vertices + _numVertices);
+			memcpy(draw.matrix, &modelViewMatrix, sizeof(draw.matrix));
+
+			recordedDraws.push_back(draw);
+		}
+
+		if(!rasterize || _numVertices < 3)
+			return;
+
+		const Transform4x4f mvp     = projectionMatrix * modelViewMatrix;
+		const NullTexture*  texture = getBoundTexture();
+
+		RasterVertex a = toWindow(mvp, _vertices[0]);
+		RasterVertex b = toWindow(mvp, _vertices[1]);
+
+		for(unsigned int i = 2; i < _numVertices; ++i)
+		{
+			RasterVertex c = toWindow(mvp, _vertices[i]);
+			rasterTriangle(a, b, c, texture, _srcBlendFactor, _dstBlendFactor);
+
+			a = b;
+			b = c;
+		}
+
+	} // submitTriangleStrips
+
+	void setProjection(const Transform4x4f& _projection)
+	{
+		projectionMatrix = _projection;
+
+	} // setProjection
+
+	void applyMatrix(const Transform4x4f& _matrix)
+	{
+		modelViewMatrix = _matrix;
+
+	} // applyMatrix
+
+	void setViewport(const Rect& _viewport)
+	{
+		viewportRect = _viewport;
+
+	} // setViewport
+
+	void setScissor(const Rect& _scissor)
+	{
+		scissorRect = _scissor;
+
+	} // setScissor
+
+	void setSwapInterval()
+	{
+	} // setSwapInterval
+
+	void swapBuffers()
+	{
+		endFrame();
+
+		if(rasterize)
+		{
+			if(frameCount % dumpInterval == 0)
+				dumpFrame();
+
+			std::fill(frameBuffer.begin(), frameBuffer.end(), 0);
+		}
+
+		frameCount++;
+
+	} // swapBuffers
+
+	void drawRoundRect(float x, float y, float width, float height, float radius, unsigned int color, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		flush();
+
+		if(!rasterize)
+			return;
+
+		// Corners are not worth emulating here, draw the plain rectangle
+		const unsigned int finalColor = convertColor(color);
+
+		Vertex vertices[4];
+		vertices[0] = { { x,         y          }, { 0.0f, 0.0f }, finalColor };
+		vertices[1] = { { x,         y + height }, { 0.0f, 0.0f }, finalColor };
+		vertices[2] = { { x + width, y          }, { 0.0f, 0.0f }, finalColor };
+		vertices[3] = { { x + width, y + height }, { 0.0f, 0.0f }, finalColor };
+
+		applyMatrix(getMatrix());
+		applyTexture(0);
+		submitTriangleStrips(vertices, 4, _srcBlendFactor, _dstBlendFactor);
+
+	} // drawRoundRect
+
+	void setRecordDraws(const bool _record)
+	{
+		recordDraws = _record;
+
+	} // setRecordDraws
+
+	const std::vector<RecordedDraw>& getRecordedDraws()
+	{
+		return recordedDraws;
+
+	} // getRecordedDraws
+
+	void clearRecordedDraws()
+	{
+		recordedDraws.clear();
+
+	} // clearRecordedDraws
+
+	unsigned int getFrameCount()
+	{
+		return frameCount;
+
+	} // getFrameCount
+
+	void enableRoundCornerStencil(float x, float y, float width, float height, float radius)
+	{
+		flush();
+
+	} // enableRoundCornerStencil
+
+	void disableStencil()
+	{
+		flush();
+
+	} // disableStencil
+
+} // Renderer::
+
+#endif // USE_NULL_RENDERER
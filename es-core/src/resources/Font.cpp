@@ -6,23 +6,83 @@
 #include "Log.h"
 #include "math/Misc.h"
 
+#include <fstream>
+
 #ifdef WIN32
 #include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
+#define GLYPHCACHE_MAX_GLYPHS 1024 // per font
+
 FT_Library Font::sLibrary = NULL;
 
 int Font::getSize() const { return mSize; }
 
 std::map< std::pair<std::string, int>, std::weak_ptr<Font> > Font::sFontMap;
 
-Font::FontFace::FontFace(ResourceData&& d, int size) : data(d)
+std::mutex Font::sFaceCacheLock;
+std::map<std::string, std::weak_ptr<Font::FontFile> > Font::sFontFiles;
+std::map< std::pair<std::string, int>, std::weak_ptr<Font::FontFace> > Font::sFontFaces;
+
+std::map< std::pair<std::string, int>, std::set<unsigned int> > Font::sGlyphCache;
+bool Font::sGlyphCacheLoaded = false;
+
+Font::FontFile::FontFile(const std::string& path) : data(nullptr), length(0), mMapped(nullptr)
 {
-	int err = FT_New_Memory_Face(sLibrary, data.ptr.get(), (FT_Long)data.length, 0, &face);
+#ifndef WIN32
+	// Fallback fonts are big ( CJK ) : let the system page in only the glyphs being used
+	std::string realPath = ResourceManager::getInstance()->getResourcePath(path);
+
+	int fd = open(realPath.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped != MAP_FAILED)
+			{
+				mMapped = mapped;
+				data = (const unsigned char*)mapped;
+				length = (size_t)st.st_size;
+			}
+		}
+
+		close(fd);
+	}
+
+	if (mMapped != nullptr)
+		return;
+#endif
+
+	ResourceData resource = ResourceManager::getInstance()->getFileData(path);
+	mBuffer = resource.ptr;
+	data = mBuffer.get();
+	length = resource.length;
+}
+
+Font::FontFile::~FontFile()
+{
+#ifndef WIN32
+	if (mMapped != nullptr)
+		munmap(mMapped, length);
+#endif
+}
+
+Font::FontFace::FontFace(const std::shared_ptr<FontFile>& f, int size) : file(f), face(nullptr)
+{
+	int err = FT_New_Memory_Face(sLibrary, file->data, (FT_Long)file->length, 0, &face);
 	assert(!err);
 	
 	if(!err)
 		FT_Set_Pixel_Sizes(face, 0, size);
+	else
+		face = nullptr;
 }
 
 Font::FontFace::~FontFace()
@@ -31,6 +91,37 @@ Font::FontFace::~FontFace()
 		FT_Done_Face(face);
 }
 
+std::shared_ptr<Font::FontFace> Font::getFace(const std::string& path, int size)
+{
+	std::unique_lock<std::mutex> lock(sFaceCacheLock);
+
+	auto key = std::pair<std::string, int>(path, size);
+
+	auto it = sFontFaces.find(key);
+	if (it != sFontFaces.cend())
+	{
+		auto face = it->second.lock();
+		if (face != nullptr)
+			return face;
+	}
+
+	std::shared_ptr<FontFile> file;
+
+	auto fit = sFontFiles.find(path);
+	if (fit != sFontFiles.cend())
+		file = fit->second.lock();
+
+	if (file == nullptr)
+	{
+		file = std::make_shared<FontFile>(path);
+		sFontFiles[path] = file;
+	}
+
+	auto face = std::make_shared<FontFace>(file, size);
+	sFontFaces[key] = face;
+	return face;
+}
+
 void Font::initLibrary()
 {
 	assert(sLibrary == NULL);
@@ -47,9 +138,6 @@ size_t Font::getMemUsage() const
 	for(auto it = mTextures.cbegin(); it != mTextures.cend(); it++)
 		memUsage += it->textureSize.x() * it->textureSize.y() * 4;
 
-	for(auto it = mFaceCache.cbegin(); it != mFaceCache.cend(); it++)
-		memUsage += it->second->data.length;
-
 	return memUsage;
 }
 
@@ -70,6 +158,22 @@ size_t Font::getTotalMemUsage()
 		it++;
 	}
 
+	// The font files are shared by the sizes & the fallbacks : each one is counted once
+	std::unique_lock<std::mutex> lock(sFaceCacheLock);
+
+	for (auto fit = sFontFiles.cbegin(); fit != sFontFiles.cend(); )
+	{
+		auto file = fit->second.lock();
+		if (file == nullptr)
+		{
+			fit = sFontFiles.erase(fit);
+			continue;
+		}
+
+		total += file->length;
+		fit++;
+	}
+
 	return total;
 }
 
@@ -102,17 +206,110 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 	for(unsigned int i = 32; i < 128; i++)
 		getGlyph(i);
 
-	clearFaceCache();
+	// and the ones this font needed during the previous runs ( accents, CJK descriptions... )
+	loadGlyphCache();
+
+	std::set<unsigned int> glyphs;
+
+	{
+		std::unique_lock<std::mutex> lock(sFaceCacheLock);
+
+		auto it = sGlyphCache.find(std::pair<std::string, int>(mPath, mSize));
+		if (it != sGlyphCache.cend())
+			glyphs = it->second;
+	}
+
+	for (auto id : glyphs)
+		getGlyph(id);
 }
 
 Font::~Font()
 {
+	updateGlyphCache();
+
 	for (auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
 		delete it->second;
 
 	unload();
 }
 
+static std::string getGlyphCacheFilename()
+{
+	return Utils::FileSystem::getEsConfigPath() + "/glyphcache.db";
+}
+
+// Format : size|path|codepoints separated by spaces
+void Font::loadGlyphCache()
+{
+	std::unique_lock<std::mutex> lock(sFaceCacheLock);
+
+	if (sGlyphCacheLoaded)
+		return;
+
+	sGlyphCacheLoaded = true;
+
+	std::ifstream f(getGlyphCacheFilename().c_str());
+	if (f.fail())
+		return;
+
+	std::string line;
+	while (std::getline(f, line))
+	{
+		auto splits = Utils::String::split(line, '|');
+		if (splits.size() != 3)
+			continue;
+
+		auto& glyphs = sGlyphCache[std::pair<std::string, int>(splits[1], atoi(splits[0].c_str()))];
+		for (auto id : Utils::String::split(splits[2], ' '))
+			if (!id.empty())
+				glyphs.insert((unsigned int)atoi(id.c_str()));
+	}
+
+	f.close();
+}
+
+void Font::updateGlyphCache()
+{
+	std::unique_lock<std::mutex> lock(sFaceCacheLock);
+
+	auto& glyphs = sGlyphCache[std::pair<std::string, int>(mPath, mSize)];
+
+	for (auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend() && glyphs.size() < GLYPHCACHE_MAX_GLYPHS; it++)
+		if (it->first >= 128 && it->second != nullptr)
+			glyphs.insert(it->first);
+}
+
+void Font::saveGlyphCache()
+{
+	for (auto it = sFontMap.cbegin(); it != sFontMap.cend(); it++)
+	{
+		auto font = it->second.lock();
+		if (font != nullptr)
+			font->updateGlyphCache();
+	}
+
+	std::unique_lock<std::mutex> lock(sFaceCacheLock);
+
+	std::ofstream f(getGlyphCacheFilename().c_str(), std::ios::binary);
+	if (f.fail())
+		return;
+
+	for (auto it = sGlyphCache.cbegin(); it != sGlyphCache.cend(); it++)
+	{
+		if (it->second.empty())
+			continue;
+
+		f << std::to_string(it->first.second) << "|" << it->first.first << "|";
+
+		for (auto id : it->second)
+			f << std::to_string(id) << " ";
+
+		f << "\n";
+	}
+
+	f.close();
+}
+
 void Font::reload()
 {
 	if (mLoaded)
@@ -127,6 +324,7 @@ bool  Font::unload()
 	if (mLoaded)
 	{
 		unloadTextures();
+		clearFaceCache();
 		mLoaded = false;
 		return true;
 	}
@@ -317,12 +515,11 @@ FT_Face Font::getFaceForChar(unsigned int id)
 			// i == 0 -> mPath
 			// otherwise, take from fallbackFonts
 			const std::string& path = (i == 0 ? mPath : fallbackFonts.at(i - 1));
-			ResourceData data = ResourceManager::getInstance()->getFileData(path);
-			mFaceCache[i] = std::unique_ptr<FontFace>(new FontFace(std::move(data), mSize));
+			mFaceCache[i] = getFace(path, mSize);
 			fit = mFaceCache.find(i);
 		}
 
-		if(FT_Get_Char_Index(fit->second->face, id) != 0)
+		if(fit->second->face != nullptr && FT_Get_Char_Index(fit->second->face, id) != 0)
 			return fit->second->face;
 	}
 
@@ -745,8 +942,6 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 		i++;
 	}
 
-	clearFaceCache();
-
 	return cache;
 }
 
@@ -9,6 +9,9 @@
 #include "ThemeData.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <map>
+#include <mutex>
+#include <set>
 #include <vector>
 
 class TextCache;
@@ -71,7 +74,10 @@ public:
 	static std::shared_ptr<Font> getFromTheme(const ThemeData::ThemeElement* elem, unsigned int properties, const std::shared_ptr<Font>& orig);
 
 	size_t getMemUsage() const; // returns an approximation of VRAM used by this font's texture (in bytes)
-	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by font textures (in bytes)
+	static size_t getTotalMemUsage(); // returns an approximation of total memory used by font textures and font files (in bytes)
+
+	// Non ASCII glyphs used by each font are saved at exit and rasterized again when the font is created
+	static void saveGlyphCache();
 
 private:
 	static FT_Library sLibrary;
@@ -96,15 +102,40 @@ private:
 		void deinitTexture(); // deinitializes the OpenGL texture if any exists, is automatically called in the destructor
 	};
 
+	// Content of a font file, mapped once and shared by the faces of all sizes
+	struct FontFile
+	{
+		FontFile(const std::string& path);
+		~FontFile();
+
+		const unsigned char* data;
+		size_t length;
+
+	private:
+		std::shared_ptr<unsigned char> mBuffer; // When the file can't be mapped
+		void* mMapped;
+	};
+
+	// FT_Face shared by all the fonts using the same file at the same size ( fallback fonts )
 	struct FontFace
 	{
-		const ResourceData data;
+		std::shared_ptr<FontFile> file;
 		FT_Face face;
 
-		FontFace(ResourceData&& d, int size);
+		FontFace(const std::shared_ptr<FontFile>& f, int size);
 		virtual ~FontFace();
 	};
 
+	static std::mutex sFaceCacheLock;
+	static std::map<std::string, std::weak_ptr<FontFile> > sFontFiles;
+	static std::map< std::pair<std::string, int>, std::weak_ptr<FontFace> > sFontFaces;
+	static std::shared_ptr<FontFace> getFace(const std::string& path, int size);
+
+	static std::map< std::pair<std::string, int>, std::set<unsigned int> > sGlyphCache;
+	static bool sGlyphCacheLoaded;
+	static void loadGlyphCache();
+	void updateGlyphCache();
+
 	void rebuildTextures();
 	void unloadTextures();
 
@@ -112,7 +143,7 @@ private:
 
 	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
 
-	std::map< unsigned int, std::unique_ptr<FontFace> > mFaceCache;
+	std::map< unsigned int, std::shared_ptr<FontFace> > mFaceCache;
 	FT_Face getFaceForChar(unsigned int id);
 	void clearFaceCache();
 
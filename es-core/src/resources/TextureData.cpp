@@ -5,21 +5,54 @@
 #include "resources/ResourceManager.h"
 #include "ImageIO.h"
 #include "Log.h"
+#include "Profiler.h"
+#include "utils/FileSystemUtil.h"
 #include <nanosvg/nanosvg.h>
 #include <nanosvg/nanosvgrast.h>
 #include <assert.h>
 #include <string.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
 #include "Settings.h"
 
 #define DPI 96
 
 #define OPTIMIZEVRAM Settings::getInstance()->getBool("OptimizeVRAM")
 
+std::atomic<size_t> TextureData::sTotalMemUsage(0);
+std::thread::id TextureData::sUiThreadId;
+std::atomic<int> TextureData::sUiThreadLoads(0);
+
+namespace
+{
+	struct ResumeEntry
+	{
+		std::string		key;
+		unsigned char*	data;
+		size_t			width;
+		size_t			height;
+		float			sourceWidth;
+		float			sourceHeight;
+		bool			scalable;
+		Vector2i		packedSize;
+		Vector2i		baseSize;
+	};
+
+	// Most recently uploaded first
+	std::mutex		sResumeLock;
+	std::list<ResumeEntry>	sResumeEntries;
+	std::unordered_map<std::string, std::list<ResumeEntry>::iterator> sResumeLookup;
+	size_t			sResumeSize = 0;
+}
+
 TextureData::TextureData(bool tile, bool linear) : mTile(tile), mLinear(linear), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
 									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f),
 									  mPackedSize(Vector2i(0, 0)), mBaseSize(Vector2i(0, 0))
 {
 	mIsExternalDataRGBA = false;
+	mMemUsage = 0;
+	mExpectedMemUsage = 0;
 }
 
 TextureData::~TextureData()
@@ -124,6 +157,8 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 
 	mDataRGBA = dataRGBA;
 
+	updateMemUsage();
+
 	return true;
 }
 
@@ -138,9 +173,7 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 			return true;
 	}
 
-	MaxSizeInfo maxSize(Renderer::getScreenWidth(), Renderer::getScreenHeight(), false);
-	if (!mMaxSize.empty())
-		maxSize = mMaxSize;
+	MaxSizeInfo maxSize = getLoadMaxSize();
 
 	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32((const unsigned char*)(fileData), length, width, height, &maxSize, &mBaseSize, &mPackedSize);
 	if (imageRGBA == nullptr)
@@ -181,6 +214,8 @@ bool TextureData::initFromRGBA(unsigned char* dataRGBA, size_t width, size_t hei
 
 	mWidth = width;
 	mHeight = height;
+
+	updateMemUsage();
 	return true;
 }
 
@@ -200,11 +235,157 @@ bool TextureData::initFromExternalRGBA(unsigned char* dataRGBA, size_t width, si
 	if (mTextureID != 0)
 		Renderer::updateTexture(mTextureID, Renderer::Texture::RGBA, -1, -1, mWidth, mHeight, mDataRGBA);
 
+	updateMemUsage();
+
+	return true;
+}
+
+MaxSizeInfo TextureData::getLoadMaxSize()
+{
+	if (!mMaxSize.empty())
+		return mMaxSize;
+
+	return MaxSizeInfo(Renderer::getScreenWidth(), Renderer::getScreenHeight(), false);
+}
+
+// Downscaled images are read back decoded from the disk cache instead of being decoded & rescaled again
+bool TextureData::loadFromDiskCache(bool updateCache)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA || (mTextureID != 0))
+			return true;
+	}
+
+	MaxSizeInfo maxSize = getLoadMaxSize();
+
+	size_t width, height, fileSize;
+	Vector2i baseSize;
+
+	unsigned char* imageRGBA = ImageIO::loadFromDiskCache(mPath, &maxSize, width, height, &baseSize, &fileSize);
+	if (imageRGBA == nullptr)
+		return false;
+
+	mBaseSize = baseSize;
+	mPackedSize = Vector2i(width, height);
+	mSourceWidth = (float)width;
+	mSourceHeight = (float)height;
+	mScalable = false;
+
+	if (!initFromRGBA(imageRGBA, width, height, false))
+		return false;
+
+	if (updateCache)
+		ImageIO::updateImageCache(mPath, fileSize, mBaseSize.x(), mBaseSize.y());
+
+	return true;
+}
+
+std::string TextureData::getResumeKey()
+{
+	MaxSizeInfo maxSize = getLoadMaxSize();
+
+	std::string key = mPath + "|" + std::to_string((int)maxSize.x()) + "x" + std::to_string((int)maxSize.y()) + (maxSize.externalZoom() ? "z" : "");
+
+	// Same as the disk cache : a file replaced by the scraper must not come back from the cache
+	if (mPath[0] != ':')
+		key += "|" + std::to_string((long long)Utils::FileSystem::getFileModificationDate(mPath).getTime());
+
+	// Svg are rasterized at the requested size
+	if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
+		key += "|" + std::to_string((int)mSourceWidth) + "x" + std::to_string((int)mSourceHeight);
+
+	return key;
+}
+
+bool TextureData::loadFromResumeCache(const std::string& key)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA || (mTextureID != 0))
+			return true;
+	}
+
+	ResumeEntry entry;
+
+	{
+		std::unique_lock<std::mutex> lock(sResumeLock);
+
+		auto it = sResumeLookup.find(key);
+		if (it == sResumeLookup.cend())
+			return false;
+
+		// The pixels go back to the texture, they are cached again once it is uploaded
+		entry = *it->second;
+		sResumeSize -= entry.width * entry.height * 4;
+		sResumeEntries.erase(it->second);
+		sResumeLookup.erase(it);
+	}
+
+	mBaseSize = entry.baseSize;
+	mPackedSize = entry.packedSize;
+	mSourceWidth = entry.sourceWidth;
+	mSourceHeight = entry.sourceHeight;
+	mScalable = entry.scalable;
+
+	if (!initFromRGBA(entry.data, entry.width, entry.height, false))
+	{
+		delete[] entry.data;
+		return false;
+	}
+
 	return true;
 }
 
+void TextureData::saveToResumeCache()
+{
+	size_t budget = (size_t)Math::max(0, Settings::getInstance()->getInt("ResumeCacheSize")) * 1024 * 1024;
+	size_t size = mWidth * mHeight * 4;
+
+	if (mResumeKey.empty() || mIsExternalDataRGBA || size > budget)
+	{
+		delete[] mDataRGBA;
+		mDataRGBA = nullptr;
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(sResumeLock);
+
+	auto it = sResumeLookup.find(mResumeKey);
+	if (it != sResumeLookup.cend())
+	{
+		delete[] it->second->data;
+		sResumeSize -= it->second->width * it->second->height * 4;
+		sResumeEntries.erase(it->second);
+		sResumeLookup.erase(it);
+	}
+
+	sResumeEntries.push_front({ mResumeKey, mDataRGBA, mWidth, mHeight, mSourceWidth, mSourceHeight, mScalable, mPackedSize, mBaseSize });
+	sResumeLookup[mResumeKey] = sResumeEntries.begin();
+	sResumeSize += size;
+
+	mDataRGBA = nullptr;
+
+	while (sResumeSize > budget && !sResumeEntries.empty())
+	{
+		ResumeEntry& last = sResumeEntries.back();
+		sResumeSize -= last.width * last.height * 4;
+		delete[] last.data;
+		sResumeLookup.erase(last.key);
+		sResumeEntries.pop_back();
+	}
+}
+
+size_t TextureData::getResumeCacheSize()
+{
+	std::unique_lock<std::mutex> lock(sResumeLock);
+	return sResumeSize;
+}
+
 bool TextureData::load(bool updateCache)
 {
+	PROFILE_ZONE("TextureData::load");
+
 	bool retval = false;
 
 	// Need to load. See if there is a file
@@ -212,17 +393,68 @@ bool TextureData::load(bool updateCache)
 	{
 		LOG(LogDebug) << "TextureData::load " << mPath;
 
+		if (std::this_thread::get_id() == sUiThreadId)
+			sUiThreadLoads++;
+
+		// Read under the lock by saveToResumeCache, from the UI thread
+		std::string resumeKey = getResumeKey();
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mResumeKey = resumeKey;
+		}
+
+		if (loadFromResumeCache(resumeKey))
+			return true;
+
+		bool isSvg = mPath.substr(mPath.size() - 4, std::string::npos) == ".svg";
+		if (!isSvg && loadFromDiskCache(updateCache))
+			return true;
+
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 		const ResourceData& data = rm->getFileData(mPath);
 		// is it an SVG?
-		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
+		if (isSvg)
 		{
 			mScalable = true;
 			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
+
+			// The first rasterization reads the source size from the file : key the pixels by the size the next load will ask for
+			if (retval)
+			{
+				resumeKey = getResumeKey();
+
+				std::unique_lock<std::mutex> lock(mMutex);
+				mResumeKey = resumeKey;
+			}
 		}
 		else
+		{
 			retval = initImageFromMemory((const unsigned char*)data.ptr.get(), data.length);
 
+			// Only images which had to be rescaled are worth caching
+			if (retval && mPackedSize != Vector2i(0, 0))
+			{
+				MaxSizeInfo maxSize = getLoadMaxSize();
+
+				// The texture may be uploaded & its pixels released meanwhile : copy them, the file is written without the lock
+				std::vector<unsigned char> pixels;
+				size_t width = 0, height = 0;
+
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					if (mDataRGBA != nullptr)
+					{
+						width = mWidth;
+						height = mHeight;
+						pixels.assign(mDataRGBA, mDataRGBA + width * height * 4);
+					}
+				}
+
+				if (pixels.size() > 0)
+					ImageIO::saveToDiskCache(mPath, &maxSize, &pixels[0], width, height, mBaseSize);
+			}
+		}
+
 		if (updateCache && retval)
 			ImageIO::updateImageCache(mPath, data.length, mBaseSize.x(), mBaseSize.y());
 	}
@@ -262,11 +494,14 @@ bool TextureData::uploadAndBind()
 		if (mTextureID)
 		{
 			if (mDataRGBA != nullptr && !mIsExternalDataRGBA)
-				delete[] mDataRGBA;
+				saveToResumeCache();
 
 			mDataRGBA = nullptr;
 		}
+
+		updateMemUsage();
 	}
+
 	return true;
 }
 
@@ -277,6 +512,7 @@ void TextureData::releaseVRAM()
 	{
 		Renderer::destroyTexture(mTextureID);
 		mTextureID = 0;
+		updateMemUsage();
 	}
 }
 
@@ -288,36 +524,71 @@ void TextureData::releaseRAM()
 		delete[] mDataRGBA;
 
 	mDataRGBA = 0;
+	updateMemUsage();
+}
+
+// Reads the size from the file header : the pixels stay pending until the TextureLoader decodes them
+bool TextureData::probeSize()
+{
+	if (mPath.empty())
+		return false;
+
+	std::string path = ResourceManager::getInstance()->getResourcePath(mPath);
+
+	unsigned int width, height;
+	if (!ImageIO::loadImageSize(path.c_str(), &width, &height) || width == 0 || height == 0)
+		return false;
+
+	// SVGs are rasterized at the source size : let rasterizeAt change it before the load
+	if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
+		mScalable = true;
+
+	setTemporarySize(width, height);
+	mExpectedMemUsage = (size_t)width * height * 4;
+	return true;
 }
 
 size_t TextureData::width()
 {
-	if (mWidth == 0)
+	if (mWidth == 0 && !probeSize())
 		load();
 	return mWidth;
 }
 
 size_t TextureData::height()
 {
-	if (mHeight == 0)
+	if (mHeight == 0 && !probeSize())
 		load();
 	return mHeight;
 }
 
 float TextureData::sourceWidth()
 {
-	if (mSourceWidth == 0)
+	if (mSourceWidth == 0 && !probeSize())
 		load();
 	return mSourceWidth;
 }
 
 float TextureData::sourceHeight()
 {
-	if (mSourceHeight == 0)
+	if (mSourceHeight == 0 && !probeSize())
 		load();
 	return mSourceHeight;
 }
 
+void TextureData::setUiThread()
+{
+	sUiThreadId = std::this_thread::get_id();
+}
+
+int TextureData::getUiThreadLoads(bool reset)
+{
+	if (reset)
+		return sUiThreadLoads.exchange(0);
+
+	return sUiThreadLoads;
+}
+
 void TextureData::setTemporarySize(float width, float height)
 {
 	mWidth = width;
@@ -340,6 +611,26 @@ void TextureData::setSourceSize(float width, float height)
 	}
 }
 
+// Keeps sTotalMemUsage up to date : to call with mMutex held, each time mTextureID, mDataRGBA or the size change
+void TextureData::updateMemUsage()
+{
+	size_t size = ((mTextureID != 0) || (mDataRGBA != nullptr)) ? mWidth * mHeight * 4 : 0;
+	if (size != 0)
+		mExpectedMemUsage = size;
+
+	if (size == mMemUsage)
+		return;
+
+	sTotalMemUsage += size;
+	sTotalMemUsage -= mMemUsage;
+	mMemUsage = size;
+}
+
+size_t TextureData::getTotalMemUsage()
+{
+	return sTotalMemUsage;
+}
+
 size_t TextureData::getVRAMUsage()
 {
 	if ((mTextureID != 0) || (mDataRGBA != nullptr))
@@ -2,8 +2,10 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include <atomic>
 #include <mutex>
 #include <string>
+#include <thread>
 #include "ImageIO.h"
 
 class TextureResource;
@@ -40,6 +42,12 @@ public:
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
 
+	// Get the amount of VRAM used by all the textures, updated as they are loaded and released
+	static size_t getTotalMemUsage();
+
+	// Memory the pixels use once decoded, from the size read by probeSize or the last load ( 0 if none ). Never reads the file
+	size_t getExpectedMemUsage() { return mExpectedMemUsage; }
+
 	size_t width();
 	size_t height();
 	float sourceWidth();
@@ -57,11 +65,31 @@ public:
 
 	void setTemporarySize(float width, float height);
 
+	// Sets the size from the file header, without decoding the pixels. False if the header can't be read
+	bool probeSize();
+
 	inline const std::string& getPath() { return mPath; };
 
 	bool initFromExternalRGBA(unsigned char* dataRGBA, size_t width, size_t height);
 
+	// Counts the textures decoded synchronously by the UI thread, which should be loaded by the TextureLoader instead
+	static void setUiThread();
+	static int getUiThreadLoads(bool reset = false);
+
+	// Decoded pixels kept in RAM after the upload, so that unloaded textures ( game launch, VRAM pressure ) come back
+	// without decoding the files again. Budget is the "ResumeCacheSize" setting ( MB, 0 = disabled, the default ).
+	// The pixels can't be read back from GLES1 at deinit : the cache is filled at upload, and stays for the whole run,
+	// games included
+	static size_t getResumeCacheSize();
+
 private:
+	void updateMemUsage();
+	MaxSizeInfo getLoadMaxSize();
+	bool loadFromDiskCache(bool updateCache);
+	std::string getResumeKey();
+	bool loadFromResumeCache(const std::string& key);
+	void saveToResumeCache(); // takes mDataRGBA, mMutex must be locked
+
 	std::mutex		mMutex;
 	bool			mTile;
 	bool			mLinear;
@@ -80,6 +108,13 @@ private:
 	Vector2i		mBaseSize;
 
 	bool			mIsExternalDataRGBA;
+	size_t			mMemUsage; // Part of sTotalMemUsage accounted for this texture
+	std::atomic<size_t>	mExpectedMemUsage;
+	std::string		mResumeKey; // Set by load, the size & source size may change while decoding
+
+	static std::atomic<size_t>	sTotalMemUsage;
+	static std::thread::id	sUiThreadId;
+	static std::atomic<int>	sUiThreadLoads;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
@@ -4,6 +4,7 @@
 #include "resources/TextureResource.h"
 #include "Settings.h"
 #include "Log.h"
+#include "Window.h"
 #include <algorithm>
 
 TextureDataManager::TextureDataManager()
@@ -86,7 +87,7 @@ void TextureDataManager::cancelAsync(const TextureResource* key)
 		mLoader->remove(*(*it).second);
 }
 
-std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, bool enableLoading)
+std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, bool enableLoading, int priority)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 	
@@ -101,30 +102,40 @@ std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key,
 		if (!enableLoading)
 			return tex;
 
+		// Put it at the top, the lookup iterator stays valid
 		if (mTextures.cbegin() != (*it).second)
-		{
-			// Remove the list entry
-			mTextures.erase((*it).second);
-			// Put it at the top
-			mTextures.push_front(tex);
-			// Store it back in the lookup
-			mTextureLookup[key] = mTextures.cbegin();
-		}
+			mTextures.splice(mTextures.begin(), mTextures, (*it).second);
 
 		// Make sure it's loaded or queued for loading
 		if (enableLoading && !tex->isLoaded())
 		{
 			lock.unlock();
-			load(tex);
+			load(tex, false, priority);
 		}
 	}
 
 	return tex;
 }
 
+void TextureDataManager::setLoadPriority(const TextureResource* key, int priority)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	auto it = mTextureLookup.find(key);
+	if (it != mTextureLookup.cend())
+		mLoader->setPriority(*(*it).second, priority);
+}
+
+void TextureDataManager::cancelAllAsync()
+{
+	if (mLoader != nullptr)
+		mLoader->cancelAll();
+}
+
 bool TextureDataManager::bind(const TextureResource* key)
 {
-	std::shared_ptr<TextureData> tex = get(key);
+	// Drawn now : loaded before anything else
+	std::shared_ptr<TextureData> tex = get(key, true, TEXTURE_PRIORITY_VISIBLE);
 	bool bound = false;
 	if (tex != nullptr)
 		bound = tex->uploadAndBind();
@@ -144,33 +155,12 @@ size_t TextureDataManager::getTotalSize()
 	return total;
 }
 
-size_t TextureDataManager::getCommittedSize()
-{
-	std::unique_lock<std::mutex> lock(mMutex);
-
-	size_t total = 0;
-	for (auto tex : mTextures)
-		total += tex->getVRAMUsage();
-
-	return total;
-}
-
 size_t TextureDataManager::getQueueSize()
 {
 	return mLoader->getQueueSize();
 }
 
-bool compareTextures(const std::shared_ptr<TextureData>& first, const std::shared_ptr<TextureData>& second)
-{
-	bool isResource = first->getPath().rfind(":/") == 0;
-	bool secondIsResource = second->getPath().rfind(":/") == 0;
-	if (isResource && !secondIsResource)
-		return true;
-
-	return false;
-}
-
-void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
+void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block, int priority)
 {
 	// See if it's already loaded
 	if (tex->isLoaded())
@@ -195,48 +185,50 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 
 		std::unique_lock<std::mutex> lock(mMutex);
 
-		std::list<std::shared_ptr<TextureData>> orderedTextures(mTextures);
-		orderedTextures.sort(compareTextures);
-
-		for (auto it = orderedTextures.crbegin(); it != orderedTextures.crend(); ++it)
+		// Least recently used textures first, the ones from resources ( ":/" ) only if it's still not enough
+		for (int pass = 0; pass < 2 && size >= max_texture; pass++)
 		{
-			if (size < max_texture)
-				break;
+			for (auto it = mTextures.crbegin(); it != mTextures.crend(); ++it)
+			{
+				if (size < max_texture)
+					break;
 
-			if ((*it) == tex)
-				continue;
+				if ((*it) == tex)
+					continue;
 
-			bool changed = false;
+				bool isResource = (*it)->getPath().compare(0, 2, ":/") == 0;
+				if (isResource != (pass == 1))
+					continue;
 
-			if ((*it)->isLoaded())
-			{
-				LOG(LogDebug) << "Cleanup VRAM\tReleased : " << (*it)->getPath().c_str();
+				bool changed = false;
 
-				(*it)->releaseVRAM();
-				(*it)->releaseRAM();
+				if ((*it)->isLoaded())
+				{
+					LOG(LogDebug) << "Cleanup VRAM\tReleased : " << (*it)->getPath().c_str();
 
-				changed = true;
-			}
+					(*it)->releaseVRAM();
+					(*it)->releaseRAM();
 
-			// It may be already in the loader queue. In this case it wouldn't have been using
-			// any VRAM yet but it will be. Remove it from the loader queue
-			if (mLoader->remove(*it))
-			{
-				LOG(LogDebug) << "Cleanup VRAM\tRemoved from queue : " << (*it)->getPath().c_str();
-				changed = true;
-			}
+					changed = true;
+				}
 
-			if (changed)
-			{
-				lock.unlock();
-				size = TextureResource::getTotalMemUsage();
-				lock.lock();
+				// It may be already in the loader queue. In this case it wouldn't have been using
+				// any VRAM yet but it will be. Remove it from the loader queue
+				if (mLoader->remove(*it))
+				{
+					LOG(LogDebug) << "Cleanup VRAM\tRemoved from queue : " << (*it)->getPath().c_str();
+					changed = true;
+				}
+
+				// Running counters : no need to walk the textures again
+				if (changed)
+					size = TextureResource::getTotalMemUsage();
 			}
 		}
 	}
 
 	if (!block)
-		mLoader->load(tex);
+		mLoader->load(tex, priority);
 	else
 	{
 		mLoader->remove(tex);
@@ -244,14 +236,11 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 }
 
-TextureLoader::TextureLoader(TextureDataManager* mgr) : mManager(mgr), mExit(false)
+TextureLoader::TextureLoader(TextureDataManager* mgr) : mManager(mgr), mExit(false), mRunningTasks(0), mQueueSize(0), mRequestOrder(0), mGeneration(0)
 {
-	int num_threads = std::thread::hardware_concurrency() / 2;
-	if (num_threads == 0)
-		num_threads = 1;
-
-	for (size_t i = 0; i < num_threads; i++)
-		mThreads.push_back(std::thread(&TextureLoader::threadProc, this));
+	mMaxTasks = std::thread::hardware_concurrency() / 2;
+	if (mMaxTasks == 0)
+		mMaxTasks = 1;
 }
 
 TextureLoader::~TextureLoader()
@@ -259,54 +248,63 @@ TextureLoader::~TextureLoader()
 	// Just abort any waiting texture
 	clearQueue();
 
-	// Exit the thread
-	mExit = true;
-	mEvent.notify_all();
+	// Wait for the textures being loaded
+	{
+		std::unique_lock<std::mutex> lock(mLoaderLock);
+		mExit = true;
+	}
 
-	for (std::thread& t : mThreads)
-		t.join();
+	mTasks.wait();
 }
 
-void TextureLoader::threadProc()
+void TextureLoader::processQueue()
 {
-	while (true)
-	{		
-		// Wait for an event to say there is something in the queue
-		std::unique_lock<std::mutex> lock(mLoaderLock);
-		mEvent.wait(lock, [this]() { return mExit || !mTextureDataQ.empty(); });
+	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-		if (mExit)
-			break;
+	while (!mExit && !mTextureDataQ.empty())
+	{
+		// Highest priority first
+		auto front = mTextureDataQ.begin();
+		std::shared_ptr<TextureData> textureData = front->second.texture;
+		bool cancelled = (front->second.generation != mGeneration);
 
-		if (!mTextureDataQ.empty())
-		{
-			std::shared_ptr<TextureData> textureData = mTextureDataQ.front();
-			mTextureDataQ.pop_front();
+		if (!cancelled)
+			mQueueSize -= front->second.size;
 
-			mProcessingTextureDataQ.push_back(textureData);
+		mTextureDataQLookup.erase(textureData.get());
+		mTextureDataQ.erase(front);
 
-			lock.unlock();
+		// Cancelled by cancelAll, and not requested since
+		if (cancelled)
+			continue;
 
-			if (textureData && !textureData->isLoaded())
-			{
-				//LOG(LogDebug) << "TextureLoader::Thread\tLoading " << textureData->getPath().c_str();
-				std::this_thread::yield();
+		mProcessingTextureData.insert(textureData.get());
 
-				textureData->load(true);
-				//mManager->onTextureLoaded(textureData);				
+		lock.unlock();
 
-				lock.lock();
-				mProcessingTextureDataQ.remove(textureData);			
-				lock.unlock();
-			}
+		if (textureData && !textureData->isLoaded())
+		{
+			//LOG(LogDebug) << "TextureLoader::Thread\tLoading " << textureData->getPath().c_str();
+			textureData->load(true);
+			//mManager->onTextureLoaded(textureData);				
 
-			std::this_thread::yield();
-		}		
+			// The image appears on the next frame
+			Window::invalidate();
+		}
+
+		lock.lock();
+		mProcessingTextureData.erase(textureData.get());
 	}
+
+	// Checked under the lock : load() starts a new task if this one is leaving
+	mRunningTasks--;
 }
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, int priority)
 {
+	// Size known without reading the file : this runs on the UI thread
+	size_t size = textureData->getExpectedMemUsage();
+
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Make sure it's not already loaded
@@ -314,17 +312,45 @@ void TextureLoader::load(std::shared_ptr<TextureData> textureData)
 		return;
 
 	// If is is currently loading, don't add again
-	if (std::find(mProcessingTextureDataQ.cbegin(), mProcessingTextureDataQ.cend(), textureData) != mProcessingTextureDataQ.cend())
+	if (mProcessingTextureData.find(textureData.get()) != mProcessingTextureData.cend())
 		return;
 
-	// Remove it from the queue if it is already there
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-		mTextureDataQ.erase(tx);
+	auto tx = mTextureDataQLookup.find(textureData.get());
+	if (tx != mTextureDataQLookup.cend())
+	{
+		QueuedTexture item = tx->second->second;
+
+		// Requested again at the same priority ( drawn on each frame ) : it keeps its place
+		if (item.generation == mGeneration && tx->second->first.first == priority)
+			return;
+
+		// Cancelled, then requested again : counted again
+		if (item.generation != mGeneration)
+		{
+			item.generation = mGeneration;
+			mQueueSize += item.size;
+		}
 
-	// Put it on the start of the queue as we want the newly requested textures to load first
-	mTextureDataQ.push_front(textureData);
-	mEvent.notify_one();
+		mTextureDataQ.erase(tx->second);
+		tx->second = mTextureDataQ.insert(std::make_pair(QueueKey(priority, --mRequestOrder), item)).first;
+	}
+	else
+	{
+		QueuedTexture item;
+		item.texture = textureData;
+		item.size = size;
+		item.generation = mGeneration;
+
+		// Within a priority, the newly requested textures load first
+		mTextureDataQLookup[textureData.get()] = mTextureDataQ.insert(std::make_pair(QueueKey(priority, --mRequestOrder), item)).first;
+		mQueueSize += item.size;
+	}
+
+	if (!mExit && mRunningTasks < mMaxTasks)
+	{
+		mRunningTasks++;
+		mTasks.run([this] { processQueue(); });
+	}
 }
 
 bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
@@ -332,27 +358,53 @@ bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
+	auto tx = mTextureDataQLookup.find(textureData.get());
+	if (tx != mTextureDataQLookup.cend())
 	{
-		mTextureDataQ.erase(tx);
-		return true;
+		bool cancelled = (tx->second->second.generation != mGeneration);
+		if (!cancelled)
+			mQueueSize -= tx->second->second.size;
+
+		mTextureDataQ.erase(tx->second);
+		mTextureDataQLookup.erase(tx);
+		return !cancelled;
 	}
 
 	return false;
 }
 
+void TextureLoader::setPriority(std::shared_ptr<TextureData> textureData, int priority)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	// Only for the textures waiting in the queue : the cancelled ones stay cancelled
+	auto tx = mTextureDataQLookup.find(textureData.get());
+	if (tx == mTextureDataQLookup.cend() || tx->second->second.generation != mGeneration || tx->second->first.first == priority)
+		return;
+
+	QueueKey key(priority, tx->second->first.second);
+	QueuedTexture item = tx->second->second;
+
+	mTextureDataQ.erase(tx->second);
+	tx->second = mTextureDataQ.insert(std::make_pair(key, item)).first;
+}
+
+void TextureLoader::cancelAll()
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	// The queued textures are now from an older generation
+	mGeneration++;
+	mQueueSize = 0;
+}
+
 size_t TextureLoader::getQueueSize()
 {
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Gets the amount of video memory that will be used once all textures in
 	// the queue are loaded
-	size_t mem = 0;
-	for (auto tex : mTextureDataQ)
-		mem += tex->width() * tex->height() * 4;
-
-	return mem;
+	return mQueueSize;
 }
 
 void TextureLoader::clearQueue()
@@ -361,6 +413,8 @@ void TextureLoader::clearQueue()
 
 	// Just abort any waiting texture
 	mTextureDataQ.clear();	
+	mTextureDataQLookup.clear();
+	mQueueSize = 0;
 }
 
 void TextureDataManager::clearQueue()
@@ -8,7 +8,15 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#include "utils/ThreadPool.h"
+
+// Load priorities, lower first : the textures drawn on screen, then the ones requested by the components.
+// The grid adds the distance of its tiles from the cursor, in rows
+#define TEXTURE_PRIORITY_VISIBLE	0
+#define TEXTURE_PRIORITY_REQUESTED	1
 
 class TextureDataManager;
 class TextureData;
@@ -20,21 +28,43 @@ public:
 	TextureLoader(TextureDataManager* mgr);
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
+	void load(std::shared_ptr<TextureData> textureData, int priority = TEXTURE_PRIORITY_REQUESTED);
 	bool remove(std::shared_ptr<TextureData> textureData);
+	void setPriority(std::shared_ptr<TextureData> textureData, int priority);
 	void clearQueue();
 
+	// Cancels every queued texture, without walking the queue : they are dropped when they come out of it,
+	// unless they are requested again meanwhile ( drawn on screen )
+	void cancelAll();
+
 	size_t getQueueSize();
 
 private:	
-	void threadProc();
-
-	std::list<std::shared_ptr<TextureData>> 										mProcessingTextureDataQ;
-	std::list<std::shared_ptr<TextureData>> 										mTextureDataQ;
-
-	std::vector<std::thread>	mThreads;
+	void processQueue();
+
+	struct QueuedTexture
+	{
+		std::shared_ptr<TextureData> texture;
+		size_t size; // Memory the texture will use once loaded, as counted in mQueueSize
+		unsigned int generation; // mGeneration when it was requested, cancelled when it's older
+	};
+
+	// Priority, then request order : the most recent first
+	typedef std::pair<int, unsigned long long> QueueKey;
+	typedef std::map<QueueKey, QueuedTexture> Queue;
+
+	Queue																						mTextureDataQ;
+	std::unordered_map<TextureData*, Queue::iterator>									mTextureDataQLookup;
+	std::unordered_set<TextureData*>													mProcessingTextureData;
+	size_t																				mQueueSize; // of the textures of the current generation
+	unsigned long long																	mRequestOrder; // decremented by each request
+	unsigned int																		mGeneration;
+
+	// Textures are loaded by tasks of the shared ThreadPool, at most mMaxTasks at a time
+	Utils::TaskGroup			mTasks;
+	int							mRunningTasks;
+	int							mMaxTasks;
 	std::mutex					mLoaderLock;
-	std::condition_variable		mEvent;
 	bool 						mExit;
 
 	TextureDataManager*			mManager;
@@ -68,19 +98,19 @@ public:
 	void remove(const TextureResource* key);
 
 	void cancelAsync(const TextureResource* key);
-	std::shared_ptr<TextureData> get(const TextureResource* key, bool enableLoading = true);
+	std::shared_ptr<TextureData> get(const TextureResource* key, bool enableLoading = true, int priority = TEXTURE_PRIORITY_REQUESTED);
 	bool bind(const TextureResource* key);
 
 	// Get the total size of all textures managed by this object, loaded and unloaded in bytes
 	size_t	getTotalSize();
-	// Get the total size of all committed textures (in VRAM) in bytes
-	size_t	getCommittedSize();
 	// Get the total size of all load-pending textures in the queue - these will
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
 	// Load a texture, freeing resources as necessary to make space
-	void load(std::shared_ptr<TextureData> tex, bool block = false);
+	void load(std::shared_ptr<TextureData> tex, bool block = false, int priority = TEXTURE_PRIORITY_REQUESTED);
 
+	void setLoadPriority(const TextureResource* key, int priority);
+	void cancelAllAsync();
 	void clearQueue();
 
 	void onTextureLoaded(std::shared_ptr<TextureData> tex);
@@ -88,8 +118,9 @@ public:
 private:
 	std::mutex					mMutex;
 
+	// Most recently used first
 	std::list<std::shared_ptr<TextureData> >												mTextures;
-	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
+	std::unordered_map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
 	std::shared_ptr<TextureData>															mBlank;
 	TextureLoader*																			mLoader;
 };
@@ -27,32 +27,11 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool linear
 
 			data->initFromPath(path);
 
-			bool async = false;
-
-			std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
-			auto fullpath = rm->getResourcePath(path);
-
-			unsigned int width, height;
-
-			if (allowAsync && Settings::getInstance()->getBool("AsyncImages") && ImageIO::loadImageSize(fullpath.c_str(), &width, &height))
-			{
-				data->setTemporarySize(width, height);
-				async = true;
-			}
+			// The size is read from the file header, svgs are flagged scalable so that rasterizeAt still applies
+			bool async = allowAsync && Settings::getInstance()->getBool("AsyncImages") && data->probeSize();
 
 			// Force the texture manager to load it using a blocking load
 			sTextureDataManager.load(data, !async); // 
-
-			if (async)
-			{
-				mSize = Vector2i(width, height);
-				mSourceSize = Vector2f(width, height);
-			}
-			else
-			{
-				mSize = Vector2i((int)data->width(), (int)data->height());
-				mSourceSize = Vector2f(data->sourceWidth(), data->sourceHeight());
-			}
 		}
 		else
 		{
@@ -173,6 +152,23 @@ void TextureResource::cancelAsync(std::shared_ptr<TextureResource> texture)
 		sTextureDataManager.cancelAsync(texture.get());
 }
 
+void TextureResource::cancelAllAsync()
+{
+	sTextureDataManager.cancelAllAsync();
+}
+
+void TextureResource::setLoadPriority(std::shared_ptr<TextureResource> texture, int priority)
+{
+	if (texture != nullptr && texture->mTextureData == nullptr)
+		sTextureDataManager.setLoadPriority(texture.get(), priority);
+}
+
+void TextureResource::loadAsync()
+{
+	if (mTextureData == nullptr)
+		sTextureDataManager.get(this, true, TEXTURE_PRIORITY_VISIBLE);
+}
+
 std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool tile, bool linear, bool forceLoad, bool dynamic, bool asReloadable, MaxSizeInfo* maxSize)
 {
 	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
@@ -295,15 +291,8 @@ bool TextureResource::isLoaded() const
 
 size_t TextureResource::getTotalMemUsage()
 {
-	size_t total = 0;
-	// Count up all textures that manage their own texture data
-	for (auto tex : sAllTextures)
-	{
-		if (tex->mTextureData != nullptr)
-			total += tex->mTextureData->getVRAMUsage();
-	}
-	// Now get the committed memory from the manager
-	total += sTextureDataManager.getCommittedSize();
+	// All the textures, managed by the manager or by their TextureResource
+	size_t total = TextureData::getTotalMemUsage();
 	// And the size of the loading queue
 	total += sTextureDataManager.getQueueSize();
 	return total;
@@ -356,4 +345,9 @@ void TextureResource::reload()
 void TextureResource::clearQueue()
 {
 	sTextureDataManager.clearQueue();
-}
\ No newline at end of file
+}
+
+size_t TextureResource::getQueueSize()
+{
+	return sTextureDataManager.getQueueSize();
+}
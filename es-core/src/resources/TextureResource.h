@@ -20,6 +20,8 @@ public:
 
 public:
 	static void cancelAsync(std::shared_ptr<TextureResource> texture);
+	static void cancelAllAsync(); // when the view changes : what is still on screen is requested again by loadAsync
+	static void setLoadPriority(std::shared_ptr<TextureResource> texture, int priority);
 	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool linear = false, bool forceLoad = false, bool dynamic = true, bool asReloadable = true, MaxSizeInfo* maxSize = nullptr);
 	void initFromPixels(unsigned char* dataRGBA, size_t width, size_t height);
 	void initFromExternalPixels(unsigned char* dataRGBA, size_t width, size_t height);
@@ -36,6 +38,7 @@ public:
 
 	const Vector2i getSize() const;
 	bool bind();
+	void loadAsync(); // queues the texture as visible, if it's not loaded
 
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by textures (in bytes)
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
@@ -46,6 +49,7 @@ public:
 	void onTextureLoaded(std::shared_ptr<TextureData> tex);
 
 	static void clearQueue();
+	static size_t getQueueSize(); // bytes of the textures waiting to be loaded
 
 private:
 	// mTextureData is used for textures that are not loaded from a file - these ones
@@ -1096,6 +1096,18 @@ namespace Utils
 			return Utils::Time::DateTime();
 		}
 
+		Utils::Time::DateTime getFileModificationDate(const std::string& _path)
+		{
+			std::string path = getGenericPath(_path);
+			struct stat64 info;
+
+			// check if stat64 succeeded
+			if ((stat64(path.c_str(), &info) == 0))
+				return Utils::Time::DateTime(info.st_mtime);
+
+			return Utils::Time::DateTime();
+		}
+
 		std::string	readAllText(const std::string fileName)
 		{
 			std::ifstream t(fileName);
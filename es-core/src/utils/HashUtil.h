@@ -0,0 +1,19 @@
+#pragma once
+#ifndef ES_CORE_UTILS_HASH_UTIL_H
+#define ES_CORE_UTILS_HASH_UTIL_H
+
+#include <stddef.h>
+#include <string>
+
+namespace Utils
+{
+	namespace Hash
+	{
+		// Standard CRC-32 ( zlib / zip ). Pass the previous result as crc to hash data in several parts
+		unsigned int crc32(const void* _data, size_t _size, unsigned int _crc = 0);
+
+	} // Hash::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_HASH_UTIL_H
@@ -1,93 +1,318 @@
 #include "ThreadPool.h"
-
-#if WIN32
-#include <Windows.h>
-#endif
+#include "Settings.h"
+#include <algorithm>
 
 namespace Utils
 {
-	ThreadPool::ThreadPool() : mRunning(true), mWaiting(false), mNumWork(0)
+	// Identifies the pool & the queue of the worker running on the current thread
+	static thread_local ThreadPool* sWorkerPool = nullptr;
+	static thread_local int sWorkerId = -1;
+
+	ThreadPool* ThreadPool::sInstance = nullptr;
+	bool ThreadPool::sStopped = false;
+	std::mutex ThreadPool::sInstanceLock;
+
+	ThreadPool* ThreadPool::getInstance()
+	{
+		std::unique_lock<std::mutex> lock(sInstanceLock);
+
+		if (sInstance == nullptr && !sStopped)
+			sInstance = new ThreadPool(Settings::getInstance()->getInt("ThreadPoolSize"));
+
+		return sInstance;
+	}
+
+	void ThreadPool::deinit()
+	{
+		ThreadPool* pool;
+
+		{
+			std::unique_lock<std::mutex> lock(sInstanceLock);
+			pool = sInstance;
+			sStopped = true;
+		}
+
+		// Not under the lock : the tasks still queued can queue others to the shared pool while it stops
+		delete pool;
+
+		std::unique_lock<std::mutex> lock(sInstanceLock);
+		sInstance = nullptr;
+	}
+
+	ThreadPool::ThreadPool(int threadCount) : mRunning(true), mQueued(0), mNextQueue(0)
 	{
-		size_t num_threads = std::thread::hardware_concurrency() * 2;
+		if (threadCount <= 0)
+			threadCount = std::thread::hardware_concurrency();
+
+		if (threadCount <= 0)
+			threadCount = 1;
+
+		mDefaultGroup = new TaskGroup(this);
+
+		for (int i = 0; i < threadCount; i++)
+			mQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
 
-		auto doWork = [&](size_t id)
+		mThreads.reserve(threadCount);
+
+		for (int i = 0; i < threadCount; i++)
+			mThreads.push_back(std::thread(&ThreadPool::run, this, i));
+	}
+
+	ThreadPool::~ThreadPool()
+	{
 		{
-#if WIN32
-			auto mask = (static_cast<DWORD_PTR>(1) << id);
-			SetThreadAffinityMask(GetCurrentThread(), mask);
-#endif
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mRunning = false;
+		}
+
+		mIdleEvent.notify_all();
+
+		for (std::thread& t : mThreads)
+			if (t.joinable())
+				t.join();
 
-			while (mRunning)
+		delete mDefaultGroup;
+	}
+
+	void ThreadPool::run(int id)
+	{
+		sWorkerPool = this;
+		sWorkerId = id;
+
+		WorkItem item;
+
+		while (true)
+		{
+			if (pop(id, item))
 			{
-				_mutex.lock();
-				if (!mWorkQueue.empty())
-				{
-					auto work = mWorkQueue.front();
-					mWorkQueue.pop();
-					_mutex.unlock();
+				execute(item);
+				item = WorkItem();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mIdleEvent.wait(lock, [this] { return !mRunning || mQueued > 0; });
+
+			// Stopping : the tasks still queued are run first, their groups are waiting for them
+			if (!mRunning && mQueued == 0)
+				return;
+		}
+	}
+
+	void ThreadPool::push(const WorkItem& item)
+	{
+		// Tasks queued by a worker go to its own queue, others are spread over all the queues
+		int id = sWorkerPool == this ? sWorkerId : (int)(mNextQueue++ % mQueues.size());
+
+		{
+			std::unique_lock<std::mutex> lock(mQueues[id]->lock);
+			mQueues[id]->items.push_back(item);
+		}
+
+		if (item.group != nullptr)
+		{
+			std::unique_lock<std::mutex> lock(item.group->mLock);
+			item.group->mQueued++;
+			item.group->mEvent.notify_all();
+		}
 
-					try
-					{
-						work();
-					}
-					catch (...) {}
+		{
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mQueued++;
+		}
 
-					mNumWork--;
+		mIdleEvent.notify_one();
+	}
+
+	bool ThreadPool::pop(int id, WorkItem& item, TaskGroup* group)
+	{
+		bool found = false;
+
+		if (group == nullptr)
+		{
+			// Own queue first, most recent task first
+			if (id >= 0)
+			{
+				std::unique_lock<std::mutex> lock(mQueues[id]->lock);
+
+				auto& items = mQueues[id]->items;
+				if (!items.empty())
+				{
+					item = items.back();
+					items.pop_back();
+					found = true;
 				}
-				else
+			}
+
+			// Steal the oldest task of another worker
+			for (size_t i = 1; !found && i <= mQueues.size(); i++)
+			{
+				int victim = (int)((id + i) % mQueues.size());
+				if (victim == id)
+					continue;
+
+				std::unique_lock<std::mutex> lock(mQueues[victim]->lock);
+
+				auto& items = mQueues[victim]->items;
+				if (!items.empty())
 				{
-					_mutex.unlock();
+					item = items.front();
+					items.pop_front();
+					found = true;
+				}
+			}
+		}
+		else
+		{
+			// A thread waiting for a group only runs tasks of this group
+			for (size_t i = 0; !found && i < mQueues.size(); i++)
+			{
+				int victim = (int)((std::max(id, 0) + i) % mQueues.size());
 
-					// Extra code : Exit finished threads
-					if (mWaiting)
-						return;
+				std::unique_lock<std::mutex> lock(mQueues[victim]->lock);
+
+				auto& items = mQueues[victim]->items;
+				for (auto it = items.rbegin(); it != items.rend(); ++it)
+				{
+					if (it->group != group)
+						continue;
 
-					std::this_thread::yield();
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					item = *it;
+					items.erase(std::next(it).base());
+					found = true;
+					break;
 				}
 			}
-		};
+		}
+
+		if (!found)
+			return false;
+
+		{
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mQueued--;
+		}
 
-		mThreads.reserve(num_threads);
+		if (item.group != nullptr)
+		{
+			std::unique_lock<std::mutex> lock(item.group->mLock);
+			item.group->mQueued--;
+		}
 
-		for (size_t i = 0; i < num_threads; i++)
-			mThreads.push_back(std::thread(doWork, i));
+		return true;
 	}
 
-	ThreadPool::~ThreadPool()
+	void ThreadPool::execute(WorkItem& item)
 	{
-		mRunning = false;
+		try
+		{
+			item.work();
+		}
+		catch (...) {}
 
-		for (std::thread& t : mThreads)
-			if (t.joinable())
-				t.join();
+		if (item.group != nullptr)
+			item.group->onTaskDone();
 	}
 
 	void ThreadPool::queueWorkItem(work_function work)
 	{
-		_mutex.lock();
-		mWorkQueue.push(work);
-		mNumWork++;
-		_mutex.unlock();
+		mDefaultGroup->run(work);
 	}
 
 	void ThreadPool::wait()
 	{
-		mWaiting = true;
-		while (mNumWork.load() > 0)
-			std::this_thread::yield();
+		mDefaultGroup->wait();
 	}
 
 	void ThreadPool::wait(work_function work, int delay)
 	{
-		mWaiting = true;
+		mDefaultGroup->wait(work, delay);
+	}
+
+	// TaskGroup
+
+	TaskGroup::TaskGroup(ThreadPool* pool) : mPool(pool), mPending(0), mQueued(0)
+	{
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+		// Tasks reference their group : make sure they're all finished
+		if (mPending > 0)
+			wait();
+	}
+
+	ThreadPool* TaskGroup::getPool()
+	{
+		// The shared pool is not kept : it's only created when the first task is queued ( groups can be static members ),
+		// and it's gone once deinit was called
+		return mPool != nullptr ? mPool : ThreadPool::getInstance();
+	}
+
+	void TaskGroup::run(const std::function<void(void)>& work)
+	{
+		ThreadPool* pool = getPool();
+		if (pool == nullptr)
+		{
+			try { work(); }
+			catch (...) {}
+			return;
+		}
+
+		mPending++;
+		pool->push(ThreadPool::WorkItem(work, this));
+	}
+
+	void TaskGroup::onTaskDone()
+	{
+		// Notify under the lock : the waiting thread may destroy the group as soon as it's done
+		std::unique_lock<std::mutex> lock(mLock);
+		if (--mPending == 0)
+			mEvent.notify_all();
+	}
+
+	void TaskGroup::wait()
+	{
+		if (mPending == 0)
+			return;
+
+		ThreadPool* pool = getPool();
+		if (pool == nullptr)
+			return;
+
+		int id = sWorkerPool == pool ? sWorkerId : -1;
+
+		ThreadPool::WorkItem item;
+
+		while (true)
+		{
+			// Help : run the tasks of this group that were not started yet
+			if (pool->pop(id, item, this))
+			{
+				pool->execute(item);
+				item = ThreadPool::WorkItem();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mLock);
+			mEvent.wait(lock, [this] { return mPending == 0 || mQueued > 0; });
+
+			if (mPending == 0)
+				return;
+		}
+	}
+
+	void TaskGroup::wait(const std::function<void(void)>& work, int delay)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
 
-		while (mNumWork.load() > 0)
+		while (mPending > 0)
 		{
+			lock.unlock();
 			work();
+			lock.lock();
 
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+			mEvent.wait_for(lock, std::chrono::milliseconds(delay), [this] { return mPending == 0; });
 		}
 	}
-}
\ No newline at end of file
+}
@@ -3,33 +3,115 @@
 
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <deque>
 #include <atomic>
 #include <functional>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <vector>
 
 namespace Utils
 {
+	class ThreadPool;
+
+	// A set of tasks that can be waited for as a whole.
+	// wait() runs the pending tasks of the group on the calling thread, so groups can be nested from inside a task.
+	class TaskGroup
+	{
+		friend class ThreadPool;
+
+	public:
+		TaskGroup(ThreadPool* pool = nullptr); // nullptr : use the shared ThreadPool ( its tasks run on the calling thread once it's deinit )
+		~TaskGroup();
+
+		void run(const std::function<void(void)>& work);
+
+		void wait();
+		void wait(const std::function<void(void)>& work, int delay = 50); // Calls work every delay ms until all tasks are done
+
+		bool isDone() { return mPending == 0; }
+
+	private:
+		void onTaskDone();
+		ThreadPool* getPool();
+
+		ThreadPool* mPool;
+
+		std::atomic<int> mPending;
+		int mQueued;
+		std::mutex mLock;
+		std::condition_variable mEvent;
+	};
+
+	// Blocking work-stealing executor : each worker has its own deque, runs its most recent task first
+	// and steals the oldest task of another worker when its deque is empty. Idle workers sleep on a condition variable.
 	class ThreadPool
 	{
+		friend class TaskGroup;
+
 	public:
 		typedef std::function<void(void)> work_function;
 
-		ThreadPool();
-		~ThreadPool();
+		ThreadPool(int threadCount = -1); // -1 : one thread per core
+		~ThreadPool(); // Runs the tasks still queued, then joins the threads
+
+		// Executor shared by the application. Thread count is read from the "ThreadPoolSize" setting ( 0 = auto )
+		// nullptr once deinit was called
+		static ThreadPool* getInstance();
+
+		// Stops the shared executor when the application exits. Call it once the other threads are stopped
+		static void deinit();
 
 		void queueWorkItem(work_function work);
 		void wait();
 		void wait(work_function work, int delay = 50);
 
+		template<typename T> std::future<T> async(const std::function<T(void)>& work)
+		{
+			auto task = std::make_shared<std::packaged_task<T(void)>>(work);
+			push(WorkItem([task] { (*task)(); }, nullptr));
+			return task->get_future();
+		}
+
+		int getThreadCount() { return (int)mThreads.size(); }
+
 	private:
-		bool mRunning;
-		bool mWaiting;
-		std::queue<work_function> mWorkQueue;
-		std::atomic<size_t> mNumWork;
-		std::mutex _mutex;
+		struct WorkItem
+		{
+			WorkItem() : group(nullptr) { }
+			WorkItem(const work_function& w, TaskGroup* g) : work(w), group(g) { }
+
+			work_function work;
+			TaskGroup* group;
+		};
+
+		struct WorkerQueue
+		{
+			std::mutex lock;
+			std::deque<WorkItem> items;
+		};
+
+		void run(int id);
+		void push(const WorkItem& item);
+		bool pop(int id, WorkItem& item, TaskGroup* group = nullptr);
+		void execute(WorkItem& item);
+
+		std::vector<std::unique_ptr<WorkerQueue>> mQueues;
 		std::vector<std::thread> mThreads;
+		std::atomic<unsigned int> mNextQueue;
+
+		bool mRunning;
+		int mQueued;
+		std::mutex mIdleLock;
+		std::condition_variable mIdleEvent;
+
+		TaskGroup* mDefaultGroup;
 
+		static ThreadPool* sInstance;
+		static bool sStopped;
+		static std::mutex sInstanceLock;
 	};
 }
 
-#endif
\ No newline at end of file
+#endif
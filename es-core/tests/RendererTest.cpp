@@ -0,0 +1,223 @@
+#include "math/Transform4x4f.h"
+#include "math/Vector2i.h"
+#include "renderers/Renderer.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+// Batching in Renderer.cpp, checked on what the headless backend receives ( no window, no GL context needed )
+
+namespace
+{
+	class RendererTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			Renderer::setMatrix(Transform4x4f::Identity());
+			Renderer::bindTexture(0);
+			Renderer::endFrame();
+
+			Renderer::clearRecordedDraws();
+			Renderer::setRecordDraws(true);
+		}
+
+		void TearDown() override
+		{
+			// The next test starts with empty stats
+			Renderer::endFrame();
+
+			Renderer::setRecordDraws(false);
+			Renderer::clearRecordedDraws();
+		}
+
+		// 4 vertices strip, colors numbered to find them back in the batch
+		static void drawQuad(float x, float y, unsigned int color, Renderer::Blend::Factor srcBlend = Renderer::Blend::SRC_ALPHA, Renderer::Blend::Factor dstBlend = Renderer::Blend::ONE_MINUS_SRC_ALPHA)
+		{
+			Renderer::Vertex vertices[4];
+			vertices[0] = { { x,      y      }, { 0.0f, 0.0f }, color     };
+			vertices[1] = { { x,      y + 10 }, { 0.0f, 1.0f }, color + 1 };
+			vertices[2] = { { x + 10, y      }, { 1.0f, 0.0f }, color + 2 };
+			vertices[3] = { { x + 10, y + 10 }, { 1.0f, 1.0f }, color + 3 };
+
+			Renderer::drawTriangleStrips(vertices, 4, srcBlend, dstBlend);
+		}
+
+		static Transform4x4f translation(float x, float y, float z)
+		{
+			Transform4x4f matrix = Transform4x4f::Identity();
+			matrix.translate(Vector3f(x, y, z));
+			return matrix;
+		}
+
+		static const std::vector<Renderer::RecordedDraw>& draws() { return Renderer::getRecordedDraws(); }
+
+		static bool isIdentity(const float* matrix)
+		{
+			const Transform4x4f identity = Transform4x4f::Identity();
+			const float* tm = (const float*)&identity;
+
+			for (int i = 0; i < 16; i++)
+				if (matrix[i] != tm[i])
+					return false;
+
+			return true;
+		}
+	};
+}
+
+TEST_F(RendererTest, NothingIsSubmittedBeforeFlush)
+{
+	drawQuad(0, 0, 100);
+	EXPECT_EQ(0u, draws().size());
+
+	Renderer::flush();
+	ASSERT_EQ(1u, draws().size());
+	EXPECT_EQ(4u, draws()[0].vertices.size());
+}
+
+TEST_F(RendererTest, StripsAreJoinedWithDegenerateTriangles)
+{
+	Renderer::setMatrix(translation(5, 7, 0));
+	drawQuad(0, 0, 100);
+	drawQuad(20, 0, 200);
+	Renderer::flush();
+
+	ASSERT_EQ(1u, draws().size());
+
+	const Renderer::RecordedDraw& draw = draws()[0];
+	ASSERT_EQ(10u, draw.vertices.size());
+
+	// Vertices are transformed on the CPU, the batch is drawn with an identity model view
+	EXPECT_TRUE(isIdentity(draw.matrix));
+	EXPECT_EQ(Vector2f(5, 7), draw.vertices[0].pos);
+	EXPECT_EQ(Vector2f(15, 17), draw.vertices[3].pos);
+
+	// Last vertex of the first strip, then first vertex of the second one
+	EXPECT_EQ(draw.vertices[3].pos, draw.vertices[4].pos);
+	EXPECT_EQ(103u, draw.vertices[4].col);
+	EXPECT_EQ(Vector2f(25, 7), draw.vertices[5].pos);
+	EXPECT_EQ(200u, draw.vertices[5].col);
+
+	for (int i = 0; i < 4; i++)
+	{
+		EXPECT_EQ(200u + i, draw.vertices[6 + i].col);
+		EXPECT_EQ(draw.vertices[6 + i].pos - draw.vertices[6].pos, draw.vertices[i].pos - draw.vertices[0].pos);
+	}
+}
+
+TEST_F(RendererTest, TextureChangeFlushes)
+{
+	Renderer::bindTexture(1);
+	drawQuad(0, 0, 100);
+	drawQuad(20, 0, 200);
+	Renderer::bindTexture(2);
+	drawQuad(40, 0, 300);
+	Renderer::bindTexture(2);
+	drawQuad(60, 0, 400);
+	Renderer::flush();
+
+	ASSERT_EQ(2u, draws().size());
+	EXPECT_EQ(1u, draws()[0].texture);
+	EXPECT_EQ(10u, draws()[0].vertices.size());
+	EXPECT_EQ(2u, draws()[1].texture);
+	EXPECT_EQ(10u, draws()[1].vertices.size());
+}
+
+TEST_F(RendererTest, BlendChangeFlushes)
+{
+	drawQuad(0, 0, 100);
+	drawQuad(20, 0, 200, Renderer::Blend::ONE, Renderer::Blend::ONE);
+	drawQuad(40, 0, 300, Renderer::Blend::ONE, Renderer::Blend::ONE);
+	drawQuad(60, 0, 400);
+	Renderer::flush();
+
+	ASSERT_EQ(3u, draws().size());
+	EXPECT_EQ(Renderer::Blend::SRC_ALPHA, draws()[0].srcBlendFactor);
+	EXPECT_EQ(Renderer::Blend::ONE_MINUS_SRC_ALPHA, draws()[0].dstBlendFactor);
+	EXPECT_EQ(4u, draws()[0].vertices.size());
+	EXPECT_EQ(Renderer::Blend::ONE, draws()[1].srcBlendFactor);
+	EXPECT_EQ(Renderer::Blend::ONE, draws()[1].dstBlendFactor);
+	EXPECT_EQ(10u, draws()[1].vertices.size());
+	EXPECT_EQ(Renderer::Blend::SRC_ALPHA, draws()[2].srcBlendFactor);
+	EXPECT_EQ(4u, draws()[2].vertices.size());
+}
+
+TEST_F(RendererTest, ClipChangeFlushes)
+{
+	drawQuad(0, 0, 100);
+	Renderer::pushClipRect(Vector2i(10, 20), Vector2i(30, 40));
+	drawQuad(20, 0, 200);
+	Renderer::popClipRect();
+	drawQuad(40, 0, 300);
+	Renderer::flush();
+
+	ASSERT_EQ(3u, draws().size());
+
+	EXPECT_EQ(0, draws()[0].scissor.w);
+	EXPECT_EQ(100u, draws()[0].vertices[0].col);
+
+	EXPECT_EQ(10, draws()[1].scissor.x);
+	EXPECT_EQ(20, draws()[1].scissor.y);
+	EXPECT_EQ(30, draws()[1].scissor.w);
+	EXPECT_EQ(40, draws()[1].scissor.h);
+	EXPECT_EQ(200u, draws()[1].vertices[0].col);
+
+	EXPECT_EQ(0, draws()[2].scissor.w);
+	EXPECT_EQ(300u, draws()[2].vertices[0].col);
+}
+
+TEST_F(RendererTest, Non2DMatrixIsDrawnDirectly)
+{
+	drawQuad(0, 0, 100);
+
+	Transform4x4f matrix = translation(5, 7, 3);
+	Renderer::setMatrix(matrix);
+	drawQuad(20, 0, 200);
+
+	// The pending batch went first, the strip is sent as is with its own matrix
+	ASSERT_EQ(2u, draws().size());
+	EXPECT_TRUE(isIdentity(draws()[0].matrix));
+	EXPECT_EQ(100u, draws()[0].vertices[0].col);
+
+	const Renderer::RecordedDraw& direct = draws()[1];
+	EXPECT_EQ(0, memcmp(direct.matrix, &matrix, sizeof(direct.matrix)));
+	ASSERT_EQ(4u, direct.vertices.size());
+	EXPECT_EQ(Vector2f(20, 0), direct.vertices[0].pos);
+	EXPECT_EQ(200u, direct.vertices[0].col);
+
+	// Back to 2D : batching again
+	Renderer::setMatrix(Transform4x4f::Identity());
+	drawQuad(40, 0, 300);
+	drawQuad(60, 0, 400);
+	Renderer::flush();
+
+	ASSERT_EQ(3u, draws().size());
+	EXPECT_EQ(10u, draws()[2].vertices.size());
+}
+
+TEST_F(RendererTest, Stats)
+{
+	Renderer::bindTexture(1001);
+	drawQuad(0, 0, 100);
+	drawQuad(20, 0, 200);
+	Renderer::bindTexture(1002);
+	drawQuad(40, 0, 300);
+
+	Renderer::setMatrix(translation(0, 0, 1));
+	drawQuad(60, 0, 400);
+
+	// Counted for the last complete frame only
+	EXPECT_EQ(0u, Renderer::getStats().submits);
+
+	Renderer::endFrame();
+
+	const Renderer::Stats& stats = Renderer::getStats();
+	EXPECT_EQ(4u, stats.submits);
+	EXPECT_EQ(3u, stats.drawCalls);
+	EXPECT_EQ(10u + 4u + 4u, stats.vertices);
+	EXPECT_EQ(2u, stats.textureBinds); // the direct draw keeps 1002
+
+	Renderer::endFrame();
+	EXPECT_EQ(0u, Renderer::getStats().submits);
+	EXPECT_EQ(0u, Renderer::getStats().drawCalls);
+}
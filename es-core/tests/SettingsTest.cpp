@@ -0,0 +1,159 @@
+#include "Settings.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Settings are read from the loading threads, the TextureLoader... while the UI thread changes them.
+// Build with -DCMAKE_CXX_FLAGS=-fsanitize=thread to check the snapshots for races.
+
+#define READER_THREADS 4
+#define WRITES 2000
+
+TEST(SettingsTest, ReadWriteRoundTrip)
+{
+	Settings* settings = Settings::getInstance();
+
+	settings->setInt("Test.RoundTrip.Int", 42);
+	settings->setBool("Test.RoundTrip.Bool", true);
+	settings->setFloat("Test.RoundTrip.Float", 1.5f);
+	settings->setString("Test.RoundTrip.String", "value");
+
+	EXPECT_EQ(42, settings->getInt("Test.RoundTrip.Int"));
+	EXPECT_TRUE(settings->getBool("Test.RoundTrip.Bool"));
+	EXPECT_EQ(1.5f, settings->getFloat("Test.RoundTrip.Float"));
+	EXPECT_EQ("value", settings->getString("Test.RoundTrip.String"));
+
+	EXPECT_EQ(42, settings->getInt(Settings::Key("Test.RoundTrip.Int")));
+	EXPECT_EQ("value", settings->getString(Settings::Key("Test.RoundTrip.String")));
+}
+
+TEST(SettingsTest, KeyDeclaredBeforeTheSetting)
+{
+	Settings* settings = Settings::getInstance();
+
+	Settings::Key key("Test.LateKey");
+	EXPECT_EQ(0, settings->getInt(key));
+
+	settings->setInt("Test.LateKey", 7);
+	EXPECT_EQ(7, settings->getInt(key));
+}
+
+TEST(SettingsTest, GenerationChangesOnWrite)
+{
+	Settings* settings = Settings::getInstance();
+
+	settings->setInt("Test.Generation", 1);
+	unsigned int generation = settings->getGeneration();
+
+	EXPECT_FALSE(settings->setInt("Test.Generation", 1));
+	EXPECT_EQ(generation, settings->getGeneration());
+
+	EXPECT_TRUE(settings->setInt("Test.Generation", 2));
+	EXPECT_NE(generation, settings->getGeneration());
+}
+
+TEST(SettingsTest, UpdatePublishesOneSnapshot)
+{
+	Settings* settings = Settings::getInstance();
+
+	settings->setInt("Test.Update.A", 0);
+	settings->setInt("Test.Update.B", 0);
+	unsigned int generation = settings->getGeneration();
+
+	// As GuiSettings::save runs the save functions of a page
+	settings->beginUpdate();
+	settings->setInt("Test.Update.A", 1);
+	settings->setInt("Test.Update.B", 2);
+	settings->setInt("Test.Update.A", 3);
+	EXPECT_EQ(generation, settings->getGeneration());
+	settings->endUpdate();
+
+	EXPECT_EQ(generation + 1, settings->getGeneration());
+	EXPECT_EQ(3, settings->getInt("Test.Update.A"));
+	EXPECT_EQ(2, settings->getInt("Test.Update.B"));
+}
+
+TEST(SettingsTest, ReadDuringUpdateSeesTheChanges)
+{
+	Settings* settings = Settings::getInstance();
+
+	settings->setString("Test.Update.Theme", "a");
+
+	// A save function which reloads something from the value it has just set
+	settings->beginUpdate();
+	settings->setString("Test.Update.Theme", "b");
+	EXPECT_EQ("b", settings->getString("Test.Update.Theme"));
+
+	settings->setString("Test.Update.Theme", "c");
+	settings->endUpdate();
+
+	EXPECT_EQ("c", settings->getString("Test.Update.Theme"));
+}
+
+TEST(SettingsTest, ConcurrentReadsDuringWrites)
+{
+	Settings* settings = Settings::getInstance();
+
+	settings->setInt("Test.Counter", 0);
+	settings->setString("Test.Text", "value 0");
+
+	std::atomic<bool> done(false);
+	std::atomic<int> errors(0);
+
+	std::vector<std::thread> readers;
+	for (int t = 0; t < READER_THREADS; t++)
+	{
+		readers.push_back(std::thread([settings, t, &done, &errors]
+		{
+			Settings::Key counterKey("Test.Counter");
+			Settings::Key textKey("Test.Text");
+
+			int last = 0;
+			int reads = 0;
+
+			while (!done || reads < 100)
+			{
+				// The writer only increments : a snapshot never goes back in time
+				int counter = (reads % 2) ? settings->getInt(counterKey) : settings->getInt("Test.Counter");
+				if (counter < last)
+					errors++;
+
+				last = counter;
+
+				std::string text = (reads % 2) ? settings->getString(textKey) : settings->getString("Test.Text");
+				if (text.compare(0, 6, "value ") != 0)
+					errors++;
+
+				// Settings created while the others are read
+				settings->getBool("Test.Added." + std::to_string(reads % 64));
+				if (settings->getInt(Settings::Key("Test.Thread." + std::to_string(t))) < 0)
+					errors++;
+
+				reads++;
+			}
+		}));
+	}
+
+	for (int i = 1; i <= WRITES; i++)
+	{
+		settings->setInt("Test.Counter", i);
+		settings->setString("Test.Text", "value " + std::to_string(i));
+
+		if (i % 32 == 0)
+			settings->setBool("Test.Added." + std::to_string((i / 32) % 64), true);
+
+		if (i % 500 == 0)
+			settings->setInt("Test.Thread." + std::to_string((i / 500) % READER_THREADS), i);
+	}
+
+	done = true;
+
+	for (auto& thread : readers)
+		thread.join();
+
+	EXPECT_EQ(0, errors);
+	EXPECT_EQ(WRITES, settings->getInt("Test.Counter"));
+	EXPECT_EQ("value " + std::to_string(WRITES), settings->getString("Test.Text"));
+}
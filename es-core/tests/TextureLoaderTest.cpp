@@ -0,0 +1,223 @@
+#include "resources/TextureData.h"
+#include "resources/TextureDataManager.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+// The asynchronous texture queue : what the UI thread pays to request textures, in which order they load,
+// and what is left of the queue once it's cancelled. Svg tiles, so that they decode without FreeImage.
+
+namespace
+{
+	class TextureLoaderTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-loader-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mFolder = tmp;
+
+			TextureData::setUiThread();
+			TextureData::getUiThreadLoads(true);
+
+			mLoader = new TextureLoader(nullptr);
+		}
+
+		void TearDown() override
+		{
+			delete mLoader;
+			mTextures.clear();
+
+			system(("rm -rf \"" + mFolder + "\"").c_str());
+		}
+
+		// CPU time of the calling thread, in us : the time the workers take the CPU from it is not its own cost
+		static long long threadTime()
+		{
+			timespec ts;
+			clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+			return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+		}
+
+		// count tiles, with their size read from the files as TextureResource does before queuing them
+		void createTiles(int count)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				std::string path = mFolder + "/tile" + std::to_string(i) + ".svg";
+
+				std::ofstream f(path.c_str());
+				f << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"256\" height=\"192\">";
+				for (int c = 0; c < 48; c++)
+					f << "<circle cx=\"" << (c * 5) << "\" cy=\"96\" r=\"" << (10 + c + i % 7) << "\" fill=\"#" << (100000 + c * 1111) << "\"/>";
+				f << "</svg>";
+				f.close();
+
+				std::shared_ptr<TextureData> texture = std::make_shared<TextureData>(false, false);
+				texture->initFromPath(path);
+				texture->probeSize();
+				mTextures.push_back(texture);
+			}
+		}
+
+		// Waits for the loader to finish the textures it was asked for, up to 10 s
+		bool waitLoaded(const std::vector<std::shared_ptr<TextureData>>& textures)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			while (std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+			{
+				if (std::all_of(textures.cbegin(), textures.cend(), [](const std::shared_ptr<TextureData>& t) { return t->isLoaded(); }))
+					return true;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+
+			return false;
+		}
+
+		// Stops the loader : what is loaded afterwards is all it will ever load
+		int stopAndCountLoaded()
+		{
+			delete mLoader;
+			mLoader = nullptr;
+
+			return (int)std::count_if(mTextures.cbegin(), mTextures.cend(), [](const std::shared_ptr<TextureData>& t) { return t->isLoaded(); });
+		}
+
+		std::string mFolder;
+		std::vector<std::shared_ptr<TextureData>> mTextures;
+		TextureLoader* mLoader;
+	};
+}
+
+TEST_F(TextureLoaderTest, QueuingDoesNotReadTheFiles)
+{
+	createTiles(100);
+
+	for (auto& texture : mTextures)
+		mLoader->load(texture);
+
+	EXPECT_EQ(0, TextureData::getUiThreadLoads());
+	EXPECT_TRUE(waitLoaded(mTextures));
+	EXPECT_EQ(0, TextureData::getUiThreadLoads());
+	EXPECT_EQ(0u, mLoader->getQueueSize());
+}
+
+TEST_F(TextureLoaderTest, VisibleTexturesLoadFirst)
+{
+	createTiles(1000);
+
+	for (int i = 0; i < 999; i++)
+		mLoader->load(mTextures[i], TEXTURE_PRIORITY_REQUESTED + 5);
+
+	std::shared_ptr<TextureData> visible = mTextures[999];
+	mLoader->load(visible, TEXTURE_PRIORITY_VISIBLE);
+
+	ASSERT_TRUE(waitLoaded({ visible }));
+
+	// Only the ones taken by the workers before it was queued
+	int loaded = (int)std::count_if(mTextures.cbegin(), mTextures.cend() - 1, [](const std::shared_ptr<TextureData>& t) { return t->isLoaded(); });
+	EXPECT_LT(loaded, 500);
+}
+
+TEST_F(TextureLoaderTest, CancelledTexturesAreNotLoaded)
+{
+	createTiles(2000);
+
+	for (auto& texture : mTextures)
+		mLoader->load(texture);
+
+	// The view changes : nothing queued is counted anymore
+	mLoader->cancelAll();
+	EXPECT_EQ(0u, mLoader->getQueueSize());
+
+	// What the new view draws is requested again
+	std::vector<std::shared_ptr<TextureData>> visible(mTextures.cend() - 10, mTextures.cend());
+	for (auto& texture : visible)
+		mLoader->load(texture, TEXTURE_PRIORITY_VISIBLE);
+
+	ASSERT_TRUE(waitLoaded(visible));
+	EXPECT_EQ(0u, mLoader->getQueueSize());
+
+	EXPECT_LT(stopAndCountLoaded(), 1000);
+}
+
+TEST_F(TextureLoaderTest, ScrollingBenchmark)
+{
+	// A grid of 4 columns & 5 rows on screen, with 2 more rows on each side, as ImageGridComponent::updateTiles drives it :
+	// one row per frame through 10k tiles, the tiles which leave the grid are removed from the queue
+	const int count = 10000;
+	const int columns = 4;
+	const int rows = 5;
+	const int extraRows = 2;
+
+	createTiles(count);
+
+	long long total = 0;
+	long long worst = 0;
+	int frames = 0;
+
+	for (int top = 0; top + rows <= count / columns; top++, frames++)
+	{
+		long long start = threadTime();
+
+		int cursor = (top + rows / 2) * columns;
+
+		for (int row = top - extraRows; row < top + rows + extraRows; row++)
+		{
+			for (int col = 0; col < columns; col++)
+			{
+				int idx = row * columns + col;
+				if (idx < 0 || idx >= count)
+					continue;
+
+				bool onScreen = (row >= top && row < top + rows);
+				mLoader->load(mTextures[idx], onScreen ? TEXTURE_PRIORITY_VISIBLE : TEXTURE_PRIORITY_REQUESTED + abs(idx - cursor) / columns);
+			}
+		}
+
+		// The row which left the grid
+		for (int col = 0; col < columns; col++)
+		{
+			int idx = (top - extraRows - 1) * columns + col;
+			if (idx >= 0)
+				mLoader->remove(mTextures[idx]);
+		}
+
+		long long elapsed = threadTime() - start;
+		total += elapsed;
+		worst = std::max(worst, elapsed);
+
+		// A frame at 1000 fps : far faster than the workers can follow
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Stopped on the last screen : time until it's complete
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::shared_ptr<TextureData>> lastScreen(mTextures.cend() - rows * columns, mTextures.cend());
+	bool complete = waitLoaded(lastScreen);
+	long long settle = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	int uiLoads = TextureData::getUiThreadLoads();
+	int loaded = stopAndCountLoaded();
+
+	RecordProperty("scroll_frames", std::to_string(frames));
+	RecordProperty("scroll_frame_avg_us", std::to_string(total / frames));
+	RecordProperty("scroll_frame_max_us", std::to_string(worst));
+	RecordProperty("scroll_last_screen_us", std::to_string(settle));
+	RecordProperty("scroll_textures_loaded", std::to_string(loaded));
+
+	std::cout << count << " tiles, " << frames << " frames : " << (total / frames) << " us of UI thread per frame to queue the grid ( max " << worst << " us ), last screen complete "
+		<< settle << " us after stopping, " << loaded << " textures decoded, " << uiLoads << " on the UI thread" << std::endl;
+
+	EXPECT_TRUE(complete);
+	EXPECT_EQ(0, uiLoads);
+	EXPECT_LT(total / frames, 500);
+}
@@ -0,0 +1,141 @@
+#include "renderers/Renderer.h"
+#include "resources/ResourceManager.h"
+#include "resources/TextureData.h"
+#include "resources/TextureResource.h"
+#include "Settings.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <unistd.h>
+
+// A game launch as Window::deinit & Window::init do it ( every texture unloaded, then reloaded ), on the headless renderer.
+// Svg files are used : they are decoded by nanosvg, and rasterizing them is the kind of work the cache saves.
+
+namespace
+{
+	class TextureResumeTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-resume-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mFolder = tmp;
+
+			for (int i = 0; i < 4; i++)
+			{
+				std::string path = mFolder + "/image" + std::to_string(i) + ".svg";
+
+				std::ofstream f(path.c_str());
+				f << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"512\" height=\"512\">";
+				for (int c = 0; c < 64; c++)
+					f << "<circle cx=\"" << (c * 8) << "\" cy=\"" << (256 + i) << "\" r=\"" << (40 + c) << "\" fill=\"#" << (100000 + c * 1111) << "\" fill-opacity=\"0.5\"/>";
+				f << "</svg>";
+
+				mPaths.push_back(path);
+			}
+		}
+
+		void TearDown() override
+		{
+			mTextures.clear();
+			Settings::getInstance()->setInt("ResumeCacheSize", 0);
+
+			system(("rm -rf \"" + mFolder + "\"").c_str());
+		}
+
+		// Returns the time taken to decode the textures, in us
+		long long loadTextures()
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			for (auto& path : mPaths)
+			{
+				// Not dynamic : loaded on this thread, and reloaded by ResourceManager::reloadAll
+				auto texture = TextureResource::get(path, false, false, true, false);
+				EXPECT_TRUE(texture->bind()); // uploaded to the null renderer
+				mTextures.push_back(texture);
+			}
+
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		// Returns the time taken to load the textures again, in us
+		long long launchAndReturn()
+		{
+			ResourceManager::getInstance()->unloadAll(); // Window::deinit
+
+			for (auto& texture : mTextures)
+				EXPECT_FALSE(texture->isLoaded());
+
+			auto start = std::chrono::steady_clock::now();
+			ResourceManager::getInstance()->reloadAll(); // Window::init
+			long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+			for (auto& texture : mTextures)
+			{
+				EXPECT_TRUE(texture->isLoaded());
+				EXPECT_TRUE(texture->bind());
+			}
+
+			return elapsed;
+		}
+
+		std::string mFolder;
+		std::vector<std::string> mPaths;
+		std::vector<std::shared_ptr<TextureResource>> mTextures;
+	};
+}
+
+TEST_F(TextureResumeTest, NothingKeptWhenDisabled)
+{
+	Settings::getInstance()->setInt("ResumeCacheSize", 0);
+
+	loadTextures();
+	EXPECT_EQ(0u, TextureData::getResumeCacheSize());
+
+	launchAndReturn();
+	EXPECT_EQ(0u, TextureData::getResumeCacheSize());
+}
+
+TEST_F(TextureResumeTest, TexturesComeBackFromTheCache)
+{
+	Settings::getInstance()->setInt("ResumeCacheSize", 16);
+
+	long long decoded = loadTextures();
+
+	// The pixels are kept once uploaded
+	size_t expected = 0;
+	for (auto& texture : mTextures)
+		expected += texture->getSize().x() * texture->getSize().y() * 4;
+
+	EXPECT_EQ(expected, TextureData::getResumeCacheSize());
+
+	long long cached = launchAndReturn();
+
+	// Taken back by the textures, then cached again at upload
+	EXPECT_EQ(expected, TextureData::getResumeCacheSize());
+
+	// A second launch finds them again
+	launchAndReturn();
+	EXPECT_EQ(expected, TextureData::getResumeCacheSize());
+
+	RecordProperty("reload_cached_us", std::to_string(cached));
+	RecordProperty("reload_decoded_us", std::to_string(decoded));
+	std::cout << mTextures.size() << " textures : " << decoded << " us decoded, " << cached << " us from the resume cache" << std::endl;
+
+	EXPECT_LT(cached, decoded);
+}
+
+TEST_F(TextureResumeTest, BudgetIsRespected)
+{
+	// 512x512 RGBA = 1 MB each
+	Settings::getInstance()->setInt("ResumeCacheSize", 2);
+
+	loadTextures();
+	EXPECT_LE(TextureData::getResumeCacheSize(), 2u * 1024 * 1024);
+
+	launchAndReturn();
+	EXPECT_LE(TextureData::getResumeCacheSize(), 2u * 1024 * 1024);
+}
@@ -0,0 +1,279 @@
+#include "ThemeData.h"
+#include "Settings.h"
+#include "utils/FileSystemUtil.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+// The parsed theme files shared by the systems : what they save when a theme is loaded for every system at boot,
+// and when they are dropped. Then the lookup of the element properties.
+
+namespace
+{
+	class ThemeDataTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			char tmp[] = "/tmp/es-theme-XXXXXX";
+			ASSERT_TRUE(mkdtemp(tmp) != nullptr);
+			mFolder = tmp;
+
+			Settings::getInstance()->setString("ThemeSet", "test");
+			ThemeData::clearDocumentCache();
+		}
+
+		void TearDown() override
+		{
+			// loadFile makes the last loaded theme the default one
+			ThemeData::setDefaultTheme(nullptr);
+			ThemeData::clearDocumentCache();
+
+			Settings::getInstance()->setString("ThemeSet", "");
+
+			system(("rm -rf \"" + mFolder + "\"").c_str());
+		}
+
+		// A system theme including a common file of elements views of elements texts, as most themes are built
+		std::string createTheme(int views, int elements, const std::string& color = "FFFFFF")
+		{
+			std::ofstream common((mFolder + "/common.xml").c_str());
+			common << "<theme><formatVersion>7</formatVersion>";
+
+			for (int v = 0; v < views; v++)
+			{
+				common << "<view name=\"" << (v % 2 == 0 ? "basic, detailed" : "grid, video") << "\">";
+
+				for (int e = 0; e < elements; e++)
+					common << "<text name=\"text" << v << "_" << e << "\"><pos>0." << e % 10 << " 0.5</pos><size>0.3 0.05</size>"
+						<< "<text>${system.name} " << e << "</text><color>" << color << "</color><fontSize>0.03</fontSize></text>";
+
+				common << "</view>";
+			}
+
+			common << "</theme>";
+			common.close();
+
+			std::string path = mFolder + "/theme.xml";
+
+			std::ofstream theme(path.c_str());
+			theme << "<theme><formatVersion>7</formatVersion><include>./common.xml</include>"
+				<< "<view name=\"system\"><text name=\"logoText\"><text>${system.fullName}</text></text></view></theme>";
+
+			return path;
+		}
+
+		static std::shared_ptr<ThemeData> loadTheme(const std::string& path, const std::string& system)
+		{
+			std::map<std::string, std::string> sysData;
+			sysData["system.name"] = system;
+			sysData["system.theme"] = system;
+			sysData["system.fullName"] = system + " full name";
+
+			std::shared_ptr<ThemeData> theme = std::make_shared<ThemeData>();
+			theme->loadFile(system, sysData, path);
+			return theme;
+		}
+
+		static unsigned int getColor(const std::shared_ptr<ThemeData>& theme)
+		{
+			const ThemeData::ThemeElement* elem = theme->getElement("basic", "text0_0", "text");
+			return elem != nullptr ? elem->get<unsigned int>("color") : 0;
+		}
+
+		std::string mFolder;
+	};
+}
+
+TEST_F(ThemeDataTest, SystemVariablesAreAppliedToSharedFiles)
+{
+	std::string path = createTheme(2, 3);
+
+	std::shared_ptr<ThemeData> a = loadTheme(path, "a");
+	std::shared_ptr<ThemeData> b = loadTheme(path, "b");
+
+	const ThemeData::ThemeElement* elemA = a->getElement("detailed", "text0_1", "text");
+	const ThemeData::ThemeElement* elemB = b->getElement("detailed", "text0_1", "text");
+
+	ASSERT_NE(nullptr, elemA);
+	ASSERT_NE(nullptr, elemB);
+
+	EXPECT_EQ("a 1", elemA->get<std::string>("text"));
+	EXPECT_EQ("b 1", elemB->get<std::string>("text"));
+	EXPECT_EQ("b full name", b->getElement("system", "logoText", "text")->get<std::string>("text"));
+}
+
+TEST_F(ThemeDataTest, ThemeSetChangeDropsTheFiles)
+{
+	std::string path = createTheme(2, 3, "FF0000");
+	EXPECT_EQ(0xFF0000FF, getColor(loadTheme(path, "a")));
+
+	// Rewritten with the same date : the cached file is still used
+	struct stat info;
+	ASSERT_EQ(0, stat((mFolder + "/common.xml").c_str(), &info));
+
+	createTheme(2, 3, "00FF00");
+
+	struct utimbuf times;
+	times.actime = info.st_atime;
+	times.modtime = info.st_mtime;
+	utime((mFolder + "/common.xml").c_str(), &times);
+
+	EXPECT_EQ(0xFF0000FF, getColor(loadTheme(path, "a")));
+
+	// Another theme set : nothing of the previous one is kept
+	Settings::getInstance()->setString("ThemeSet", "other");
+	EXPECT_EQ(0x00FF00FF, getColor(loadTheme(path, "a")));
+}
+
+TEST_F(ThemeDataTest, BootBenchmark)
+{
+	// 60 systems sharing a theme of 8 views of 40 elements, as they are loaded at boot
+	const int systems = 60;
+	std::string path = createTheme(8, 40);
+
+	auto boot = [&path](bool shared)
+	{
+		std::vector<std::shared_ptr<ThemeData>> themes;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < systems; i++)
+		{
+			if (!shared)
+				ThemeData::clearDocumentCache();
+
+			themes.push_back(loadTheme(path, "system" + std::to_string(i)));
+		}
+
+		long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		EXPECT_EQ("system7 3", themes[7]->getElement("grid", "text1_3", "text")->get<std::string>("text"));
+		return elapsed;
+	};
+
+	long long parsedEach = boot(false);
+
+	ThemeData::clearDocumentCache();
+	long long shared = boot(true);
+
+	RecordProperty("theme_boot_parsed_each_us", std::to_string(parsedEach));
+	RecordProperty("theme_boot_shared_us", std::to_string(shared));
+
+	std::cout << systems << " systems, 8 views of 40 elements : themes loaded in " << parsedEach << " us parsing the files for each system, "
+		<< shared << " us with the shared files" << std::endl;
+
+	EXPECT_LT(shared, parsedEach);
+}
+
+TEST_F(ThemeDataTest, MissingPropertiesThrow)
+{
+	ThemeData::ThemeElement elem;
+	elem.set("pos") = Vector2f(0.5f, 0.25f);
+	elem.set("customIcon") = std::string("icon.svg"); // Not a name of sElementMap : stored by name
+
+	EXPECT_EQ(0.25f, elem.get<Vector2f>("pos").y());
+	EXPECT_EQ("icon.svg", elem.get<std::string>("customIcon"));
+
+	// Another type than the parsed one
+	EXPECT_EQ(0.0f, elem.get<float>("pos"));
+
+	EXPECT_FALSE(elem.has("size"));
+	EXPECT_THROW(elem.get<Vector2f>("size"), std::out_of_range);
+	EXPECT_THROW(elem.get<Vector2f>(ThemeData::ThemeElement::getPropertyId("size")), std::out_of_range);
+	EXPECT_THROW(elem.get<std::string>("otherIcon"), std::out_of_range);
+}
+
+TEST_F(ThemeDataTest, PropertyLookupBenchmark)
+{
+	// What GuiComponent::applyTheme reads for each themed component : 7 properties, 4 of them set
+	static const char* names[] = { "pos", "size", "origin", "rotation", "rotationOrigin", "zIndex", "visible" };
+
+	ThemeData::ThemeElement elem;
+	elem.set("pos") = Vector2f(0.1f, 0.2f);
+	elem.set("size") = Vector2f(0.3f, 0.4f);
+	elem.set("zIndex") = 10.0f;
+	elem.set("visible") = true;
+	elem.set("text") = std::string("Some text");
+	elem.set("color") = 0xFFFFFFFFu;
+	elem.set("fontSize") = 0.03f;
+
+	// As the properties were stored before : every type at once, in a map by name
+	struct NamedProperty
+	{
+		Vector2f v;
+		std::string s;
+		unsigned int i;
+		float f;
+		bool b;
+		Vector4f r;
+	};
+
+	std::map<std::string, NamedProperty> map;
+	map["pos"].v = Vector2f(0.1f, 0.2f);
+	map["size"].v = Vector2f(0.3f, 0.4f);
+	map["zIndex"].f = 10.0f;
+	map["visible"].b = true;
+	map["text"].s = "Some text";
+	map["color"].i = 0xFFFFFFFF;
+	map["fontSize"].f = 0.03f;
+
+	int ids[7];
+	for (int i = 0; i < 7; i++)
+		ids[i] = ThemeData::ThemeElement::getPropertyId(names[i]);
+
+	const int rounds = 200000;
+	float sum[3] = { 0, 0, 0 };
+
+	auto measure = [](const std::function<void()>& lookup)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; r++)
+			lookup();
+
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / (rounds * 7);
+	};
+
+	long long byId = measure([&]
+	{
+		for (int i = 0; i < 7; i++)
+			if (elem.has(ids[i]))
+				sum[0] += (i == 6 ? (elem.get<bool>(ids[i]) ? 1.0f : 0.0f) : i == 5 ? elem.get<float>(ids[i]) : elem.get<Vector2f>(ids[i]).x());
+	});
+
+	long long byName = measure([&]
+	{
+		for (int i = 0; i < 7; i++)
+			if (elem.has(names[i]))
+				sum[1] += (i == 6 ? (elem.get<bool>(names[i]) ? 1.0f : 0.0f) : i == 5 ? elem.get<float>(names[i]) : elem.get<Vector2f>(names[i]).x());
+	});
+
+	long long inMap = measure([&]
+	{
+		for (int i = 0; i < 7; i++)
+		{
+			auto it = map.find(names[i]);
+			if (it != map.cend())
+				sum[2] += (i == 6 ? (it->second.b ? 1.0f : 0.0f) : i == 5 ? it->second.f : it->second.v.x());
+		}
+	});
+
+	EXPECT_EQ(sum[2], sum[0]);
+	EXPECT_EQ(sum[2], sum[1]);
+
+	RecordProperty("property_lookup_by_id_ns", std::to_string(byId));
+	RecordProperty("property_lookup_by_name_ns", std::to_string(byName));
+	RecordProperty("property_lookup_map_ns", std::to_string(inMap));
+
+	std::cout << "Theme property has() & get() : " << byId << " ns by id, " << byName << " ns by name, " << inMap << " ns in a map by name ( as before )" << std::endl;
+
+	EXPECT_LT(byId, inMap);
+}
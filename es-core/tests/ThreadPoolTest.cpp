@@ -0,0 +1,198 @@
+#include "utils/ThreadPool.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+// The work-stealing executor : groups waiting for their tasks, nested groups, what a task costs,
+// then how the pools stop & release their threads.
+
+namespace
+{
+	class ThreadPoolTest : public ::testing::Test
+	{
+	protected:
+		// Threads of the process, as counted by the kernel
+		static int threadCount()
+		{
+			std::ifstream status("/proc/self/status");
+
+			std::string line;
+			while (std::getline(status, line))
+				if (line.compare(0, 8, "Threads:") == 0)
+					return atoi(line.c_str() + 8);
+
+			return -1;
+		}
+
+		// Some work that the compiler can't remove
+		static unsigned int spin(unsigned int seed, int iterations)
+		{
+			for (int i = 0; i < iterations; i++)
+				seed = seed * 1664525 + 1013904223;
+
+			return seed;
+		}
+
+		// Tasks per second running count empty tasks in a group of the given pool
+		static double measureTasks(Utils::ThreadPool* pool, int count)
+		{
+			std::atomic<int> done(0);
+
+			auto start = std::chrono::steady_clock::now();
+
+			Utils::TaskGroup tasks(pool);
+			for (int i = 0; i < count; i++)
+				tasks.run([&done] { done++; });
+
+			tasks.wait();
+
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			EXPECT_EQ(count, done.load());
+
+			return count / seconds;
+		}
+	};
+}
+
+TEST_F(ThreadPoolTest, GroupsWaitForTheirTasks)
+{
+	Utils::ThreadPool pool(4);
+
+	std::atomic<int> done(0);
+	Utils::TaskGroup tasks(&pool);
+
+	for (int i = 0; i < 1000; i++)
+		tasks.run([&done] { done++; });
+
+	tasks.wait();
+	EXPECT_EQ(1000, done.load());
+	EXPECT_TRUE(tasks.isDone());
+}
+
+TEST_F(ThreadPoolTest, NestedGroupsDontDeadlock)
+{
+	// More nested waits than threads : the waiting tasks run the tasks of their own group
+	Utils::ThreadPool pool(2);
+
+	std::atomic<int> done(0);
+	Utils::TaskGroup outer(&pool);
+
+	for (int i = 0; i < 16; i++)
+	{
+		outer.run([&pool, &done]
+		{
+			Utils::TaskGroup inner(&pool);
+			for (int j = 0; j < 100; j++)
+				inner.run([&done] { done++; });
+
+			inner.wait();
+		});
+	}
+
+	outer.wait();
+	EXPECT_EQ(1600, done.load());
+}
+
+TEST_F(ThreadPoolTest, StoppingRunsTheQueuedTasks)
+{
+	int before = threadCount();
+
+	std::atomic<int> done(0);
+
+	Utils::ThreadPool* pool = new Utils::ThreadPool(2);
+	EXPECT_EQ(before + 2, threadCount());
+
+	Utils::TaskGroup tasks(pool);
+	for (int i = 0; i < 100; i++)
+		tasks.run([&done] { std::this_thread::sleep_for(std::chrono::microseconds(100)); done++; });
+
+	// Deleted while most tasks are still queued : their group is not left waiting forever
+	delete pool;
+
+	EXPECT_EQ(100, done.load());
+	EXPECT_TRUE(tasks.isDone());
+	EXPECT_EQ(before, threadCount());
+}
+
+TEST_F(ThreadPoolTest, TaskBenchmark)
+{
+	const int count = 200000;
+	const int workCount = 256;
+	const int workIterations = 2000000;
+
+	int threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	// Overhead of a task, on one worker & on all of them
+	Utils::ThreadPool single(1);
+	double singleRate = measureTasks(&single, count);
+
+	Utils::ThreadPool all(threads);
+	double allRate = measureTasks(&all, count);
+
+	// Scaling of work that is worth a task
+	auto measureWork = [=](Utils::ThreadPool* pool)
+	{
+		std::atomic<unsigned int> result(0);
+		int iterations = workIterations / workCount;
+
+		auto start = std::chrono::steady_clock::now();
+
+		Utils::TaskGroup tasks(pool);
+		for (int i = 0; i < workCount; i++)
+			tasks.run([i, iterations, &result] { result += spin(i, iterations); });
+
+		tasks.wait();
+
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	long long singleWork = measureWork(&single);
+	long long allWork = measureWork(&all);
+
+	RecordProperty("threads", std::to_string(threads));
+	RecordProperty("tasks_per_s_1_thread", std::to_string((long long)singleRate));
+	RecordProperty("tasks_per_s_all_threads", std::to_string((long long)allRate));
+	RecordProperty("work_1_thread_us", std::to_string(singleWork));
+	RecordProperty("work_all_threads_us", std::to_string(allWork));
+
+	std::cout << count << " empty tasks : " << (long long)singleRate << " tasks/s on 1 thread, " << (long long)allRate << " tasks/s on " << threads
+		<< " threads. " << workCount << " tasks of work : " << singleWork << " us on 1 thread, " << allWork << " us on " << threads << " threads" << std::endl;
+
+	EXPECT_GT(singleRate, 10000.0);
+	EXPECT_GT(allRate, 10000.0);
+}
+
+TEST_F(ThreadPoolTest, SharedPoolIsJoinedOnDeinit)
+{
+	// In a child process : the other tests keep the shared pool
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	EXPECT_EXIT(
+	{
+		Utils::ThreadPool* pool = Utils::ThreadPool::getInstance();
+
+		int poolThreads = pool->getThreadCount();
+		int before = threadCount();
+
+		std::atomic<int> done(0);
+		Utils::TaskGroup tasks;
+
+		for (int i = 0; i < 100; i++)
+			tasks.run([&done] { std::this_thread::sleep_for(std::chrono::microseconds(100)); done++; });
+
+		Utils::ThreadPool::deinit();
+
+		bool joined = done == 100 && threadCount() == before - poolThreads && Utils::ThreadPool::getInstance() == nullptr;
+
+		// From now on the tasks of the shared pool run on the calling thread
+		tasks.run([&done] { done++; });
+		tasks.wait();
+
+		exit(joined && done == 101 ? 0 : 1);
+	}, ::testing::ExitedWithCode(0), "");
+}
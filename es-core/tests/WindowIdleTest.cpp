@@ -0,0 +1,91 @@
+#include "renderers/Renderer.h"
+#include "Window.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+// Idle frame skipping, on the headless renderer : nothing changes on screen, so nothing must reach swapBuffers.
+
+namespace
+{
+	class WindowIdleTest : public ::testing::Test
+	{
+	protected:
+		// One iteration of the main loop, as in main.cpp with IdleFrameSkip on
+		void frame(bool hadEvent = false)
+		{
+			mWindow.update(16);
+
+			if (mWindow.needsRender(hadEvent))
+			{
+				mWindow.render();
+				Renderer::swapBuffers();
+			}
+			else
+				mWindow.skipFrame();
+		}
+
+		// Number of frames presented while running count frames
+		unsigned int run(int count)
+		{
+			unsigned int start = Renderer::getFrameCount();
+
+			for (int i = 0; i < count; i++)
+				frame();
+
+			return Renderer::getFrameCount() - start;
+		}
+
+		Window mWindow;
+	};
+}
+
+TEST_F(WindowIdleTest, IdleFramesAreNotSubmitted)
+{
+	// The first frames are rendered, then the screen stays as it is
+	run(5);
+
+	unsigned int skipped = mWindow.getSkippedFrames();
+
+	EXPECT_EQ(0u, run(50));
+	EXPECT_EQ(skipped + 50, mWindow.getSkippedFrames());
+}
+
+TEST_F(WindowIdleTest, InvalidateRendersUntilThingsStopMoving)
+{
+	run(5);
+
+	// A component changed : its frame, then one more to show where it ended
+	Window::invalidate();
+	EXPECT_EQ(2u, run(10));
+
+	// Something animating keeps invalidating every frame
+	unsigned int start = Renderer::getFrameCount();
+	for (int i = 0; i < 10; i++)
+	{
+		Window::invalidate();
+		frame();
+	}
+
+	EXPECT_EQ(10u, Renderer::getFrameCount() - start);
+	EXPECT_EQ(1u, run(10));
+}
+
+TEST_F(WindowIdleTest, InputIsRendered)
+{
+	run(5);
+
+	unsigned int start = Renderer::getFrameCount();
+	frame(true);
+	EXPECT_EQ(1u, Renderer::getFrameCount() - start);
+}
+
+TEST_F(WindowIdleTest, IdleScreenIsRefreshedOncePerSecond)
+{
+	run(5);
+	EXPECT_EQ(0u, run(5));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+	// The refresh, then the extra frame of the change
+	EXPECT_EQ(2u, run(10));
+}